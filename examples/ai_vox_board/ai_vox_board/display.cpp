@@ -46,10 +46,11 @@ Display::Display(esp_lcd_panel_io_handle_t panel_io,
           .border = LIGHT_BORDER_COLOR,
           .low_battery = LIGHT_LOW_BATTERY_COLOR,
       } {
-  // draw white
-  std::vector<uint16_t> buffer(width_, 0xFFFF);
-  for (int y = 0; y < height_; y++) {
-    esp_lcd_panel_draw_bitmap(panel, 0, y, width_, y + 1, buffer.data());
+  // draw white, 每次 20 行, 逐行绘制要 240 次 SPI 事务
+  constexpr int kFillRows = 20;
+  std::vector<uint16_t> buffer(width_ * kFillRows, 0xFFFF);
+  for (int y = 0; y < height_; y += kFillRows) {
+    esp_lcd_panel_draw_bitmap(panel, 0, y, width_, std::min(y + kFillRows, height_), buffer.data());
   }
 
   ESP_ERROR_CHECK(esp_lcd_panel_disp_on_off(panel, true));
@@ -57,6 +58,7 @@ Display::Display(esp_lcd_panel_io_handle_t panel_io,
 
   lvgl_port_cfg_t port_cfg = ESP_LVGL_PORT_INIT_CONFIG();
   port_cfg.task_priority = tskIDLE_PRIORITY;
+  port_cfg.task_affinity = 0;  // 与网络任务共用核心 0, 音频任务独占核心 1
   port_cfg.timer_period_ms = 50;
   lvgl_port_init(&port_cfg);
 
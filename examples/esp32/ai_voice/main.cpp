@@ -4,7 +4,7 @@
 #include "ai_vox_observer.h"
 #include "i2s_std_audio_input_device.h"
 #include "i2s_std_audio_output_device.h"
-#include "wifi.h"
+#include "wifi_station.h"
 
 #ifndef ARDUINO_ESP32_DEV
 #error "This example only supports ESP32-Dev board."
@@ -160,31 +160,51 @@ void PrintMemInfo() {
            min_free_size >> 10);
   }
 }
+
+void PrintTaskStats() {
+  for (const auto& stats : ai_vox::Engine::GetInstance().GetTaskStats()) {
+    printf("task %-16s cpu: %5.1f%%, stack: %" PRIu32 " B, minimum free stack: %" PRIu32 " B, queue depth: %zu, priority: %u\n",
+           stats.name.c_str(),
+           stats.cpu_percent,
+           stats.stack_size,
+           stats.stack_free_min,
+           stats.queue_depth,
+           stats.priority);
+  }
+}
+
+void PrintPowerStats() {
+  const auto stats = ai_vox::Engine::GetInstance().GetPowerStats();
+  printf("power enabled: %d, light sleep: %d, standby: %" PRIu32 " ms, active: %" PRIu32 " ms, wakeups: %" PRIu32 "\n",
+         stats.enabled,
+         stats.light_sleep,
+         stats.standby_ms,
+         stats.active_ms,
+         stats.wakeups);
+}
 #endif
 
 void WifiConnect() {
-  auto& wifi = Wifi::GetInstance();
-
   printf("Connecting to WiFi, ssid: %s, password: %s\n", WIFI_SSID, WIFI_PASSWORD);
-  wifi.Connect(WIFI_SSID, WIFI_PASSWORD);
-
-  uint32_t attempt_count = 0;
-  while (!wifi.IsConnected()) {
-    printf("Connecting to WiFi (attempt %" PRIu32 ")... ssid: %s\n", attempt_count++, WIFI_SSID);
-    delay(800);
-  }
-
-  printf("Wifi Connected. Getting IP...\n");
-  while (!wifi.IsGotIp()) {
-    delay(10);
-  }
-  printf("Got wifi info\n");
+  ai_vox::WifiStation::Config config;
+  config.ssid = WIFI_SSID;
+  config.password = WIFI_PASSWORD;
+  ai_vox::WifiStation::GetInstance().Connect(config);
+}
 
+void PrintWifiInfo() {
+  auto& wifi = ai_vox::WifiStation::GetInstance();
   const auto ip_info = wifi.ip_info();
+  const auto stats = wifi.stats();
   printf("IP Info:\n");
   printf("- ip: " IPSTR "\n", IP2STR(&ip_info.ip));
   printf("- mask: " IPSTR "\n", IP2STR(&ip_info.netmask));
   printf("- gw: " IPSTR "\n", IP2STR(&ip_info.gw));
+  printf("- connected in %" PRIu32 " ms, attempts: %" PRIu32 ", fast connect: %d, cached ip: %d\n",
+         stats.connect_ms,
+         stats.attempts,
+         stats.fast_connect,
+         stats.cached_ip);
 }
 }  // namespace
 
@@ -192,6 +212,7 @@ void setup() {
   Serial.begin(115200);
   printf("Init\n");
 
+  // 不等待连接完成, 引擎初始化与 Wi-Fi 连接并行, 引擎取得 IP 后再请求配置
   WifiConnect();
 
   pinMode(kLedPin, OUTPUT);
@@ -204,6 +225,11 @@ void setup() {
   auto& ai_vox_engine = ai_vox::Engine::GetInstance();
   ai_vox_engine.SetObserver(g_observer);
   ai_vox_engine.SetTrigger(kTriggerPin);
+  ai_vox_engine.ConfigPower({.enabled = true});  // 待命时降频并自动 light sleep, 按下触发按键唤醒
+#ifdef PRINT_HEAP_INFO_INTERVAL
+  ai_vox_engine.ConfigResourceMonitor(PRINT_HEAP_INFO_INTERVAL);
+  ai_vox_engine.ConfigLatencyReport(PRINT_HEAP_INFO_INTERVAL);
+#endif
   ai_vox_engine.SetOtaUrl("https://api.tenclass.net/xiaozhi/ota/");
   ai_vox_engine.ConfigWebsocket("wss://api.tenclass.net/xiaozhi/v1/",
                                 {
@@ -219,14 +245,21 @@ void loop() {
   if (s_print_heap_info_time == 0 || millis() - s_print_heap_info_time >= PRINT_HEAP_INFO_INTERVAL) {
     s_print_heap_info_time = millis();
     PrintMemInfo();
+    PrintTaskStats();
+    PrintPowerStats();
   }
 #endif
 
   const auto events = g_observer->PopEvents();
   for (auto& event : events) {
-    if (auto activation_event = std::get_if<ai_vox::Observer::ActivationEvent>(&event)) {
+    if (auto boot_event = std::get_if<ai_vox::Observer::BootEvent>(&event)) {
+      if (boot_event->phase == ai_vox::BootPhase::kNetworkReady) {
+        PrintWifiInfo();
+      }
+    } else if (auto activation_event = std::get_if<ai_vox::Observer::ActivationEvent>(&event)) {
       printf("activation code: %s, message: %s\n", activation_event->code.c_str(), activation_event->message.c_str());
     } else if (auto state_changed_event = std::get_if<ai_vox::Observer::StateChangedEvent>(&event)) {
+      ai_vox::WifiStation::GetInstance().OnChatStateChanged(state_changed_event->new_state);
       printf("state changed from %" PRIu8 " to %" PRIu8 "\n",
              static_cast<uint8_t>(state_changed_event->old_state),
              static_cast<uint8_t>(state_changed_event->new_state));
@@ -309,5 +342,6 @@ void loop() {
     }
   }
 
-  taskYIELD();
+  // taskYIELD 不会让给优先级更低的空闲任务, 主循环一直空转时待命也无法进入 light sleep
+  delay(50);
 }
\ No newline at end of file
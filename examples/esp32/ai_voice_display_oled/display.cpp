@@ -14,6 +14,7 @@ Display::Display(esp_lcd_panel_io_handle_t panel_io, esp_lcd_panel_handle_t pane
     : width_(width), height_(height) {
   lvgl_port_cfg_t port_cfg = ESP_LVGL_PORT_INIT_CONFIG();
   port_cfg.task_priority = tskIDLE_PRIORITY;
+  port_cfg.task_affinity = 0;  // 与网络任务共用核心 0, 音频任务独占核心 1
   lvgl_port_init(&port_cfg);
 
   const lvgl_port_display_cfg_t display_cfg = {
@@ -9,7 +9,7 @@
 #include "display.h"
 #include "i2s_std_audio_input_device.h"
 #include "i2s_std_audio_output_device.h"
-#include "wifi.h"
+#include "wifi_station.h"
 
 #ifndef ARDUINO_ESP32_DEV
 #error "This example only supports ESP32-Dev board."
@@ -232,28 +232,26 @@ void PrintMemInfo() {
 #endif
 
 void WifiConnect() {
-  auto& wifi = Wifi::GetInstance();
-
   printf("Connecting to WiFi, ssid: %s, password: %s\n", WIFI_SSID, WIFI_PASSWORD);
-  wifi.Connect(WIFI_SSID, WIFI_PASSWORD);
-
-  uint32_t attempt_count = 0;
-  while (!wifi.IsConnected()) {
-    printf("Connecting to WiFi (attempt %" PRIu32 ")... ssid: %s\n", attempt_count++, WIFI_SSID);
-    delay(800);
-  }
-
-  printf("Wifi Connected. Getting IP...\n");
-  while (!wifi.IsGotIp()) {
-    delay(10);
-  }
-  printf("Got wifi info\n");
+  ai_vox::WifiStation::Config config;
+  config.ssid = WIFI_SSID;
+  config.password = WIFI_PASSWORD;
+  ai_vox::WifiStation::GetInstance().Connect(config);
+}
 
+void PrintWifiInfo() {
+  auto& wifi = ai_vox::WifiStation::GetInstance();
   const auto ip_info = wifi.ip_info();
+  const auto stats = wifi.stats();
   printf("IP Info:\n");
   printf("- ip: " IPSTR "\n", IP2STR(&ip_info.ip));
   printf("- mask: " IPSTR "\n", IP2STR(&ip_info.netmask));
   printf("- gw: " IPSTR "\n", IP2STR(&ip_info.gw));
+  printf("- connected in %" PRIu32 " ms, attempts: %" PRIu32 ", fast connect: %d, cached ip: %d\n",
+         stats.connect_ms,
+         stats.attempts,
+         stats.fast_connect,
+         stats.cached_ip);
 }
 
 }  // namespace
@@ -264,9 +262,9 @@ void setup() {
 
   InitDisplay();
 
-  g_display->ShowStatus("Wifi connecting...");
+  // 不等待连接完成, 引擎初始化与 Wi-Fi 连接并行, 引擎取得 IP 后再请求配置
   WifiConnect();
-  g_display->ShowStatus("Wifi connected");
+  g_display->ShowStatus("Wifi connecting...");
 
   pinMode(kLedPin, OUTPUT);
   digitalWrite(kLedPin, LOW);
@@ -276,6 +274,7 @@ void setup() {
   auto& ai_vox_engine = ai_vox::Engine::GetInstance();
   ai_vox_engine.SetObserver(g_observer);
   ai_vox_engine.SetTrigger(kTriggerPin);
+  ai_vox_engine.SetSchedulingPolicy(ai_vox::SchedulingPolicy::AudioCorePinned());  // 音频固定在核心 1, 避免界面刷新导致卡顿
   ai_vox_engine.SetOtaUrl("https://api.tenclass.net/xiaozhi/ota/");
   ai_vox_engine.ConfigWebsocket("wss://api.tenclass.net/xiaozhi/v1/",
                                 {
@@ -297,11 +296,16 @@ void loop() {
 
   const auto events = g_observer->PopEvents();
   for (auto& event : events) {
-    if (auto activation_event = std::get_if<ai_vox::Observer::ActivationEvent>(&event)) {
+    if (auto boot_event = std::get_if<ai_vox::Observer::BootEvent>(&event)) {
+      if (boot_event->phase == ai_vox::BootPhase::kNetworkReady) {
+        PrintWifiInfo();
+      }
+    } else if (auto activation_event = std::get_if<ai_vox::Observer::ActivationEvent>(&event)) {
       printf("activation code: %s, message: %s\n", activation_event->code.c_str(), activation_event->message.c_str());
       g_display->ShowStatus((std::string("激活设备") + activation_event->code).c_str());
       g_display->SetChatMessage(activation_event->message);
     } else if (auto state_changed_event = std::get_if<ai_vox::Observer::StateChangedEvent>(&event)) {
+      ai_vox::WifiStation::GetInstance().OnChatStateChanged(state_changed_event->new_state);
       switch (state_changed_event->new_state) {
         case ai_vox::ChatState::kIdle: {
           printf("Idle\n");
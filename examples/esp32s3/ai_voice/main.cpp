@@ -1,10 +1,10 @@
 #include <Arduino.h>
-#include <WiFi.h>
 
 #include "ai_vox_engine.h"
 #include "ai_vox_observer.h"
 #include "i2s_std_audio_input_device.h"
 #include "i2s_std_audio_output_device.h"
+#include "wifi_station.h"
 
 #ifndef ARDUINO_ESP32S3_DEV
 #error "This example only supports ESP32S3-Dev board."
@@ -96,12 +96,14 @@ void InitIot() {
        "打开LED灯",  // function description
        {
            // no parameters
-       }},
+       },
+       {"da kai deng", "kai deng"}},  // offline phrases, pinyin for the Chinese MultiNet model
       {"TurnOff",    // function name
        "关闭LED灯",  // function description
        {
            // no parameters
-       }},
+       },
+       {"guan bi deng", "guan deng"}},  // offline phrases
       // add more functions as needed
   });
 
@@ -160,27 +162,50 @@ void PrintMemInfo() {
            min_free_size >> 10);
   }
 }
+
+void PrintTaskStats() {
+  for (const auto& stats : ai_vox::Engine::GetInstance().GetTaskStats()) {
+    printf("task %-16s cpu: %5.1f%%, stack: %" PRIu32 " B, minimum free stack: %" PRIu32 " B, queue depth: %zu, priority: %u\n",
+           stats.name.c_str(),
+           stats.cpu_percent,
+           stats.stack_size,
+           stats.stack_free_min,
+           stats.queue_depth,
+           stats.priority);
+  }
+}
 #endif
+
+void WifiConnect() {
+  printf("Connecting to WiFi, ssid: %s, password: %s\n", WIFI_SSID, WIFI_PASSWORD);
+  ai_vox::WifiStation::Config config;
+  config.ssid = WIFI_SSID;
+  config.password = WIFI_PASSWORD;
+  ai_vox::WifiStation::GetInstance().Connect(config);
+}
+
+void PrintWifiInfo() {
+  auto& wifi = ai_vox::WifiStation::GetInstance();
+  const auto ip_info = wifi.ip_info();
+  const auto stats = wifi.stats();
+  printf("IP Info:\n");
+  printf("- ip: " IPSTR "\n", IP2STR(&ip_info.ip));
+  printf("- mask: " IPSTR "\n", IP2STR(&ip_info.netmask));
+  printf("- gw: " IPSTR "\n", IP2STR(&ip_info.gw));
+  printf("- connected in %" PRIu32 " ms, attempts: %" PRIu32 ", fast connect: %d, cached ip: %d\n",
+         stats.connect_ms,
+         stats.attempts,
+         stats.fast_connect,
+         stats.cached_ip);
+}
 }  // namespace
 
 void setup() {
   Serial.begin(115200);
   printf("Init\n");
 
-  if (heap_caps_get_total_size(MALLOC_CAP_SPIRAM) > 0) {
-    WiFi.useStaticBuffers(true);
-  } else {
-    WiFi.useStaticBuffers(false);
-  }
-
-  printf("Connecting to WiFi, ssid: %s, password: %s\n", WIFI_SSID, WIFI_PASSWORD);
-  WiFi.begin(WIFI_SSID, WIFI_PASSWORD);
-  while (WiFi.status() != WL_CONNECTED) {
-    delay(1000);
-    printf("Connecting to WiFi, ssid: %s, password: %s\n", WIFI_SSID, WIFI_PASSWORD);
-  }
-
-  printf("WiFi connected, IP address: %s\n", WiFi.localIP().toString().c_str());
+  // 不等待连接完成, 引擎初始化与 Wi-Fi 连接并行, 引擎取得 IP 后再请求配置
+  WifiConnect();
 
   pinMode(kLedPin, OUTPUT);
   digitalWrite(kLedPin, LOW);
@@ -191,6 +216,18 @@ void setup() {
   auto& ai_vox_engine = ai_vox::Engine::GetInstance();
   ai_vox_engine.SetObserver(g_observer);
   ai_vox_engine.SetTrigger(kTriggerPin);
+#ifdef PRINT_HEAP_INFO_INTERVAL
+  ai_vox_engine.ConfigResourceMonitor(PRINT_HEAP_INFO_INTERVAL);
+  ai_vox_engine.ConfigLatencyReport(PRINT_HEAP_INFO_INTERVAL);
+#endif
+  // 提示音分区, 分区为空时不播放; 生成和烧录 (偏移见 partitions.csv 中的 earcon 一行):
+  //   build/earcon_pack/earcon_pack -o earcon.bin --size 0x40000 wake=wake.wav
+  //   esptool.py write_flash 0xB00000 earcon.bin
+  ai_vox_engine.ConfigEarcons("earcon");
+  // 唤醒后先在本地识别 LED 的命令词, 需要把 MultiNet 模型打包进模型分区, 见 tools/srmodels_to_partition.py
+  ai_vox::OfflineCommandConfig offline_command_config;
+  offline_command_config.enabled = true;
+  ai_vox_engine.ConfigOfflineCommands(offline_command_config);
   ai_vox_engine.SetOtaUrl("https://api.tenclass.net/xiaozhi/ota/");
   ai_vox_engine.ConfigWebsocket("wss://api.tenclass.net/xiaozhi/v1/",
                                 {
@@ -206,14 +243,20 @@ void loop() {
   if (s_print_heap_info_time == 0 || millis() - s_print_heap_info_time >= PRINT_HEAP_INFO_INTERVAL) {
     s_print_heap_info_time = millis();
     PrintMemInfo();
+    PrintTaskStats();
   }
 #endif
 
   const auto events = g_observer->PopEvents();
   for (auto& event : events) {
-    if (auto activation_event = std::get_if<ai_vox::Observer::ActivationEvent>(&event)) {
+    if (auto boot_event = std::get_if<ai_vox::Observer::BootEvent>(&event)) {
+      if (boot_event->phase == ai_vox::BootPhase::kNetworkReady) {
+        PrintWifiInfo();
+      }
+    } else if (auto activation_event = std::get_if<ai_vox::Observer::ActivationEvent>(&event)) {
       printf("activation code: %s, message: %s\n", activation_event->code.c_str(), activation_event->message.c_str());
     } else if (auto state_changed_event = std::get_if<ai_vox::Observer::StateChangedEvent>(&event)) {
+      ai_vox::WifiStation::GetInstance().OnChatStateChanged(state_changed_event->new_state);
       printf("state changed from %" PRIu8 " to %" PRIu8 "\n",
              static_cast<uint8_t>(state_changed_event->old_state),
              static_cast<uint8_t>(state_changed_event->new_state));
@@ -1,5 +1,4 @@
 #include <Arduino.h>
-#include <WiFi.h>
 #include <driver/spi_common.h>
 #include <esp_heap_caps.h>
 #include <esp_lcd_panel_io.h>
@@ -11,6 +10,7 @@
 #include "display.h"
 #include "i2s_std_audio_input_device.h"
 #include "i2s_std_audio_output_device.h"
+#include "wifi_station.h"
 
 #ifndef ARDUINO_ESP32S3_DEV
 #error "This example only supports ESP32S3-Dev board."
@@ -297,33 +297,41 @@ void PrintMemInfo() {
   }
 }
 #endif
+
+void WifiConnect() {
+  printf("Connecting to WiFi, ssid: %s, password: %s\n", WIFI_SSID, WIFI_PASSWORD);
+  ai_vox::WifiStation::Config config;
+  config.ssid = WIFI_SSID;
+  config.password = WIFI_PASSWORD;
+  ai_vox::WifiStation::GetInstance().Connect(config);
+}
+
+void PrintWifiInfo() {
+  auto& wifi = ai_vox::WifiStation::GetInstance();
+  const auto ip_info = wifi.ip_info();
+  const auto stats = wifi.stats();
+  printf("IP Info:\n");
+  printf("- ip: " IPSTR "\n", IP2STR(&ip_info.ip));
+  printf("- mask: " IPSTR "\n", IP2STR(&ip_info.netmask));
+  printf("- gw: " IPSTR "\n", IP2STR(&ip_info.gw));
+  printf("- connected in %" PRIu32 " ms, attempts: %" PRIu32 ", fast connect: %d, cached ip: %d\n",
+         stats.connect_ms,
+         stats.attempts,
+         stats.fast_connect,
+         stats.cached_ip);
+}
 }  // namespace
 
 void setup() {
   Serial.begin(115200);
   printf("Init\n");
 
-  InitDisplay();
+  // 不等待连接完成, 屏幕和引擎初始化与 Wi-Fi 连接并行, 引擎取得 IP 后再请求配置
+  WifiConnect();
 
+  InitDisplay();
   g_display->ShowStatus("Wifi connecting...");
 
-  if (heap_caps_get_total_size(MALLOC_CAP_SPIRAM) > 0) {
-    WiFi.useStaticBuffers(true);
-  } else {
-    WiFi.useStaticBuffers(false);
-  }
-
-  printf("Connecting to WiFi, ssid: %s, password: %s\n", WIFI_SSID, WIFI_PASSWORD);
-  WiFi.begin(WIFI_SSID, WIFI_PASSWORD);
-
-  while (WiFi.status() != WL_CONNECTED) {
-    delay(1000);
-    printf("Connecting to WiFi, ssid: %s, password: %s\n", WIFI_SSID, WIFI_PASSWORD);
-  }
-
-  printf("WiFi connected, IP address: %s\n", WiFi.localIP().toString().c_str());
-  g_display->ShowStatus("Wifi connected");
-
   pinMode(kLedPin, OUTPUT);
   digitalWrite(kLedPin, LOW);
   InitIot();
@@ -332,6 +340,8 @@ void setup() {
   auto& ai_vox_engine = ai_vox::Engine::GetInstance();
   ai_vox_engine.SetObserver(g_observer);
   ai_vox_engine.SetTrigger(kTriggerPin);
+  ai_vox_engine.SetSchedulingPolicy(ai_vox::SchedulingPolicy::AudioCorePinned());  // 音频固定在核心 1, 避免界面刷新导致卡顿
+  ai_vox_engine.SetPlacementPolicy(ai_vox::PlacementPolicy::SpiramPreferred());  // 数据包和收发缓冲区放到 PSRAM, 内部 RAM 留给 Wi-Fi 和 DMA
   ai_vox_engine.SetOtaUrl("https://api.tenclass.net/xiaozhi/ota/");
   ai_vox_engine.ConfigWebsocket("wss://api.tenclass.net/xiaozhi/v1/",
                                 {
@@ -352,11 +362,19 @@ void loop() {
 
   const auto events = g_observer->PopEvents();
   for (auto& event : events) {
-    if (auto activation_event = std::get_if<ai_vox::Observer::ActivationEvent>(&event)) {
+    if (auto boot_event = std::get_if<ai_vox::Observer::BootEvent>(&event)) {
+      printf("boot phase %u at %" PRIu32 " ms\n", static_cast<unsigned>(boot_event->phase), boot_event->time_ms);
+      if (boot_event->phase == ai_vox::BootPhase::kNetworkReady) {
+        PrintWifiInfo();
+      } else if (boot_event->phase == ai_vox::BootPhase::kReady) {
+        printf("cold boot to ready: %" PRIu32 " ms\n", boot_event->time_ms);
+      }
+    } else if (auto activation_event = std::get_if<ai_vox::Observer::ActivationEvent>(&event)) {
       printf("activation code: %s, message: %s\n", activation_event->code.c_str(), activation_event->message.c_str());
       g_display->ShowStatus("激活设备");
       g_display->SetChatMessage(Display::Role::kSystem, activation_event->message);
     } else if (auto state_changed_event = std::get_if<ai_vox::Observer::StateChangedEvent>(&event)) {
+      ai_vox::WifiStation::GetInstance().OnChatStateChanged(state_changed_event->new_state);
       switch (state_changed_event->new_state) {
         case ai_vox::ChatState::kIdle: {
           printf("Idle\n");
@@ -1,5 +1,4 @@
 #include <Arduino.h>
-#include <WiFi.h>
 #include <driver/i2c_master.h>
 #include <esp_lcd_io_i2c.h>
 #include <esp_lcd_panel_ops.h>
@@ -10,6 +9,7 @@
 #include "display.h"
 #include "i2s_std_audio_input_device.h"
 #include "i2s_std_audio_output_device.h"
+#include "wifi_station.h"
 
 #ifndef ARDUINO_ESP32S3_DEV
 #error "This example only supports ESP32S3-Dev board."
@@ -230,6 +230,29 @@ void PrintMemInfo() {
   }
 }
 #endif
+
+void WifiConnect() {
+  printf("Connecting to WiFi, ssid: %s, password: %s\n", WIFI_SSID, WIFI_PASSWORD);
+  ai_vox::WifiStation::Config config;
+  config.ssid = WIFI_SSID;
+  config.password = WIFI_PASSWORD;
+  ai_vox::WifiStation::GetInstance().Connect(config);
+}
+
+void PrintWifiInfo() {
+  auto& wifi = ai_vox::WifiStation::GetInstance();
+  const auto ip_info = wifi.ip_info();
+  const auto stats = wifi.stats();
+  printf("IP Info:\n");
+  printf("- ip: " IPSTR "\n", IP2STR(&ip_info.ip));
+  printf("- mask: " IPSTR "\n", IP2STR(&ip_info.netmask));
+  printf("- gw: " IPSTR "\n", IP2STR(&ip_info.gw));
+  printf("- connected in %" PRIu32 " ms, attempts: %" PRIu32 ", fast connect: %d, cached ip: %d\n",
+         stats.connect_ms,
+         stats.attempts,
+         stats.fast_connect,
+         stats.cached_ip);
+}
 }  // namespace
 
 void setup() {
@@ -238,23 +261,10 @@ void setup() {
 
   InitDisplay();
 
+  // 不等待连接完成, 引擎初始化与 Wi-Fi 连接并行, 引擎取得 IP 后再请求配置
+  WifiConnect();
   g_display->ShowStatus("Wifi connecting...");
 
-  if (heap_caps_get_total_size(MALLOC_CAP_SPIRAM) > 0) {
-    WiFi.useStaticBuffers(true);
-  } else {
-    WiFi.useStaticBuffers(false);
-  }
-
-  WiFi.begin(WIFI_SSID, WIFI_PASSWORD);
-  while (WiFi.status() != WL_CONNECTED) {
-    printf("Connecting to WiFi, ssid: %s, password: %s\n", WIFI_SSID, WIFI_PASSWORD);
-    delay(1000);
-  }
-
-  printf("WiFi connected, IP address: %s\n", WiFi.localIP().toString().c_str());
-  g_display->ShowStatus("Wifi connected");
-
   pinMode(kLedPin, OUTPUT);
   digitalWrite(kLedPin, LOW);
   InitIot();
@@ -263,6 +273,7 @@ void setup() {
   auto& ai_vox_engine = ai_vox::Engine::GetInstance();
   ai_vox_engine.SetObserver(g_observer);
   ai_vox_engine.SetTrigger(kTriggerPin);
+  ai_vox_engine.SetSchedulingPolicy(ai_vox::SchedulingPolicy::AudioCorePinned());  // 音频固定在核心 1, 避免界面刷新导致卡顿
   ai_vox_engine.SetOtaUrl("https://api.tenclass.net/xiaozhi/ota/");
   ai_vox_engine.ConfigWebsocket("wss://api.tenclass.net/xiaozhi/v1/",
                                 {
@@ -284,11 +295,16 @@ void loop() {
 
   const auto events = g_observer->PopEvents();
   for (auto& event : events) {
-    if (auto activation_event = std::get_if<ai_vox::Observer::ActivationEvent>(&event)) {
+    if (auto boot_event = std::get_if<ai_vox::Observer::BootEvent>(&event)) {
+      if (boot_event->phase == ai_vox::BootPhase::kNetworkReady) {
+        PrintWifiInfo();
+      }
+    } else if (auto activation_event = std::get_if<ai_vox::Observer::ActivationEvent>(&event)) {
       printf("activation code: %s, message: %s\n", activation_event->code.c_str(), activation_event->message.c_str());
       g_display->ShowStatus((std::string("激活设备") + activation_event->code).c_str());
       g_display->SetChatMessage(activation_event->message);
     } else if (auto state_changed_event = std::get_if<ai_vox::Observer::StateChangedEvent>(&event)) {
+      ai_vox::WifiStation::GetInstance().OnChatStateChanged(state_changed_event->new_state);
       switch (state_changed_event->new_state) {
         case ai_vox::ChatState::kIdle: {
           printf("Idle\n");
@@ -0,0 +1 @@
+-fno-exceptions -Wall -Werror -DCONFIG_ESP_WS_CLIENT_ENABLE_DYNAMIC_BUFFER
\ No newline at end of file
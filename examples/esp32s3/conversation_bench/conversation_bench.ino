@@ -0,0 +1,17 @@
+/*
+ * 本文件为空索引文件，请转到 main.cpp 查看主程序
+ * This is an empty index file, please refer to main.cpp for the main program
+ *
+ * 说明:
+ * Arduino IDE 默认会寻找与项目文件夹同名的 .ino 文件作为主入口。
+ * 为了让 Arduino IDE 正确编译项目，我们保留此空白文件作为项目入口索引。
+ * 实际程序逻辑请在 main.cpp 中查看和修改。
+ *
+ * Explanation:
+ * Arduino IDE requires a .ino file matching the project folder name as the entry point.
+ * We keep this blank file as an index to satisfy the IDE's compilation requirements.
+ * The actual program logic is located in main.cpp.
+ *
+ * 重要提示：请勿在此文件添加代码!
+ * Important: Do not add code in this file!
+ */
\ No newline at end of file
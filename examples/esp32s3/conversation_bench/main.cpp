@@ -0,0 +1,254 @@
+#include <Arduino.h>
+#include <esp_heap_caps.h>
+
+#include <vector>
+
+#include "ai_vox_engine.h"
+#include "ai_vox_observer.h"
+#include "null_audio_output_device.h"
+#include "replay_audio_input_device.h"
+#include "wifi_station.h"
+
+/*
+ * 端到端对话基准测试, 配合 tools/bench/bench_server.py 使用:
+ *   1. 在电脑上运行 python3 tools/bench/bench_server.py --port 8000 --output result.json
+ *   2. 编译时通过 -DBENCH_SERVER=\"<电脑 IP>:8000\" 指定服务器地址
+ *   3. 可选: 将 16 kHz 单声道 WAV 上传到 LittleFS 的 /speech.wav 作为麦克风输入
+ *   4. 可选: 以 -DAI_VOX_STATIC_ALLOCATION=1 编译, bench_server.py --check-steady-state 检查第一轮之后静态区不再切出新块
+ * 测试结束后串口输出一行以 BENCH_RESULT 开头的 JSON
+ */
+
+#ifndef WIFI_SSID
+#define WIFI_SSID "ssid"
+#endif
+
+#ifndef WIFI_PASSWORD
+#define WIFI_PASSWORD "password"
+#endif
+
+#ifndef BENCH_SERVER
+#define BENCH_SERVER "192.168.1.100:8000"
+#endif
+
+#ifndef BENCH_CONVERSATIONS
+#define BENCH_CONVERSATIONS (10)
+#endif
+
+namespace {
+constexpr uint32_t kSampleIntervalMs = 500;
+constexpr uint32_t kAbortDelayMs = 500;  // 每隔一轮在播放开始后打断, 测量 abort -> silence
+
+constexpr const char* kLatencyStageNames[] = {
+    "wake_to_connect",
+    "connect_to_hello",
+    "hello_to_listen",
+    "last_user_frame_to_stt",
+    "tts_start_to_first_pcm",
+    "abort_to_silence",
+    "encode",
+    "send",
+    "receive",
+    "decode",
+    "write",
+};
+static_assert(std::size(kLatencyStageNames) == static_cast<size_t>(ai_vox::LatencyStage::kMax));
+
+constexpr const char* kBootPhaseNames[] = {
+    "engine_start",
+    "models_loaded",
+    "websocket_ready",
+    "network_ready",
+    "config_fetched",
+    "ready",
+};
+
+struct Conversation {
+  uint32_t duration_ms = 0;
+  float cpu_ms = 0;
+  int32_t static_heap_carves = 0;  // 本轮从静态区切出新块的次数, 稳态下应为 0
+  int32_t heap_blocks = 0;         // 本轮结束时系统堆已分配块数的变化, 包含 Wi-Fi / lwip 缓冲区, 仅供参考
+};
+
+auto g_observer = std::make_shared<ai_vox::Observer>();
+auto g_audio_output_device = std::make_shared<NullAudioOutputDevice>();
+std::vector<Conversation> g_conversations;
+uint32_t g_conversation_start_time = 0;
+float g_conversation_cpu_ms = 0;
+uint32_t g_abort_time = 0;
+bool g_finished = false;
+uint32_t g_boot_ms[std::size(kBootPhaseNames)] = {};
+uint32_t g_static_heap_carves = 0;
+size_t g_heap_blocks = 0;
+
+size_t HeapBlocks() {
+  multi_heap_info_t info;
+  heap_caps_get_info(&info, MALLOC_CAP_DEFAULT);
+  return info.allocated_blocks;
+}
+
+// 每轮都在同一状态 (播放结束回到聆听) 采样, 两次采样之差即一轮对话的净分配
+void SampleHeap(Conversation& conversation) {
+  const auto static_heap_carves = ai_vox::heap::StaticStats().carves;
+  const auto heap_blocks = HeapBlocks();
+  conversation.static_heap_carves = static_heap_carves - g_static_heap_carves;
+  conversation.heap_blocks = static_cast<int32_t>(heap_blocks - g_heap_blocks);
+  g_static_heap_carves = static_heap_carves;
+  g_heap_blocks = heap_blocks;
+}
+
+void PrintResult() {
+  const auto latency_stats = ai_vox::Engine::GetInstance().GetLatencyStats();
+  printf("BENCH_RESULT {\"conversations\":[");
+  for (size_t i = 0; i < g_conversations.size(); i++) {
+    const auto& conversation = g_conversations[i];
+    printf("%s{\"duration_ms\":%" PRIu32 ",\"cpu_ms\":%.1f,\"static_heap_carves\":%" PRIi32 ",\"heap_blocks\":%" PRIi32 "}",
+           i == 0 ? "" : ",",
+           conversation.duration_ms,
+           conversation.cpu_ms,
+           conversation.static_heap_carves,
+           conversation.heap_blocks);
+  }
+  printf("],\"boot_ms\":{");
+  for (size_t i = 0; i < std::size(kBootPhaseNames); i++) {
+    printf("%s\"%s\":%" PRIu32, i == 0 ? "" : ",", kBootPhaseNames[i], g_boot_ms[i]);
+  }
+  const auto wifi_stats = ai_vox::WifiStation::GetInstance().stats();
+  printf("},\"wifi\":{\"connect_ms\":%" PRIu32 ",\"attempts\":%" PRIu32 ",\"fast_connect\":%s,\"cached_ip\":%s",
+         wifi_stats.connect_ms,
+         wifi_stats.attempts,
+         wifi_stats.fast_connect ? "true" : "false",
+         wifi_stats.cached_ip ? "true" : "false");
+  printf("},\"latency\":{");
+  for (size_t i = 0; i < latency_stats.size(); i++) {
+    const auto& histogram = latency_stats[i];
+    printf("%s\"%s\":{\"count\":%" PRIu32 ",\"min_us\":%" PRIu32 ",\"avg_us\":%" PRIu64 ",\"p50_us\":%" PRIu32 ",\"p90_us\":%" PRIu32
+           ",\"p99_us\":%" PRIu32 ",\"max_us\":%" PRIu32 "}",
+           i == 0 ? "" : ",",
+           kLatencyStageNames[i],
+           histogram.count,
+           histogram.min_us,
+           histogram.count > 0 ? histogram.sum_us / histogram.count : 0,
+           histogram.PercentileUs(50),
+           histogram.PercentileUs(90),
+           histogram.PercentileUs(99),
+           histogram.max_us);
+  }
+  const auto static_heap_stats = ai_vox::heap::StaticStats();
+  printf("},\"samples_played\":%" PRIu64 ",\"min_free_heap\":%" PRIu32 ",\"static_heap\":{\"size\":%zu,\"carved\":%zu,\"failures\":%" PRIu32 "}}\n",
+         g_audio_output_device->samples_written(),
+         esp_get_minimum_free_heap_size(),
+         static_heap_stats.size,
+         static_heap_stats.carved,
+         static_heap_stats.failures);
+}
+
+void SampleCpu() {
+  static uint32_t s_sample_time = 0;
+  if (millis() - s_sample_time < kSampleIntervalMs) {
+    return;
+  }
+  s_sample_time = millis();
+
+  for (const auto& task_stats : ai_vox::Engine::GetInstance().GetTaskStats()) {
+    if (task_stats.cpu_percent > 0) {
+      g_conversation_cpu_ms += task_stats.cpu_percent / 100.0f * kSampleIntervalMs;
+    }
+  }
+}
+}  // namespace
+
+void setup() {
+  Serial.begin(115200);
+  printf("Init\n");
+
+  // 引擎在 Wi-Fi 连接期间加载模型, 取得 IP 后再请求配置, boot_ms 记录各阶段自上电起的时间
+  // 第二次上电起使用 NVS 中缓存的 BSSID 和信道, 可对比两次结果中的 wifi.connect_ms
+  printf("Connecting to WiFi, ssid: %s, password: %s\n", WIFI_SSID, WIFI_PASSWORD);
+  ai_vox::WifiStation::Config wifi_config;
+  wifi_config.ssid = WIFI_SSID;
+  wifi_config.password = WIFI_PASSWORD;
+  ai_vox::WifiStation::GetInstance().Connect(wifi_config);
+
+  auto& ai_vox_engine = ai_vox::Engine::GetInstance();
+  ai_vox_engine.SetObserver(g_observer);
+  ai_vox_engine.SetSchedulingPolicy(ai_vox::SchedulingPolicy::AudioCorePinned());
+  ai_vox_engine.ConfigResourceMonitor(kSampleIntervalMs);
+  ai_vox_engine.ConfigVad({.enabled = true});
+  ai_vox_engine.SetOtaUrl("http://" BENCH_SERVER "/xiaozhi/ota/");
+  ai_vox_engine.ConfigWebsocket("ws://" BENCH_SERVER "/xiaozhi/v1/",
+                                {
+                                    {"Authorization", "Bearer bench"},
+                                });
+  ai_vox_engine.Start(std::make_shared<ReplayAudioInputDevice>("/speech.wav"), g_audio_output_device);
+  g_static_heap_carves = ai_vox::heap::StaticStats().carves;
+  g_heap_blocks = HeapBlocks();
+  printf("AI Vox engine started, bench server: %s, conversations: %d\n", BENCH_SERVER, BENCH_CONVERSATIONS);
+}
+
+void loop() {
+  auto& ai_vox_engine = ai_vox::Engine::GetInstance();
+  SampleCpu();
+
+  if (g_abort_time != 0 && millis() - g_abort_time >= kAbortDelayMs) {
+    g_abort_time = 0;
+    ai_vox_engine.Trigger();
+  }
+
+  const auto events = g_observer->PopEvents();
+  for (auto& event : events) {
+    if (auto boot_event = std::get_if<ai_vox::Observer::BootEvent>(&event)) {
+      if (static_cast<size_t>(boot_event->phase) < std::size(g_boot_ms)) {
+        g_boot_ms[static_cast<size_t>(boot_event->phase)] = boot_event->time_ms;
+      }
+      continue;
+    }
+
+    auto state_changed_event = std::get_if<ai_vox::Observer::StateChangedEvent>(&event);
+    if (state_changed_event == nullptr) {
+      continue;
+    }
+
+    ai_vox::WifiStation::GetInstance().OnChatStateChanged(state_changed_event->new_state);
+
+    switch (state_changed_event->new_state) {
+      case ai_vox::ChatState::kStandby: {
+        if (g_conversations.size() < BENCH_CONVERSATIONS) {
+          g_conversation_start_time = millis();
+          g_conversation_cpu_ms = 0;
+          ai_vox_engine.Trigger();
+        } else if (!g_finished) {
+          g_finished = true;
+          PrintResult();
+        }
+        break;
+      }
+      case ai_vox::ChatState::kSpeaking: {
+        if (g_conversations.size() % 2 == 1) {
+          g_abort_time = millis();
+        }
+        break;
+      }
+      case ai_vox::ChatState::kListening: {
+        if (state_changed_event->old_state != ai_vox::ChatState::kSpeaking) {
+          break;
+        }
+
+        g_abort_time = 0;
+        g_conversations.push_back({static_cast<uint32_t>(millis() - g_conversation_start_time), g_conversation_cpu_ms});
+        SampleHeap(g_conversations.back());
+        printf("conversation %zu done in %" PRIu32 " ms\n", g_conversations.size(), g_conversations.back().duration_ms);
+        g_conversation_start_time = millis();
+        g_conversation_cpu_ms = 0;
+        if (g_conversations.size() >= BENCH_CONVERSATIONS) {
+          ai_vox_engine.Trigger();  // 聆听状态下触发即断开连接
+        }
+        break;
+      }
+      default: {
+        break;
+      }
+    }
+  }
+
+  taskYIELD();
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#ifndef _NULL_AUDIO_OUTPUT_DEVICE_H_
+#define _NULL_AUDIO_OUTPUT_DEVICE_H_
+
+#include <Arduino.h>
+#include <esp_timer.h>
+
+#include <atomic>
+
+#include "audio_output_device.h"
+
+// 丢弃所有 PCM 数据, 只按采样率模拟 DAC 的阻塞写入并统计样本数
+class NullAudioOutputDevice : public ai_vox::AudioOutputDevice {
+ public:
+  bool Open(uint32_t sample_rate) override {
+    sample_rate_ = sample_rate;
+    next_write_time_ = esp_timer_get_time();
+    return true;
+  }
+
+  void Close() override {
+  }
+
+  size_t Write(int16_t* pcm, size_t samples) override {
+    next_write_time_ += static_cast<int64_t>(samples) * 1000000 / sample_rate_;
+    const int64_t wait_us = next_write_time_ - esp_timer_get_time();
+    if (wait_us > 0) {
+      vTaskDelay(pdMS_TO_TICKS(wait_us / 1000));
+    } else {
+      next_write_time_ = esp_timer_get_time();
+    }
+    samples_written_ += samples;
+    return samples;
+  }
+
+  void SetVolume(uint16_t volume) override {
+    volume_ = volume;
+  }
+
+  uint16_t volume() const override {
+    return volume_;
+  }
+
+  uint64_t samples_written() const {
+    return samples_written_;
+  }
+
+ private:
+  uint32_t sample_rate_ = 24000;
+  int64_t next_write_time_ = 0;
+  std::atomic<uint64_t> samples_written_ = 0;
+  uint16_t volume_ = 70;
+};
+
+#endif
@@ -0,0 +1,113 @@
+#pragma once
+
+#ifndef _REPLAY_AUDIO_INPUT_DEVICE_H_
+#define _REPLAY_AUDIO_INPUT_DEVICE_H_
+
+#include <Arduino.h>
+#include <esp_timer.h>
+#include <LittleFS.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+#include "audio_input_device.h"
+
+// 回放 LittleFS 中的 16 kHz 单声道 16 bit WAV 文件模拟麦克风, 每次 Open 从头开始, 放完后输出静音
+// 文件不存在时合成一段 1.5 秒的调幅音作为语音
+class ReplayAudioInputDevice : public ai_vox::AudioInputDevice {
+ public:
+  static constexpr uint32_t kSampleRate = 16000;
+
+  explicit ReplayAudioInputDevice(const char* path) {
+    if (LittleFS.begin(false)) {
+      LoadWav(path);
+    }
+
+    if (pcm_.empty()) {
+      printf("%s not found, using synthesized speech\n", path);
+      pcm_.resize(kSampleRate * 3 / 2);
+      for (size_t i = 0; i < pcm_.size(); i++) {
+        const float t = static_cast<float>(i) / kSampleRate;
+        const float envelope = 0.5f * (1.0f - cosf(2.0f * M_PI * 4.0f * t));
+        pcm_[i] = static_cast<int16_t>(8000.0f * envelope * sinf(2.0f * M_PI * 220.0f * t));
+      }
+    }
+  }
+
+  bool Open(uint32_t sample_rate) override {
+    position_ = 0;
+    next_read_time_ = esp_timer_get_time();
+    return sample_rate == kSampleRate;
+  }
+
+  void Close() override {
+  }
+
+  size_t Read(int16_t* buffer, uint32_t samples) override {
+    // 按实时速率返回数据, 与 I2S 阻塞读的节奏一致
+    next_read_time_ += static_cast<int64_t>(samples) * 1000000 / kSampleRate;
+    const int64_t wait_us = next_read_time_ - esp_timer_get_time();
+    if (wait_us > 0) {
+      vTaskDelay(pdMS_TO_TICKS(wait_us / 1000));
+    } else {
+      next_read_time_ = esp_timer_get_time();
+    }
+
+    const size_t available = position_ < pcm_.size() ? std::min<size_t>(pcm_.size() - position_, samples) : 0;
+    memcpy(buffer, pcm_.data() + position_, available * sizeof(int16_t));
+    memset(buffer + available, 0, (samples - available) * sizeof(int16_t));
+    position_ += available;
+    return samples;
+  }
+
+ private:
+  void LoadWav(const char* path) {
+    auto file = LittleFS.open(path, "r");
+    if (!file) {
+      return;
+    }
+
+    // 只支持 PCM 16 bit 单声道, 跳过 data 之前的所有块
+    char riff[12];
+    if (file.read(reinterpret_cast<uint8_t*>(riff), sizeof(riff)) != sizeof(riff) || memcmp(riff, "RIFF", 4) != 0 || memcmp(riff + 8, "WAVE", 4) != 0) {
+      return;
+    }
+
+    while (file.available()) {
+      char id[4];
+      uint32_t size = 0;
+      if (file.read(reinterpret_cast<uint8_t*>(id), sizeof(id)) != sizeof(id) ||
+          file.read(reinterpret_cast<uint8_t*>(&size), sizeof(size)) != sizeof(size)) {
+        return;
+      }
+
+      if (memcmp(id, "fmt ", 4) == 0) {
+        uint8_t fmt[16] = {0};
+        file.read(fmt, std::min<uint32_t>(size, sizeof(fmt)));
+        file.seek(file.position() + size - std::min<uint32_t>(size, sizeof(fmt)));
+        const uint16_t channels = fmt[2] | fmt[3] << 8;
+        const uint32_t sample_rate = fmt[4] | fmt[5] << 8 | fmt[6] << 16 | fmt[7] << 24;
+        const uint16_t bits = fmt[14] | fmt[15] << 8;
+        if (channels != 1 || sample_rate != kSampleRate || bits != 16) {
+          printf("unsupported wav: %u channels, %" PRIu32 " Hz, %u bits\n", channels, sample_rate, bits);
+          return;
+        }
+      } else if (memcmp(id, "data", 4) == 0) {
+        pcm_.resize(size / sizeof(int16_t));
+        file.read(reinterpret_cast<uint8_t*>(pcm_.data()), pcm_.size() * sizeof(int16_t));
+        printf("loaded %s, %zu samples\n", path, pcm_.size());
+        return;
+      } else {
+        file.seek(file.position() + size + (size & 1));
+      }
+    }
+  }
+
+  std::vector<int16_t> pcm_;
+  size_t position_ = 0;
+  int64_t next_read_time_ = 0;
+};
+
+#endif
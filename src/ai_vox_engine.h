@@ -4,12 +4,17 @@
 #define _AI_VOX_ENGINE_H_
 
 #include <driver/gpio.h>
+#include <freertos/FreeRTOS.h>
 
+#include <array>
 #include <functional>
+#include <iterator>
 #include <memory>
 #include <optional>
 #include <string>
+#include <vector>
 
+#include "ai_vox_heap.h"
 #include "ai_vox_observer.h"
 #include "audio_input_device.h"
 #include "audio_output_device.h"
@@ -17,6 +22,202 @@
 
 namespace ai_vox {
 
+struct VadConfig {
+  bool enabled = false;        // 本地语音端点检测, 静音期间不编码上传, 说话结束后主动发送 listen stop
+  uint32_t hangover_ms = 800;  // 语音结束后保持的静音时长
+  uint32_t threshold_db = 12;  // 高于噪声底多少 dB 判定为语音
+};
+
+struct EncoderConfig {
+  enum class Mode : uint8_t {
+    kDefault,   // 由 libopus 选择编码模式, 有 PSRAM 时复杂度 5, 否则复杂度 0 且码率 8 kbps
+    // 固定 SILK 语音模式和编码带宽, 复杂度 0, 用于无 PSRAM 的 ESP32 等采集容易溢出的场景
+    // 固定模式使用 opus_private.h 中的私有请求 OPUS_SET_FORCE_MODE, 不属于公开 API, 升级 libopus 时需要确认其编号和行为未变
+    kLowPower,
+  };
+
+  enum class Bandwidth : uint8_t {
+    kNarrowband,  // 4 kHz, SILK 运算量约为宽带的 60%, 但明显降低服务端语音识别的准确率, 须显式选择
+    kMediumband,  // 6 kHz
+    kWideband,    // 8 kHz, 16 kHz 采样下 libopus 默认即为 SILK 宽带, 省下的是复杂度 0 和 CELT/混合模式的运算量
+  };
+
+  Mode mode = Mode::kDefault;
+  Bandwidth bandwidth = Bandwidth::kWideband;  // 仅 kLowPower 模式使用
+};
+
+struct OfflineCommandConfig {
+  bool enabled = false;       // 仅 ESP32-S3, 需要模型分区中有 MultiNet 模型; 唤醒后先在本地识别 IoT 命令, 命中则不再请求服务端
+  float threshold = 0.6f;     // MultiNet 置信度下限, 低于此值交给服务端
+  uint32_t window_ms = 3000;  // 唤醒后等待命令的时长, 期间照常连接并上传, 命中时断开连接结束本轮对话
+};
+
+struct TaskConfig {
+  UBaseType_t priority;
+  BaseType_t core_id;  // tskNO_AFFINITY 表示不绑定核心
+};
+
+struct SchedulingPolicy {
+  TaskConfig main;
+  TaskConfig audio_input;   // 采集 + Opus 编码
+  TaskConfig audio_output;  // Opus 解码 + 播放
+  TaskConfig transmit;
+  TaskConfig websocket;
+  TaskConfig wake_net_feed;
+  TaskConfig wake_net_detect;
+
+  // 不绑定核心, 与以往的优先级一致
+  static constexpr SchedulingPolicy Default() {
+    return {
+        .main = {tskIDLE_PRIORITY + 1, tskNO_AFFINITY},
+        .audio_input = {tskIDLE_PRIORITY + 1, tskNO_AFFINITY},
+        .audio_output = {tskIDLE_PRIORITY + 1, tskNO_AFFINITY},
+        .transmit = {tskIDLE_PRIORITY + 2, tskNO_AFFINITY},
+        .websocket = {tskIDLE_PRIORITY, tskNO_AFFINITY},
+        .wake_net_feed = {tskIDLE_PRIORITY + 1, tskNO_AFFINITY},
+        .wake_net_detect = {tskIDLE_PRIORITY + 1, tskNO_AFFINITY},
+    };
+  }
+
+  // 双核: 音频采集/编解码/唤醒词固定在核心 1, 网络与主任务固定在 Wi-Fi 所在的核心 0, 界面任务应同样绑定核心 0
+  static constexpr SchedulingPolicy AudioCorePinned() {
+    return {
+        .main = {tskIDLE_PRIORITY + 1, 0},
+        .audio_input = {tskIDLE_PRIORITY + 3, 1},
+        .audio_output = {tskIDLE_PRIORITY + 3, 1},
+        .transmit = {tskIDLE_PRIORITY + 2, 0},
+        .websocket = {tskIDLE_PRIORITY + 5, 0},
+        .wake_net_feed = {tskIDLE_PRIORITY + 2, 1},
+        .wake_net_detect = {tskIDLE_PRIORITY + 1, 1},
+    };
+  }
+};
+
+// 各组件的内存放在内部 RAM 还是 PSRAM, PSRAM 不足时自动退回默认位置
+// 任务栈放到 PSRAM 需要开启 CONFIG_SPIRAM_ALLOW_STACK_EXTERNAL_MEMORY, 否则仍在内部 RAM; websocket 任务运行 TLS, 栈始终在内部 RAM
+struct PlacementPolicy {
+  MemoryRegion main_stack;
+  MemoryRegion audio_input_stack;
+  MemoryRegion audio_output_stack;
+  MemoryRegion transmit_stack;
+  MemoryRegion wake_net_stack;     // feed / detect
+  MemoryRegion codec;              // Opus 编解码器状态, 每帧都要访问
+  MemoryRegion uplink_packets;     // 编码后等待发送的音频帧
+  MemoryRegion downlink_packets;   // 收到后等待解码的音频帧
+  MemoryRegion json;               // 收到的 JSON 消息
+  MemoryRegion websocket_buffers;  // websocket 客户端收发缓冲区
+
+  // 全部由 heap_caps 决定, 与以往一致
+  static constexpr PlacementPolicy Default() {
+    return {
+        .main_stack = MemoryRegion::kDefault,
+        .audio_input_stack = MemoryRegion::kDefault,
+        .audio_output_stack = MemoryRegion::kDefault,
+        .transmit_stack = MemoryRegion::kDefault,
+        .wake_net_stack = MemoryRegion::kDefault,
+        .codec = MemoryRegion::kDefault,
+        .uplink_packets = MemoryRegion::kDefault,
+        .downlink_packets = MemoryRegion::kDefault,
+        .json = MemoryRegion::kDefault,
+        .websocket_buffers = MemoryRegion::kDefault,
+    };
+  }
+
+  // ESP32-S3 + PSRAM: 只访问一次的数据包, JSON, 收发缓冲区和不做运算的主任务/发送任务栈放到 PSRAM
+  // 编解码器状态和音频/唤醒词任务栈每帧都要访问, 留在内部 RAM; 主任务和发送任务不写 flash, 栈可以放在 PSRAM
+  static constexpr PlacementPolicy SpiramPreferred() {
+    return {
+        .main_stack = MemoryRegion::kSpiram,
+        .audio_input_stack = MemoryRegion::kInternal,
+        .audio_output_stack = MemoryRegion::kInternal,
+        .transmit_stack = MemoryRegion::kSpiram,
+        .wake_net_stack = MemoryRegion::kInternal,
+        .codec = MemoryRegion::kInternal,
+        .uplink_packets = MemoryRegion::kSpiram,
+        .downlink_packets = MemoryRegion::kSpiram,
+        .json = MemoryRegion::kSpiram,
+        .websocket_buffers = MemoryRegion::kSpiram,
+    };
+  }
+};
+
+// 待命时由 esp_pm 动态调频并在空闲时自动 light sleep, 触发按键的 GPIO 作为唤醒源; 连接, 聆听和说话期间持有 PM 锁保持最高频率
+// 需要 CONFIG_PM_ENABLE, light sleep 还需要 CONFIG_FREERTOS_USE_TICKLESS_IDLE 和 Wi-Fi 省电模式 (见 WifiStation::OnChatStateChanged)
+// ESP32-S3 待命时 WakeNet 持续处理麦克风音频, 仍保持最高频率, 只有按键唤醒的待命才会降频和睡眠
+struct PowerConfig {
+  bool enabled = false;
+  uint32_t max_freq_mhz = 240;
+  uint32_t min_freq_mhz = 40;  // 不能低于晶振频率
+  bool light_sleep = true;     // 不支持时只调频
+};
+
+struct PowerStats {
+  bool enabled;         // esp_pm 配置成功
+  bool light_sleep;     // 已开启自动 light sleep
+  uint32_t standby_ms;  // 累计释放 PM 锁的时长, 期间可以降频和睡眠
+  uint32_t active_ms;   // 累计持有 PM 锁的时长
+  uint32_t wakeups;     // 从低功耗待命回到全速的次数
+};
+
+struct TaskStats {
+  std::string name;
+  float cpu_percent;        // 上一采样周期内的占用, 100 表示占满一个核心
+  uint32_t stack_size;      // 字节, 未知时为 0
+  uint32_t stack_free_min;  // 字节, 栈剩余的历史最小值
+  size_t queue_depth;       // TaskQueue 中待执行的任务数
+  UBaseType_t priority;
+};
+
+struct WakeNetStats {
+  bool running;           // 是否正在检测唤醒词, 对话期间暂停
+  uint32_t detections;    // 累计唤醒次数
+  float last_volume_db;   // 最近一次唤醒时的音量; esp-sr AFE 不输出检测概率, 以此衡量唤醒的可信程度
+  uint32_t last_word_ms;  // 最近一次唤醒词的时长
+  float cpu_percent;      // 检测期间 feed / detect 任务的平均 CPU 占用, 需要开启 configGENERATE_RUN_TIME_STATS
+};
+
+enum class LatencyStage : uint8_t {
+  kWakeToConnect,       // 唤醒/按键 -> websocket 连接成功
+  kConnectToHello,      // 连接成功 -> 收到服务端 hello
+  kHelloToListen,       // 收到 hello -> 开始聆听
+  kLastUserFrameToStt,  // 本地 VAD 判定说话结束发送 listen stop -> 收到 stt, 需启用 VAD
+  kTtsStartToFirstPcm,  // 收到 tts start -> 第一帧 PCM 写入 DAC
+  kAbortToSilence,      // 发送 abort -> 播放停止
+  kEncode,              // 单帧 Opus 编码
+  kSend,                // 单帧 websocket 发送
+  kReceive,             // websocket 收到数据 -> 主任务开始处理
+  kDecode,              // 单帧 Opus 解码
+  kWrite,               // 单帧写入音频输出设备
+  kMax,
+};
+
+struct LatencyHistogram {
+  static constexpr uint32_t kBucketBoundsUs[] = {
+      500, 1000, 2000, 5000, 10000, 20000, 50000, 100000, 200000, 500000, 1000000, 2000000, 5000000, 10000000};
+  static constexpr size_t kBucketCount = std::size(kBucketBoundsUs) + 1;  // 最后一个桶为超过 10 s 的样本
+
+  std::array<uint32_t, kBucketCount> buckets;
+  uint32_t count;
+  uint32_t min_us;
+  uint32_t max_us;
+  uint64_t sum_us;
+
+  // 按桶上界估算百分位数, percent 取值 0 ~ 100
+  uint32_t PercentileUs(const uint32_t percent) const {
+    const uint64_t target = (static_cast<uint64_t>(count) * percent + 99) / 100;
+    uint64_t accumulated = 0;
+    for (size_t i = 0; i < kBucketCount; i++) {
+      accumulated += buckets[i];
+      if (accumulated >= target && accumulated > 0) {
+        return i < std::size(kBucketBoundsUs) ? kBucketBoundsUs[i] : max_us;
+      }
+    }
+    return 0;
+  }
+};
+
+using LatencyStats = std::array<LatencyHistogram, static_cast<size_t>(LatencyStage::kMax)>;
+
 class Engine {
  public:
   static Engine& GetInstance();
@@ -27,7 +228,35 @@ class Engine {
   virtual void SetOtaUrl(const std::string url) = 0;
   virtual void ConfigWebsocket(const std::string url, const std::map<std::string, std::string> headers) = 0;
   virtual void RegisterIotEntity(std::shared_ptr<iot::Entity> entity) = 0;
+  virtual void ConfigVad(const VadConfig& config) = 0;
+  virtual void ConfigEncoder(const EncoderConfig& config) = 0;
+  virtual void SetSchedulingPolicy(const SchedulingPolicy& policy) = 0;
+  virtual void SetPlacementPolicy(const PlacementPolicy& policy) = 0;
+  virtual void ConfigResourceMonitor(const uint32_t interval_ms) = 0;
+  virtual void ConfigLatencyReport(const uint32_t interval_ms) = 0;
+  // 提示音分区的标签, 分区由 tools/earcon_pack 生成; 按键或唤醒词开始对话时立即播放其中名为 "wake" 的片段
+  virtual void ConfigEarcons(const std::string& partition_label) = 0;
+  // 命令词来自已注册实体中无参数的函数, 见 iot::Function::offline_phrases; 命中后以 IotMessageEvent 通知 Observer
+  virtual void ConfigOfflineCommands(const OfflineCommandConfig& config) = 0;
+  // 超出预算时不 abort 而是降级: kAudioInput 改用复杂度 0 的编码器和较小的任务栈, kAudioOutput 缩短待播放队列
+  virtual void ConfigHeapBudget(const HeapTag tag, const size_t bytes) = 0;
+  virtual void ConfigPower(const PowerConfig& config) = 0;
   virtual void Start(std::shared_ptr<AudioInputDevice> audio_input_device, std::shared_ptr<AudioOutputDevice> audio_output_device) = 0;
+  // 停止并释放全部任务, 音频, 网络和模型内存, 回到调用 Start 之前的状态, 配置保留, 可以再次 Start
+  virtual void Stop() = 0;
+  // 阻塞到编解码器, websocket 客户端, 唤醒词模型和各任务栈释放完毕, 期间不响应按键和唤醒词, 用于把内存让给摄像头, OTA, 蓝牙配网等功能
+  virtual void Suspend() = 0;
+  // 异步重建上述资源并回到待机, 挂起前已获取的服务端配置不再重新请求
+  virtual void Resume() = 0;
+  virtual void Trigger() = 0;  // 与按下触发按键效果相同
+  virtual void PlayEarcon(const std::string& name) = 0;  // 播放提示音分区中的片段, 不依赖网络
+  virtual std::vector<TaskStats> GetTaskStats() const = 0;
+  virtual LatencyStats GetLatencyStats() const = 0;
+  virtual HeapStats GetHeapStats() const = 0;
+  virtual WakeNetStats GetWakeNetStats() const = 0;  // 仅 ESP32-S3, 其它芯片返回全 0
+  // 芯片无法测量电流: 用电流表测得一段时间的平均电流后, 按 standby_ms 与 active_ms 的占比区分待命和对话的功耗
+  virtual PowerStats GetPowerStats() const = 0;
+  virtual void DumpTrace() = 0;
 
  private:
   Engine(const Engine&) = delete;
@@ -0,0 +1,82 @@
+#pragma once
+
+#ifndef _AI_VOX_HEAP_H_
+#define _AI_VOX_HEAP_H_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+// 为 1 时 Malloc 只从大小为 AI_VOX_STATIC_HEAP_SIZE 的静态区分配, 不再调用 heap_caps_malloc, MemoryRegion 被忽略
+// 释放的块按大小分级挂回空闲链表, 第一轮对话之后每帧的音频包, 任务闭包, 编解码器状态和任务栈都复用已切出的块, 不会产生碎片
+// 引擎自己收发的 JSON 消息在栈上或收到的数据上读写, 不经过 cJSON 也不分配; 以下仍从系统堆分配, 不在静态区的覆盖范围内:
+// IoT 描述和状态消息 (iot::Manager 用 cJSON 生成), IoT 命令及其参数, Observer 事件中的 std::string / std::map
+#ifndef AI_VOX_STATIC_ALLOCATION
+#define AI_VOX_STATIC_ALLOCATION (0)
+#endif
+
+#ifndef AI_VOX_STATIC_HEAP_SIZE
+#define AI_VOX_STATIC_HEAP_SIZE (128 << 10)
+#endif
+
+namespace ai_vox {
+
+enum class HeapTag : uint8_t {
+  kEngine,       // 主任务及其它
+  kAudioInput,   // 采集任务栈, Opus 编码器, 上行音频帧
+  kAudioOutput,  // 播放任务栈, Opus 解码器, 待播放的下行音频帧
+  kWebsocket,    // websocket 客户端收发缓冲区 (按配置大小记账), 发送任务栈
+  kWakeNet,      // feed 缓冲区, 命令词捕获缓冲区, feed / detect 任务栈; esp-sr 内部分配的模型和 AFE 不计入
+  kIot,          // 收到的 JSON 消息
+  kObserver,     // Observer 中尚未取走的事件
+  kDisplay,      // 应用自行记账, 如 LVGL 显示缓冲区
+  kMax,
+};
+
+struct HeapTagStats {
+  size_t current;        // 字节
+  size_t peak;           // 字节
+  uint32_t failures;     // 分配失败次数
+  size_t budget;         // 字节, 0 表示不限制
+  uint32_t over_budget;  // 超出预算的次数, 超出后引擎降级运行而不是 abort
+};
+
+enum class MemoryRegion : uint8_t {
+  kDefault,   // MALLOC_CAP_DEFAULT, 由 heap_caps 自行选择, 与以往一致
+  kInternal,  // 内部 RAM, 用于热点数据和 flash 操作期间仍需访问的内存
+  kSpiram,    // PSRAM, 没有 PSRAM 或 PSRAM 分配失败时退回 kDefault
+};
+
+using HeapStats = std::array<HeapTagStats, static_cast<size_t>(HeapTag::kMax)>;
+
+struct StaticHeapStats {
+  size_t size;        // 字节, 未开启 AI_VOX_STATIC_ALLOCATION 时为 0
+  size_t carved;      // 已从静态区切出的字节
+  uint32_t carves;    // 空闲链表中没有合适的块, 从静态区切出新块的次数; 稳态下不再增长
+  uint32_t failures;  // 静态区用尽的次数, 需要调大 AI_VOX_STATIC_HEAP_SIZE
+};
+
+// 带标签的分配器, 每块内存前有 8 字节头部记录大小, 标签和区域; 分配失败返回 nullptr 并计数
+namespace heap {
+void *Malloc(const HeapTag tag, const size_t size, const MemoryRegion region = MemoryRegion::kDefault);
+void *Realloc(const HeapTag tag, void *ptr, const size_t size);  // 失败时 ptr 保持有效, 区域与原来相同
+void Free(void *ptr);                                            // 只能释放 Malloc / Realloc 返回的指针
+
+// 第三方库内部分配的内存 (如 websocket 缓冲区, LVGL) 无法经过 Malloc, 由调用方按其文档或配置给出的大小记账, 释放时传入负数;
+// 前后空闲堆的差值会混入其它任务同时进行的分配和释放, 只适合引擎启动前在 setup 中使用
+void Account(const HeapTag tag, const ptrdiff_t bytes);
+
+// 设置了预算且当前用量加上 extra 后超出预算
+bool OverBudget(const HeapTag tag, const size_t extra = 0);
+void SetBudget(const HeapTag tag, const size_t bytes);
+HeapStats Stats();
+const char *TagName(const HeapTag tag);
+StaticHeapStats StaticStats();
+bool Owns(const void *ptr);  // ptr 是否位于静态区, 未开启时总是 false
+// region 对应的 heap_caps_malloc 能力, 用于不经过 Malloc 的第三方缓冲区; 没有 PSRAM 时 kSpiram 返回 MALLOC_CAP_DEFAULT
+uint32_t Caps(const MemoryRegion region);
+}  // namespace heap
+
+}  // namespace ai_vox
+
+#endif
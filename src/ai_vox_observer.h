@@ -8,6 +8,7 @@
 #include <string>
 #include <variant>
 
+#include "ai_vox_heap.h"
 #include "iot_entity.h"
 
 namespace ai_vox {
@@ -21,6 +22,16 @@ enum class ChatState : uint8_t {
   kSpeaking,
 };
 
+// Engine::Start 之后依次经过的阶段, 模型加载和 websocket 客户端创建与 Wi-Fi 连接并行
+enum class BootPhase : uint8_t {
+  kEngineStart,     // 调用 Engine::Start
+  kModelsLoaded,    // 唤醒词/命令词模型和 AFE 加载完成, 仅 ESP32-S3 有实际工作
+  kWebsocketReady,  // websocket 客户端和收发缓冲区创建完成
+  kNetworkReady,    // 默认网络接口取得 IP
+  kConfigFetched,   // 从 OTA 服务器取得配置
+  kReady,           // 第一次进入待命
+};
+
 enum class ChatRole : uint8_t {
   kAssistant,
   kUser,
@@ -55,30 +66,60 @@ class Observer {
     std::map<std::string, iot::Value> parameters;
   };
 
-  using Event = std::variant<StateChangedEvent, ActivationEvent, ChatMessageEvent, EmotionEvent, IotMessageEvent>;
+  struct BootEvent {
+    BootPhase phase;
+    uint32_t time_ms;  // 自上电起的毫秒数, 与 esp_timer_get_time 同源, kReady 的时间即冷启动到待命的耗时
+  };
+
+  using Event = std::variant<StateChangedEvent, ActivationEvent, ChatMessageEvent, EmotionEvent, IotMessageEvent, BootEvent>;
 
   Observer() = default;
   virtual ~Observer() = default;
 
   virtual std::deque<Event> PopEvents() {
     std::lock_guard<std::mutex> lock(mutex_);
+    heap::Account(HeapTag::kObserver, -queued_bytes_);
+    queued_bytes_ = 0;
     return std::move(event_queue_);
   }
 
   virtual void PushEvent(Event&& event) {
     std::lock_guard<std::mutex> lock(mutex_);
     if (event_queue_.size() >= kMaxQueueSize) {
+      const auto bytes = EventSize(event_queue_.front());
+      heap::Account(HeapTag::kObserver, -bytes);
+      queued_bytes_ -= bytes;
       event_queue_.pop_front();
     }
+    const auto bytes = EventSize(event);
+    heap::Account(HeapTag::kObserver, bytes);
+    queued_bytes_ += bytes;
     event_queue_.emplace_back(std::move(event));
   }
 
+ protected:
+  // 估算事件占用的内存, 只计入字符串内容
+  static ptrdiff_t EventSize(const Event& event) {
+    ptrdiff_t bytes = sizeof(Event);
+    if (auto chat_message = std::get_if<ChatMessageEvent>(&event)) {
+      bytes += chat_message->content.capacity();
+    } else if (auto activation = std::get_if<ActivationEvent>(&event)) {
+      bytes += activation->code.capacity() + activation->message.capacity();
+    } else if (auto emotion = std::get_if<EmotionEvent>(&event)) {
+      bytes += emotion->emotion.capacity();
+    } else if (auto iot_message = std::get_if<IotMessageEvent>(&event)) {
+      bytes += iot_message->name.capacity() + iot_message->function.capacity();
+    }
+    return bytes;
+  }
+
  private:
   Observer(const Observer&) = delete;
   Observer& operator=(const Observer&) = delete;
 
   mutable std::mutex mutex_;
   std::deque<Event> event_queue_;
+  ptrdiff_t queued_bytes_ = 0;
 };
 
 }  // namespace ai_vox
@@ -13,6 +13,10 @@ class AudioInputDevice {
   virtual bool Open(uint32_t sample_rate) = 0;
   virtual void Close() = 0;
   virtual size_t Read(int16_t* buffer, uint32_t samples) = 0;
+  // 设备只支持固定采样率时返回该值, 引擎会按此采样率打开设备并自行重采样; 返回 0 表示支持任意采样率
+  virtual uint32_t native_sample_rate() const {
+    return 0;
+  }
 };
 }  // namespace ai_vox
 
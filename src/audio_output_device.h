@@ -18,6 +18,13 @@ class AudioOutputDevice {
   virtual size_t Write(int16_t* pcm, size_t samples) = 0;
   virtual void SetVolume(uint16_t volume) = 0;
   virtual uint16_t volume() const = 0;
+  // 丢弃已经写入但尚未播放的数据, 用于打断播放
+  virtual void Clear() {
+  }
+  // 设备只支持固定采样率时返回该值, 引擎会按此采样率打开设备并自行解码或重采样; 返回 0 表示支持任意采样率
+  virtual uint32_t native_sample_rate() const {
+    return 0;
+  }
 };
 }  // namespace ai_vox
 
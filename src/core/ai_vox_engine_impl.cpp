@@ -3,8 +3,10 @@
 #include <cJSON.h>
 #include <esp_crt_bundle.h>
 #include <esp_mac.h>
+#include <esp_netif.h>
 #include <esp_timer.h>
 #include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
 #include <freertos/task.h>
 
 #include "ai_vox_observer.h"
@@ -12,7 +14,14 @@
 #include "audio_output_engine.h"
 #include "espressif_button/button_gpio.h"
 #include "espressif_button/iot_button.h"
+#include "espressif_esp_websocket_client/esp_websocket_frame.h"
 #include "fetch_config.h"
+#include "json/json_reader.h"
+#include "json/json_writer.h"
+#include "latency/latency_tracker.h"
+#include "trace/trace.h"
+
+#define CLOGGER_MODULE ENGINE
 
 #ifndef CLOGGER_SEVERITY
 #define CLOGGER_SEVERITY CLOGGER_SEVERITY_WARN
@@ -24,6 +33,15 @@ namespace ai_vox {
 
 namespace {
 
+constexpr char kWebsocketTaskName[] = "AiVoxWebsocket";
+constexpr uint32_t kWebsocketTaskStackSize = 4 << 10;
+constexpr int kWebsocketBufferSize = 1024;  // websocket 收发缓冲区大小, 也是整帧发送缓冲区的负载上限
+constexpr uint32_t kAbortFadeMs = 5;  // 打断播放时的淡出时长
+constexpr char kWakeEarcon[] = "wake";
+constexpr uint32_t kNetworkPollIntervalMs = 50;     // 启动时等待网络的轮询间隔
+constexpr uint32_t kConfigRetryIntervalMs = 10000;  // 获取配置失败后的重试间隔
+constexpr size_t kMaxMessageSize = 256;             // 引擎自己发送的 JSON 消息, 在栈上拼接
+
 enum WebScoketFrameType : uint8_t {
   kWebsocketTextFrame = 0x01,    // 文本帧
   kWebsocketBinaryFrame = 0x02,  // 二进制帧
@@ -82,11 +100,13 @@ void DeleteCjsonObj(cJSON *obj) {
   }
 }
 
-void CJSONFree(void *obj) {
-  if (obj != nullptr) {
-    cJSON_free(obj);
-  }
+// Wi-Fi 或以太网等默认网络接口已取得 IP
+bool NetworkReady() {
+  const auto netif = esp_netif_get_default_netif();
+  esp_netif_ip_info_t ip_info;
+  return netif != nullptr && esp_netif_get_ip_info(netif, &ip_info) == ESP_OK && ip_info.ip.addr != 0;
 }
+
 }  // namespace
 
 EngineImpl &EngineImpl::GetInstance() {
@@ -104,15 +124,16 @@ EngineImpl::EngineImpl()
           {"Authorization", "Bearer test-token"},
       },
 #ifdef ARDUINO_ESP32S3_DEV
-      wake_net_([this]() { task_queue_.Enqueue([this]() { OnWakeUp(); }); }),
+      wake_net_([this]() { task_queue_->Enqueue([this]() { OnWakeUp(); }); }),
 #endif
-      task_queue_("AiVoxMain", 1024 * 4, tskIDLE_PRIORITY + 1) {
+      scheduling_policy_(SchedulingPolicy::Default()),
+      placement_policy_(PlacementPolicy::Default()) {
   CLOGD();
 }
 
 EngineImpl::~EngineImpl() {
   CLOGD();
-  // TODO
+  Stop();
 }
 
 void EngineImpl::SetObserver(std::shared_ptr<Observer> observer) {
@@ -161,6 +182,86 @@ void EngineImpl::RegisterIotEntity(std::shared_ptr<iot::Entity> entity) {
   iot_manager_.RegisterEntity(std::move(entity));
 }
 
+void EngineImpl::ConfigVad(const VadConfig &config) {
+  std::lock_guard lock(mutex_);
+  if (state_ != State::kIdle) {
+    return;
+  }
+  vad_config_ = config;
+}
+
+void EngineImpl::ConfigEncoder(const EncoderConfig &config) {
+  std::lock_guard lock(mutex_);
+  if (state_ != State::kIdle) {
+    return;
+  }
+  encoder_config_ = config;
+}
+
+void EngineImpl::SetSchedulingPolicy(const SchedulingPolicy &policy) {
+  std::lock_guard lock(mutex_);
+  if (state_ != State::kIdle) {
+    return;
+  }
+  scheduling_policy_ = policy;
+}
+
+void EngineImpl::SetPlacementPolicy(const PlacementPolicy &policy) {
+  std::lock_guard lock(mutex_);
+  if (state_ != State::kIdle) {
+    return;
+  }
+  placement_policy_ = policy;
+}
+
+void EngineImpl::ConfigResourceMonitor(const uint32_t interval_ms) {
+  std::lock_guard lock(mutex_);
+  if (state_ != State::kIdle) {
+    return;
+  }
+  resource_monitor_interval_ms_ = interval_ms;
+}
+
+void EngineImpl::ConfigLatencyReport(const uint32_t interval_ms) {
+  std::lock_guard lock(mutex_);
+  if (state_ != State::kIdle) {
+    return;
+  }
+  latency_report_interval_ms_ = interval_ms;
+}
+
+void EngineImpl::ConfigEarcons(const std::string &partition_label) {
+  std::lock_guard lock(mutex_);
+  if (state_ != State::kIdle) {
+    return;
+  }
+  earcon_partition_label_ = partition_label;
+}
+
+void EngineImpl::ConfigOfflineCommands(const OfflineCommandConfig &config) {
+  std::lock_guard lock(mutex_);
+  if (state_ != State::kIdle) {
+    return;
+  }
+  offline_command_config_ = config;
+}
+
+void EngineImpl::ConfigHeapBudget(const HeapTag tag, const size_t bytes) {
+  std::lock_guard lock(mutex_);
+  if (state_ != State::kIdle) {
+    return;
+  }
+  heap::SetBudget(tag, bytes);
+}
+
+void EngineImpl::ConfigPower(const PowerConfig &config) {
+  std::lock_guard lock(mutex_);
+  if (state_ != State::kIdle) {
+    return;
+  }
+  power_config_ = config;
+}
+
 void EngineImpl::Start(std::shared_ptr<AudioInputDevice> audio_input_device, std::shared_ptr<AudioOutputDevice> audio_output_device) {
   CLOGD();
   std::lock_guard lock(mutex_);
@@ -168,8 +269,15 @@ void EngineImpl::Start(std::shared_ptr<AudioInputDevice> audio_input_device, std
     return;
   }
 
+  booting_ = true;
+  ReportBootPhase(BootPhase::kEngineStart);
   audio_input_device_ = std::move(audio_input_device);
   audio_output_device_ = std::move(audio_output_device);
+  task_queue_ = std::make_unique<TaskQueue>(
+      "AiVoxMain", 1024 * 4, scheduling_policy_.main.priority, scheduling_policy_.main.core_id, HeapTag::kEngine, placement_policy_.main_stack);
+  if (!earcon_partition_label_.empty()) {
+    earcon_partition_.Map(earcon_partition_label_);
+  }
 
   button_config_t btn_cfg = {
       .long_press_time = 1000,
@@ -186,28 +294,108 @@ void EngineImpl::Start(std::shared_ptr<AudioInputDevice> audio_input_device, std
   ESP_ERROR_CHECK(iot_button_new_gpio_device(&btn_cfg, &gpio_cfg, &button_handle_));
   ESP_ERROR_CHECK(iot_button_register_cb(button_handle_, BUTTON_SINGLE_CLICK, nullptr, OnButtonClick, this));
 
+  if (power_config_.enabled) {
+    power_manager_.Start(power_config_);
+  }
   ChangeState(State::kInited);
-  LoadProtocol();
+  // 其余初始化在主任务中进行, Start 立即返回, 可以在 Wi-Fi 连接完成之前调用
+  task_queue_->Enqueue([this]() { OnBoot(); });
 
-  esp_websocket_client_config_t websocket_cfg;
-  memset(&websocket_cfg, 0, sizeof(websocket_cfg));
-  websocket_cfg.uri = websocket_url_.c_str();
-  websocket_cfg.task_prio = tskIDLE_PRIORITY;
-  websocket_cfg.crt_bundle_attach = esp_crt_bundle_attach;
+  if (resource_monitor_interval_ms_ > 0) {
+    resource_monitor_.AddTask(kWebsocketTaskName, kWebsocketTaskStackSize);
+    task_queue_->Enqueue([this]() { SampleResources(); });
+  }
 
-  CLOGI("url: %s", websocket_cfg.uri);
-  web_socket_client_ = esp_websocket_client_init(&websocket_cfg);
-  if (web_socket_client_ == nullptr) {
-    CLOGE("esp_websocket_client_init failed with %s", websocket_cfg.uri);
-    abort();
+  if (latency_report_interval_ms_ > 0) {
+    task_queue_->EnqueueAt(std::chrono::steady_clock::now() + std::chrono::milliseconds(latency_report_interval_ms_),
+                           [this]() { ReportLatency(); });
   }
-  for (const auto &[key, value] : websocket_headers_) {
-    esp_websocket_client_append_header(web_socket_client_, key.c_str(), value.c_str());
+}
+
+void EngineImpl::Stop() {
+  CLOGD();
+  std::lock_guard lock(mutex_);
+  if (state_ == State::kIdle) {
+    return;
   }
-  esp_websocket_client_append_header(web_socket_client_, "Protocol-Version", "1");
-  esp_websocket_client_append_header(web_socket_client_, "Device-Id", GetMacAddress().c_str());
-  esp_websocket_client_append_header(web_socket_client_, "Client-Id", uuid_.c_str());
-  esp_websocket_register_events(web_socket_client_, WEBSOCKET_EVENT_ANY, &EngineImpl::OnWebsocketEvent, this);
+
+  if (button_handle_ != nullptr) {
+    iot_button_delete(button_handle_);
+    button_handle_ = nullptr;
+  }
+  RunInTaskQueue([this]() {
+    OnSuspend();
+    ChangeState(State::kIdle);
+  });
+  // 主任务退出前会先执行完已入队的事件, 之后不再有任何回调引用 task_queue_
+  task_queue_.reset();
+  power_manager_.Stop();
+  audio_input_device_.reset();
+  audio_output_device_.reset();
+  protocol_loaded_ = false;
+  config_retry_pending_ = false;
+  CLOGI("OK");
+}
+
+void EngineImpl::Suspend() {
+  std::lock_guard lock(mutex_);
+  if (state_ == State::kIdle) {
+    return;
+  }
+  RunInTaskQueue([this]() { OnSuspend(); });
+}
+
+void EngineImpl::Resume() {
+  std::lock_guard lock(mutex_);
+  if (state_ == State::kIdle) {
+    return;
+  }
+  task_queue_->Enqueue([this]() { OnResume(); });
+}
+
+void EngineImpl::Trigger() {
+  std::lock_guard lock(mutex_);
+  if (state_ == State::kIdle) {
+    return;
+  }
+  task_queue_->Enqueue([this]() { OnTriggered(); });
+}
+
+void EngineImpl::PlayEarcon(const std::string &name) {
+  std::lock_guard lock(mutex_);
+  if (state_ == State::kIdle) {
+    return;
+  }
+  task_queue_->Enqueue([this, name]() { OnPlayEarcon(name); });
+}
+
+std::vector<TaskStats> EngineImpl::GetTaskStats() const {
+  std::lock_guard lock(task_stats_mutex_);
+  return task_stats_;
+}
+
+HeapStats EngineImpl::GetHeapStats() const {
+  return heap::Stats();
+}
+
+LatencyStats EngineImpl::GetLatencyStats() const {
+  return LatencyTracker::GetInstance().Snapshot();
+}
+
+WakeNetStats EngineImpl::GetWakeNetStats() const {
+#ifdef ARDUINO_ESP32S3_DEV
+  return wake_net_.stats();
+#else
+  return {};
+#endif
+}
+
+PowerStats EngineImpl::GetPowerStats() const {
+  return power_manager_.stats();
+}
+
+void EngineImpl::DumpTrace() {
+  Tracer::GetInstance().Dump();
 }
 
 void EngineImpl::OnButtonClick(void *button_handle, void *self) {
@@ -219,7 +407,7 @@ void EngineImpl::OnWebsocketEvent(void *self, esp_event_base_t base, int32_t eve
 }
 
 void EngineImpl::OnButtonClick() {
-  task_queue_.Enqueue([this]() { OnTriggered(); });
+  task_queue_->Enqueue([this]() { OnTriggered(); });
 }
 
 void EngineImpl::OnWebsocketEvent(esp_event_base_t base, int32_t event_id, void *event_data) {
@@ -231,30 +419,41 @@ void EngineImpl::OnWebsocketEvent(esp_event_base_t base, int32_t event_id, void
     }
     case WEBSOCKET_EVENT_CONNECTED: {
       CLOGI("WEBSOCKET_EVENT_CONNECTED");
-      task_queue_.Enqueue([this]() { OnWebSocketConnected(); });
+      task_queue_->Enqueue([this]() { OnWebSocketConnected(); });
       break;
     }
     case WEBSOCKET_EVENT_DISCONNECTED: {
       CLOGI("WEBSOCKET_EVENT_DISCONNECTED");
-      task_queue_.Enqueue([this]() { OnWebSocketDisconnected(); });
+      task_queue_->Enqueue([this]() { OnWebSocketDisconnected(); });
       break;
     }
     case WEBSOCKET_EVENT_DATA: {
+      TRACE_SCOPE(TraceEvent::kWebsocketReceive, data->data_len, data->op_code);
       if (!data->fin) {
         abort();
       }
 
       switch (data->op_code) {
         case kWebsocketTextFrame: {
-          FlexArray<uint8_t> frame(data->data_len);
+          FlexArray<uint8_t> frame(data->data_len, HeapTag::kIot, placement_policy_.json);
+          if (frame.data() == nullptr) {
+            break;
+          }
           memcpy(frame.data(), data->data_ptr, data->data_len);
-          task_queue_.Enqueue([this, frame = std::move(frame)]() mutable { OnJsonData(std::move(frame)); });
+          task_queue_->Enqueue([this, frame = std::move(frame)]() mutable { OnJsonData(std::move(frame)); });
           break;
         }
         case kWebsocketBinaryFrame: {
-          FlexArray<uint8_t> frame(data->data_len);
+          // 排队等待解码的下行音频计入播放
+          FlexArray<uint8_t> frame(data->data_len, HeapTag::kAudioOutput, placement_policy_.downlink_packets);
+          if (frame.data() == nullptr) {
+            break;
+          }
           memcpy(frame.data(), data->data_ptr, data->data_len);
-          task_queue_.Enqueue([this, frame = std::move(frame)]() mutable { OnAudioFrame(std::move(frame)); });
+          task_queue_->Enqueue([this, frame = std::move(frame), received_time = esp_timer_get_time()]() mutable {
+            LatencyTracker::GetInstance().Record(LatencyStage::kReceive, esp_timer_get_time() - received_time);
+            OnAudioFrame(std::move(frame));
+          });
           break;
         }
         default: {
@@ -269,7 +468,7 @@ void EngineImpl::OnWebsocketEvent(esp_event_base_t base, int32_t event_id, void
     }
     case WEBSOCKET_EVENT_FINISH: {
       CLOGI("WEBSOCKET_EVENT_FINISH");
-      task_queue_.Enqueue([this]() { OnWebSocketDisconnected(); });
+      task_queue_->Enqueue([this]() { OnWebSocketDisconnected(); });
       break;
     }
     default: {
@@ -279,69 +478,90 @@ void EngineImpl::OnWebsocketEvent(esp_event_base_t base, int32_t event_id, void
 }
 
 void EngineImpl::OnAudioFrame(FlexArray<uint8_t> &&data) {
-  if (audio_output_engine_) {
+  // 已经打断的回复, 服务端在收到 abort 前发出的数据不再播放
+  if (speaking_aborted_) {
+    return;
+  }
+
+  if (reply_pending_) {
+    pending_audio_frames_.push_back(std::move(data));
+  } else if (audio_output_engine_) {
     audio_output_engine_->Write(std::move(data));
   }
 }
 
 void EngineImpl::OnJsonData(FlexArray<uint8_t> &&data) {
-  std::unique_ptr<cJSON, decltype(&DeleteCjsonObj)> root_obj(cJSON_ParseWithLength(reinterpret_cast<const char *>(data.data()), data.size()),
-                                                             &DeleteCjsonObj);
-
-  if (!cJSON_IsObject(root_obj.get())) {
+  // 每轮对话都有的消息直接在收到的数据上读取, 不经过 cJSON, 稳态下不分配内存
+  const JsonReader root(reinterpret_cast<const char *>(data.data()), data.size());
+  if (!root.valid()) {
     CLOGE("Invalid JSON data");
     return;
   }
 
-  std::string type;
-  auto *type_json = cJSON_GetObjectItem(root_obj.get(), "type");
-  if (cJSON_IsString(type_json)) {
-    type = type_json->valuestring;
-  } else {
+  char type[16];
+  if (!root.GetString("type", type, sizeof(type))) {
     CLOGE("Missing or invalid 'type' field in JSON data");
     return;
   }
-  CLOGI("Received JSON type: %s", type.c_str());
+  CLOGI("Received JSON type: %s", type);
 
-  if (type == "hello") {
-    const auto state = state_;
+  if (strcmp(type, "hello") == 0) {
     if (state_ != State::kWebsocketConnected && state_ != State::kWebsocketConnectedWithWakeup) {
       CLOGE("Invalid state: %u", state_);
       return;
     }
 
-    auto session_id_json = cJSON_GetObjectItem(root_obj.get(), "session_id");
-    if (cJSON_IsString(session_id_json)) {
-      session_id_ = session_id_json->valuestring;
-      CLOGI("Session ID: %s", session_id_.c_str());
+    if (root.GetString("session_id", session_id_, sizeof(session_id_))) {
+      CLOGI("Session ID: %s", session_id_);
+    }
+
+    // 下行音频参数由服务端决定, 缺省为 24 kHz / 60 ms
+    const auto audio_params = root.GetObject("audio_params");
+    if (audio_params.valid()) {
+      int32_t sample_rate = 0;
+      if (audio_params.GetInt("sample_rate", sample_rate)) {
+        switch (sample_rate) {
+          case 8000:
+          case 12000:
+          case 16000:
+          case 24000:
+          case 48000:
+            downlink_sample_rate_ = sample_rate;
+            break;
+          default:
+            CLOGW("unsupported sample rate: %" PRIi32, sample_rate);
+            break;
+        }
+      }
+
+      int32_t frame_duration = 0;
+      if (audio_params.GetInt("frame_duration", frame_duration) && frame_duration >= 10 && frame_duration <= 120) {
+        downlink_frame_duration_ = frame_duration;
+      }
+      CLOGI("downlink: %" PRIu32 " Hz, %" PRIu32 " ms", downlink_sample_rate_, downlink_frame_duration_);
+    }
+
+    LatencyTracker::GetInstance().End(LatencyStage::kConnectToHello);
+    LatencyTracker::GetInstance().Begin(LatencyStage::kHelloToListen);
+
+    if (session_cancelled_) {
+      return;
     }
 
     SendIotDescriptions();
     SendIotUpdatedStates(true);
-    StartListening();
-
-    if (state == State::kWebsocketConnectedWithWakeup) {
-      std::unique_ptr<cJSON, decltype(&DeleteCjsonObj)> message_obj(cJSON_CreateObject(), &DeleteCjsonObj);
-      cJSON_AddStringToObject(message_obj.get(), "session_id", session_id_.c_str());
-      cJSON_AddStringToObject(message_obj.get(), "type", "listen");
-      cJSON_AddStringToObject(message_obj.get(), "state", "detect");
-      cJSON_AddStringToObject(message_obj.get(), "text", "你好小智");
-      auto json_str = cJSON_PrintUnformatted(message_obj.get());
-      CLOGI("Sending JSON: %s", json_str);
-      esp_websocket_client_send_text(web_socket_client_, json_str, strlen(json_str), pdMS_TO_TICKS(5000));
-    }
-  } else if (type == "goodbye") {
-    auto session_id_json = cJSON_GetObjectItem(root_obj.get(), "session_id");
-    std::string session_id;
-    if (cJSON_IsString(session_id_json)) {
-      if (session_id_ != session_id_json->valuestring) {
+    StartConversation();
+  } else if (strcmp(type, "goodbye") == 0) {
+    char session_id[sizeof(session_id_)];
+    if (root.GetString("session_id", session_id, sizeof(session_id))) {
+      if (strcmp(session_id_, session_id) != 0) {
         return;
       }
     }
-  } else if (type == "tts") {
-    auto *state_json = cJSON_GetObjectItem(root_obj.get(), "state");
-    if (cJSON_IsString(state_json)) {
-      if (strcmp("start", state_json->valuestring) == 0) {
+  } else if (strcmp(type, "tts") == 0) {
+    char state[16];
+    if (root.GetString("state", state, sizeof(state))) {
+      if (strcmp("start", state) == 0) {
         CLOG("tts start");
 
         if (state_ == State::kSpeaking) {
@@ -352,47 +572,63 @@ void EngineImpl::OnJsonData(FlexArray<uint8_t> &&data) {
           return;
         }
 
-        audio_input_engine_.reset();
-        transmit_queue_.reset();
+        StopListening();
 #ifdef ARDUINO_ESP32S3_DEV
-        wake_net_.Start(audio_input_device_);
+        wake_net_.Start(
+            audio_input_device_, scheduling_policy_.wake_net_feed, scheduling_policy_.wake_net_detect, placement_policy_.wake_net_stack);
 #endif
-        audio_output_engine_ = std::make_shared<AudioOutputEngine>(audio_output_device_, audio_frame_duration_);
+        // 此时的输出引擎只可能是播放提示音的临时引擎: 参数与下行一致时直接沿用, 回复排在提示音之后;
+        // 否则不截断提示音也不在此等待, 下行音频先暂存, 提示音播完后由 OnEarconPlayed 重建引擎
+        if (audio_output_engine_ && (audio_output_engine_->sample_rate() != downlink_sample_rate_ ||
+                                     audio_output_engine_->frame_duration() != downlink_frame_duration_)) {
+          reply_pending_ = true;
+        } else if (!audio_output_engine_) {
+          audio_output_engine_ = std::make_shared<AudioOutputEngine>(
+              audio_output_device_, downlink_sample_rate_, downlink_frame_duration_, scheduling_policy_.audio_output, placement_policy_);
+        }
+        speaking_aborted_ = false;
         ChangeState(State::kSpeaking);
-      } else if (strcmp("stop", state_json->valuestring) == 0) {
+      } else if (strcmp("stop", state) == 0) {
         CLOG("tts stop");
-        if (audio_output_engine_) {
-          audio_output_engine_->NotifyDataEnd([this]() { task_queue_.Enqueue([this]() { OnAudioOutputDataConsumed(); }); });
+        if (reply_pending_) {
+          reply_end_pending_ = true;
+        } else if (audio_output_engine_) {
+          NotifyReplyEnd();
         }
-      } else if (strcmp("sentence_start", state_json->valuestring) == 0) {
-        auto text = cJSON_GetObjectItem(root_obj.get(), "text");
-        if (text != nullptr) {
-          CLOG("<< %s", text->valuestring);
+      } else if (strcmp("sentence_start", state) == 0) {
+        // 反转义后不会比原文长
+        FlexArray<char> text(data.size() + 1, HeapTag::kIot, placement_policy_.json);
+        if (root.GetString("text", text.data(), text.size())) {
+          CLOG("<< %s", text.data());
           if (observer_) {
-            observer_->PushEvent(Observer::ChatMessageEvent{ChatRole::kAssistant, text->valuestring});
+            observer_->PushEvent(Observer::ChatMessageEvent{ChatRole::kAssistant, text.data()});
           }
         }
-      } else if (strcmp("sentence_end", state_json->valuestring) == 0) {
+      } else if (strcmp("sentence_end", state) == 0) {
         // TODO:
       }
     }
-  } else if (type == "stt") {
-    auto text = cJSON_GetObjectItem(root_obj.get(), "text");
-    if (text != nullptr) {
-      CLOG(">> %s", text->valuestring);
+  } else if (strcmp(type, "stt") == 0) {
+    LatencyTracker::GetInstance().End(LatencyStage::kLastUserFrameToStt);
+    FlexArray<char> text(data.size() + 1, HeapTag::kIot, placement_policy_.json);
+    if (root.GetString("text", text.data(), text.size())) {
+      CLOG(">> %s", text.data());
       if (observer_) {
-        observer_->PushEvent(Observer::ChatMessageEvent{ChatRole::kUser, text->valuestring});
+        observer_->PushEvent(Observer::ChatMessageEvent{ChatRole::kUser, text.data()});
       }
     }
-  } else if (type == "llm") {
-    auto emotion = cJSON_GetObjectItem(root_obj.get(), "emotion");
-    if (cJSON_IsString(emotion)) {
-      CLOG("emotion: %s", emotion->valuestring);
+  } else if (strcmp(type, "llm") == 0) {
+    char emotion[32];
+    if (root.GetString("emotion", emotion, sizeof(emotion))) {
+      CLOG("emotion: %s", emotion);
       if (observer_) {
-        observer_->PushEvent(Observer::EmotionEvent{emotion->valuestring});
+        observer_->PushEvent(Observer::EmotionEvent{emotion});
       }
     }
-  } else if (type == "iot") {
+  } else if (strcmp(type, "iot") == 0) {
+    // IoT 命令的参数要转成 std::map 交给 Observer, 仍用 cJSON 解析, 从系统堆分配
+    std::unique_ptr<cJSON, decltype(&DeleteCjsonObj)> root_obj(
+        cJSON_ParseWithLength(reinterpret_cast<const char *>(data.data()), data.size()), &DeleteCjsonObj);
     auto commands = cJSON_GetObjectItem(root_obj.get(), "commands");
     if (cJSON_IsArray(commands)) {
       auto count = cJSON_GetArraySize(commands);
@@ -433,7 +669,7 @@ void EngineImpl::OnJsonData(FlexArray<uint8_t> &&data) {
       }
     }
   } else {
-    CLOGE("Unknown JSON type: %s", type.c_str());
+    CLOGE("Unknown JSON type: %s", type);
   }
 }
 
@@ -448,33 +684,37 @@ void EngineImpl::OnWebSocketConnected() {
     return;
   }
 
-  std::unique_ptr<cJSON, decltype(&DeleteCjsonObj)> root_obj(cJSON_CreateObject(), &DeleteCjsonObj);
-  cJSON_AddStringToObject(root_obj.get(), "type", "hello");
-  cJSON_AddNumberToObject(root_obj.get(), "version", 1);
-  cJSON_AddStringToObject(root_obj.get(), "transport", "websocket");
-
-  auto const audio_params_obj = cJSON_CreateObject();
-  cJSON_AddStringToObject(audio_params_obj, "format", "opus");
-  cJSON_AddNumberToObject(audio_params_obj, "sample_rate", 16000);
-  cJSON_AddNumberToObject(audio_params_obj, "channels", 1);
-  cJSON_AddNumberToObject(audio_params_obj, "frame_duration", audio_frame_duration_);
-  cJSON_AddItemToObject(root_obj.get(), "audio_params", audio_params_obj);
+  if (session_cancelled_) {
+    DisconnectWebSocket();
+    return;
+  }
 
-  std::unique_ptr<char, decltype(&CJSONFree)> text(cJSON_PrintUnformatted(root_obj.get()), &CJSONFree);
-  const auto length = strlen(text.get());
-  CLOGI("sending text: %.*s", static_cast<int>(length), text.get());
-  esp_websocket_client_send_text(web_socket_client_, text.get(), length, pdMS_TO_TICKS(5000));
+  char message[kMaxMessageSize];
+  JsonWriter writer(message, sizeof(message));
+  writer.Add("type", "hello").Add("version", 1).Add("transport", "websocket");
+  writer.BeginObject("audio_params")
+      .Add("format", "opus")
+      .Add("sample_rate", 16000)
+      .Add("channels", 1)
+      .Add("frame_duration", static_cast<int32_t>(audio_frame_duration_))
+      .EndObject();
+  SendJson(writer);
 }
 
 void EngineImpl::OnWebSocketDisconnected() {
   CLOGI();
-  audio_input_engine_.reset();
-  transmit_queue_.reset();
-  audio_output_engine_.reset();
+  if (state_ == State::kSuspended || state_ == State::kIdle) {
+    // esp_websocket_client_destroy 停止任务时也会上报断开
+    return;
+  }
+
+  StopListening();
+  ResetAudioOutput();
   esp_websocket_client_close(web_socket_client_, pdMS_TO_TICKS(5000));
+  session_cancelled_ = false;
 
 #ifdef ARDUINO_ESP32S3_DEV
-  wake_net_.Start(audio_input_device_);
+  wake_net_.Start(audio_input_device_, scheduling_policy_.wake_net_feed, scheduling_policy_.wake_net_detect, placement_policy_.wake_net_stack);
 #endif
   ChangeState(State::kStandby);
 }
@@ -497,6 +737,7 @@ void EngineImpl::OnTriggered() {
       break;
     }
     case State::kStandby: {
+      OnPlayEarcon(kWakeEarcon);
       if (ConnectWebSocket()) {
         ChangeState(State::kWebsocketConnecting);
       }
@@ -520,6 +761,9 @@ void EngineImpl::OnWakeUp() {
   CLOGI();
   switch (state_) {
     case State::kStandby: {
+      OnPlayEarcon(kWakeEarcon);
+      // WakeNet 唤醒后接着识别命令词, 同时建立连接, 命令未命中时省去连接时间
+      offline_command_pending_ = !offline_commands_.empty();
       if (ConnectWebSocket()) {
         ChangeState(State::kWebsocketConnectingWithWakeup);
       }
@@ -535,6 +779,195 @@ void EngineImpl::OnWakeUp() {
   }
 }
 
+void EngineImpl::OnVadEvent(const Vad::Event event) {
+  CLOGI("vad event: %u", event);
+  if (state_ != State::kListening) {
+    return;
+  }
+
+  if (event == Vad::Event::kSpeechEnd && !vad_endpointed_) {
+    SendListenState("stop");
+    LatencyTracker::GetInstance().Begin(LatencyStage::kLastUserFrameToStt);
+    vad_endpointed_ = true;
+  } else if (event == Vad::Event::kSpeechStart && vad_endpointed_) {
+    SendListenState("start");
+    vad_endpointed_ = false;
+  }
+}
+
+void EngineImpl::OnPlayEarcon(const std::string &name) {
+  if (state_ == State::kSuspended) {
+    return;
+  }
+
+  const auto clip = earcon_partition_.Find(name);
+  if (!clip) {
+    return;
+  }
+
+  CLOGI("earcon: %s", name.c_str());
+  if (audio_output_engine_) {
+    // 正在播放回复时排在已收到的音频之后
+    audio_output_engine_->Play(clip->data, clip->size);
+    return;
+  }
+
+  // 待机或连接中没有输出引擎, 临时创建一个, 播完后释放以关闭输出设备
+  audio_output_engine_ = std::make_shared<AudioOutputEngine>(
+      audio_output_device_, downlink_sample_rate_, downlink_frame_duration_, scheduling_policy_.audio_output, placement_policy_);
+  audio_output_engine_->Play(clip->data, clip->size);
+  audio_output_engine_->NotifyDataEnd([this, audio_output_engine = std::weak_ptr<AudioOutputEngine>(audio_output_engine_)]() {
+    task_queue_->Enqueue([this, audio_output_engine]() { OnEarconPlayed(audio_output_engine); });
+  });
+}
+
+void EngineImpl::OnEarconPlayed(const std::weak_ptr<AudioOutputEngine> &audio_output_engine) {
+  if (!audio_output_engine_ || audio_output_engine.lock() != audio_output_engine_) {
+    return;
+  }
+
+  if (reply_pending_) {
+    // 提示音已播完, 按下行参数重建引擎, 补上暂存的回复音频
+    reply_pending_ = false;
+    audio_output_engine_.reset();
+    audio_output_engine_ = std::make_shared<AudioOutputEngine>(
+        audio_output_device_, downlink_sample_rate_, downlink_frame_duration_, scheduling_policy_.audio_output, placement_policy_);
+    for (auto &frame : pending_audio_frames_) {
+      audio_output_engine_->Write(std::move(frame));
+    }
+    pending_audio_frames_.clear();
+    if (reply_end_pending_) {
+      reply_end_pending_ = false;
+      NotifyReplyEnd();
+    }
+  } else if (state_ != State::kSpeaking) {
+    audio_output_engine_.reset();
+  }
+}
+
+void EngineImpl::NotifyReplyEnd() {
+  audio_output_engine_->NotifyDataEnd([this]() { task_queue_->Enqueue([this]() { OnAudioOutputDataConsumed(); }); });
+}
+
+void EngineImpl::ResetAudioOutput() {
+  audio_output_engine_.reset();
+  reply_pending_ = false;
+  reply_end_pending_ = false;
+  pending_audio_frames_.clear();
+}
+
+void EngineImpl::OnOfflineCommand(const int command, const float probability) {
+  if (!offline_command_pending_) {
+    return;
+  }
+
+  offline_command_pending_ = false;
+  if (command < 0 || static_cast<size_t>(command) >= offline_commands_.size()) {
+    // 对话照常进行, AudioInputEngine 读完捕获的音频后自行切换到麦克风
+    CLOGI("no offline command, probability: %.2f", probability);
+    return;
+  }
+
+  const auto &offline_command = offline_commands_[command];
+  CLOG("offline command: %s.%s, probability: %.2f", offline_command.entity.c_str(), offline_command.function.c_str(), probability);
+  if (observer_) {
+    observer_->PushEvent(Observer::IotMessageEvent{offline_command.entity, offline_command.function, {}});
+  }
+
+  if (state_ == State::kWebsocketConnectingWithWakeup) {
+    session_cancelled_ = true;
+  } else if (state_ == State::kWebsocketConnectedWithWakeup || state_ == State::kListening || state_ == State::kSpeaking) {
+    // 已上传的音频作废, 断开连接结束本轮对话
+    session_cancelled_ = true;
+    DisconnectWebSocket();
+  }
+}
+
+void EngineImpl::OnSuspend() {
+  CLOGI();
+  if (state_ == State::kSuspended) {
+    return;
+  }
+
+  StopListening();
+  ResetAudioOutput();
+  offline_command_pending_ = false;
+  session_cancelled_ = false;
+  DestroyWebSocketClient();
+#ifdef ARDUINO_ESP32S3_DEV
+  wake_net_.Release();
+#endif
+  ChangeState(State::kSuspended);
+}
+
+void EngineImpl::OnResume() {
+  CLOGI();
+  if (state_ != State::kSuspended) {
+    return;
+  }
+
+  CreateWebSocketClient();
+  if (!protocol_loaded_) {
+    // 挂起时可能还没有网络, 与启动时一样等到取得 IP 再获取配置
+    ChangeState(State::kInited);
+    WaitForNetwork();
+    return;
+  }
+
+  // 配置已在挂起前获取, 直接回到待机, 不再请求 OTA 服务器
+#ifdef ARDUINO_ESP32S3_DEV
+  wake_net_.Start(audio_input_device_, scheduling_policy_.wake_net_feed, scheduling_policy_.wake_net_detect, placement_policy_.wake_net_stack);
+#endif
+  ChangeState(State::kStandby);
+}
+
+void EngineImpl::OnBoot() {
+  CLOGI();
+  LoadModels();
+  ReportBootPhase(BootPhase::kModelsLoaded);
+  CreateWebSocketClient();
+  ReportBootPhase(BootPhase::kWebsocketReady);
+  WaitForNetwork();
+}
+
+void EngineImpl::LoadModels() {
+#ifdef ARDUINO_ESP32S3_DEV
+  if (!wake_net_.Load()) {
+    return;
+  }
+
+  if (offline_command_config_.enabled) {
+    offline_commands_ = iot_manager_.OfflineCommands(wake_net_.english_commands());
+    std::vector<std::vector<std::string>> phrases;
+    for (const auto &command : offline_commands_) {
+      phrases.push_back(command.phrases);
+    }
+    if (!wake_net_.EnableCommands(phrases,
+                                  offline_command_config_.threshold,
+                                  offline_command_config_.window_ms,
+                                  [this](const int command, const float probability) {
+                                    task_queue_->Enqueue([this, command, probability]() { OnOfflineCommand(command, probability); });
+                                  })) {
+      offline_commands_.clear();
+    }
+  }
+#endif
+}
+
+void EngineImpl::WaitForNetwork() {
+  if (state_ != State::kInited) {
+    return;
+  }
+
+  if (!NetworkReady()) {
+    task_queue_->EnqueueAt(std::chrono::steady_clock::now() + std::chrono::milliseconds(kNetworkPollIntervalMs), [this]() { WaitForNetwork(); });
+    return;
+  }
+
+  ReportBootPhase(BootPhase::kNetworkReady);
+  LoadProtocol();
+}
+
 void EngineImpl::LoadProtocol() {
   CLOGI();
   if (state_ != State::kInited) {
@@ -547,8 +980,16 @@ void EngineImpl::LoadProtocol() {
   auto config = GetConfigFromServer(ota_url_, uuid_);
 
   if (!config.has_value()) {
-    CLOGE("GetConfigFromServer failed");
+    CLOGE("GetConfigFromServer failed, retry in %" PRIu32 " ms", kConfigRetryIntervalMs);
     ChangeState(State::kInited);
+    // 按键触发的 LoadProtocol 失败时可能已有一次重试在等待, 只保留一次
+    if (!config_retry_pending_) {
+      config_retry_pending_ = true;
+      task_queue_->EnqueueAt(std::chrono::steady_clock::now() + std::chrono::milliseconds(kConfigRetryIntervalMs), [this]() {
+        config_retry_pending_ = false;
+        WaitForNetwork();
+      });
+    }
     return;
   }
 
@@ -569,10 +1010,16 @@ void EngineImpl::LoadProtocol() {
     ChangeState(State::kInited);
     return;
   }
+  protocol_loaded_ = true;
+  ReportBootPhase(BootPhase::kConfigFetched);
 #ifdef ARDUINO_ESP32S3_DEV
-  wake_net_.Start(audio_input_device_);
+  wake_net_.Start(audio_input_device_, scheduling_policy_.wake_net_feed, scheduling_policy_.wake_net_detect, placement_policy_.wake_net_stack);
 #endif
   ChangeState(State::kStandby);
+  if (booting_) {
+    booting_ = false;
+    ReportBootPhase(BootPhase::kReady);
+  }
   return;
 }
 
@@ -582,21 +1029,27 @@ void EngineImpl::StartListening() {
     return;
   }
 
-  std::unique_ptr<cJSON, decltype(&DeleteCjsonObj)> root_obj(cJSON_CreateObject(), &DeleteCjsonObj);
-  cJSON_AddStringToObject(root_obj.get(), "session_id", session_id_.c_str());
-  cJSON_AddStringToObject(root_obj.get(), "type", "listen");
-  cJSON_AddStringToObject(root_obj.get(), "state", "start");
-  cJSON_AddStringToObject(root_obj.get(), "mode", "auto");
-  std::unique_ptr<char, decltype(&CJSONFree)> text(cJSON_PrintUnformatted(root_obj.get()), &CJSONFree);
-  const auto length = strlen(text.get());
-  CLOGI("sending text: %.*s", static_cast<int>(length), text.get());
-  esp_websocket_client_send_text(web_socket_client_, text.get(), length, pdMS_TO_TICKS(5000));
+  SendListenState("start");
 
-  audio_output_engine_.reset();
+  // 回复的输出引擎此时已播完, 释放很快; 提示音的临时引擎留给 OnEarconPlayed 在播完后释放, 不在这里等待
+  if (state_ == State::kSpeaking) {
+    ResetAudioOutput();
+  }
+  AudioInputEngine::Source source;
 #ifdef ARDUINO_ESP32S3_DEV
-  wake_net_.Stop();
+  if (state_ == State::kWebsocketConnectedWithWakeup && !offline_commands_.empty()) {
+    // 唤醒后 WakeNet 仍在识别命令词, 先上传它捕获的音频, 识别结束后 AudioInputEngine 再接管麦克风
+    source = [this](int16_t *pcm, size_t samples) { return wake_net_.ReadCapture(pcm, samples); };
+  } else {
+    wake_net_.Pause();
+  }
 #endif
-  transmit_queue_ = std::make_unique<TaskQueue>("AiVoxTransmit", 1024 * 3, tskIDLE_PRIORITY + 2);
+  transmit_queue_ = std::make_unique<TaskQueue>("AiVoxTransmit",
+                                                1024 * 3,
+                                                scheduling_policy_.transmit.priority,
+                                                scheduling_policy_.transmit.core_id,
+                                                HeapTag::kWebsocket,
+                                                placement_policy_.transmit_stack);
   audio_input_engine_ = std::make_shared<AudioInputEngine>(
       audio_input_device_,
       [this](FlexArray<uint8_t> &&data) mutable {
@@ -606,36 +1059,92 @@ void EngineImpl::StartListening() {
 
         transmit_queue_->Enqueue([this, data = std::move(data)]() mutable {
           if (esp_websocket_client_is_connected(web_socket_client_)) {
+            TRACE_SCOPE(TraceEvent::kWebsocketSend, data.size(), 0);
             const auto start_time = esp_timer_get_time();
+            // 帧头和掩码后的负载一次写出, TLS 下每帧只有一个记录
             if (data.size() !=
-                esp_websocket_client_send_bin(web_socket_client_, reinterpret_cast<const char *>(data.data()), data.size(), pdMS_TO_TICKS(3000))) {
+                esp_websocket_client_send_frame(web_socket_client_, WS_TRANSPORT_OPCODES_BINARY, data.data(), data.size(), pdMS_TO_TICKS(3000))) {
               CLOGE("sending failed");
             }
 
             const auto elapsed_time = esp_timer_get_time() - start_time;
+            LatencyTracker::GetInstance().Record(LatencyStage::kSend, elapsed_time);
             if (elapsed_time > 100 * 1000) {
               CLOGW("Network latency high: %lld ms, data size: %zu bytes, poor network condition detected", elapsed_time / 1000, data.size());
             }
           }
         });
       },
-      audio_frame_duration_);
+      audio_frame_duration_,
+      encoder_config_,
+      scheduling_policy_.audio_input,
+      placement_policy_,
+      vad_config_.enabled ? std::make_unique<Vad>(audio_frame_duration_, vad_config_.hangover_ms, vad_config_.threshold_db) : nullptr,
+      [this](const Vad::Event event) { task_queue_->Enqueue([this, event]() { OnVadEvent(event); }); },
+      std::move(source));
+  vad_endpointed_ = false;
   ChangeState(State::kListening);
 }
 
+void EngineImpl::StopListening() {
+#ifdef ARDUINO_ESP32S3_DEV
+  if (audio_input_engine_) {
+    // AudioInputEngine 可能正阻塞在 ReadCapture 中等待命令词识别结束, 先暂停 WakeNet 让它返回
+    wake_net_.Pause();
+  }
+#endif
+  audio_input_engine_.reset();
+  transmit_queue_.reset();
+}
+
+void EngineImpl::StartConversation() {
+  const auto state = state_;
+  StartListening();
+
+  if (state == State::kWebsocketConnectedWithWakeup) {
+    char message[kMaxMessageSize];
+    JsonWriter writer(message, sizeof(message));
+    writer.Add("session_id", session_id_).Add("type", "listen").Add("state", "detect").Add("text", "你好小智");
+    SendJson(writer);
+  }
+}
+
+void EngineImpl::SendListenState(const char *state) {
+  char message[kMaxMessageSize];
+  JsonWriter writer(message, sizeof(message));
+  writer.Add("session_id", session_id_).Add("type", "listen").Add("state", state);
+  if (strcmp(state, "start") == 0) {
+    writer.Add("mode", "auto");
+  }
+  SendJson(writer);
+}
+
+void EngineImpl::SendJson(JsonWriter &writer) {
+  const auto text = writer.Finish();
+  if (text == nullptr) {
+    CLOGE("message too long");
+    return;
+  }
+  CLOGI("sending text: %s", text);
+  esp_websocket_client_send_text(web_socket_client_, text, writer.size(), pdMS_TO_TICKS(5000));
+}
+
 void EngineImpl::AbortSpeaking() {
   if (state_ != State::kSpeaking) {
     CLOGE("invalid state: %d", state_);
     return;
   }
 
-  std::unique_ptr<cJSON, decltype(&DeleteCjsonObj)> root_obj(cJSON_CreateObject(), &DeleteCjsonObj);
-  cJSON_AddStringToObject(root_obj.get(), "session_id", session_id_.c_str());
-  cJSON_AddStringToObject(root_obj.get(), "type", "abort");
-  std::unique_ptr<char, decltype(&CJSONFree)> text(cJSON_PrintUnformatted(root_obj.get()), &CJSONFree);
-  const auto length = strlen(text.get());
-  CLOGI("sending text: %.*s", static_cast<int>(length), text.get());
-  esp_websocket_client_send_text(web_socket_client_, text.get(), length, pdMS_TO_TICKS(5000));
+  char message[kMaxMessageSize];
+  JsonWriter writer(message, sizeof(message));
+  writer.Add("session_id", session_id_).Add("type", "abort");
+  LatencyTracker::GetInstance().Begin(LatencyStage::kAbortToSilence);
+  speaking_aborted_ = true;
+  pending_audio_frames_.clear();
+  if (audio_output_engine_) {
+    audio_output_engine_->Flush(kAbortFadeMs);
+  }
+  SendJson(writer);
   CLOG("OK");
 }
 
@@ -645,14 +1154,16 @@ void EngineImpl::AbortSpeaking(const std::string &reason) {
     return;
   }
 
-  std::unique_ptr<cJSON, decltype(&DeleteCjsonObj)> root_obj(cJSON_CreateObject(), &DeleteCjsonObj);
-  cJSON_AddStringToObject(root_obj.get(), "session_id", session_id_.c_str());
-  cJSON_AddStringToObject(root_obj.get(), "type", "abort");
-  cJSON_AddStringToObject(root_obj.get(), "reason", reason.c_str());
-  std::unique_ptr<char, decltype(&CJSONFree)> text(cJSON_PrintUnformatted(root_obj.get()), &CJSONFree);
-  const auto length = strlen(text.get());
-  CLOGI("sending text: %.*s", static_cast<int>(length), text.get());
-  esp_websocket_client_send_text(web_socket_client_, text.get(), length, pdMS_TO_TICKS(5000));
+  char message[kMaxMessageSize];
+  JsonWriter writer(message, sizeof(message));
+  writer.Add("session_id", session_id_).Add("type", "abort").Add("reason", reason.c_str());
+  LatencyTracker::GetInstance().Begin(LatencyStage::kAbortToSilence);
+  speaking_aborted_ = true;
+  pending_audio_frames_.clear();
+  if (audio_output_engine_) {
+    audio_output_engine_->Flush(kAbortFadeMs);
+  }
+  SendJson(writer);
 }
 
 bool EngineImpl::ConnectWebSocket() {
@@ -668,15 +1179,71 @@ bool EngineImpl::ConnectWebSocket() {
 }
 
 void EngineImpl::DisconnectWebSocket() {
-  audio_input_engine_.reset();
-  transmit_queue_.reset();
-  audio_output_engine_.reset();
+  StopListening();
+  ResetAudioOutput();
 #ifdef ARDUINO_ESP32S3_DEV
-  wake_net_.Start(audio_input_device_);
+  wake_net_.Start(audio_input_device_, scheduling_policy_.wake_net_feed, scheduling_policy_.wake_net_detect, placement_policy_.wake_net_stack);
 #endif
   esp_websocket_client_close(web_socket_client_, pdMS_TO_TICKS(5000));
 }
 
+void EngineImpl::CreateWebSocketClient() {
+  esp_websocket_client_config_t websocket_cfg;
+  memset(&websocket_cfg, 0, sizeof(websocket_cfg));
+  websocket_cfg.uri = websocket_url_.c_str();
+  websocket_cfg.task_name = kWebsocketTaskName;
+  websocket_cfg.task_stack = kWebsocketTaskStackSize;
+  websocket_cfg.task_prio = scheduling_policy_.websocket.priority;
+  websocket_cfg.task_pinned = scheduling_policy_.websocket.core_id >= 0 && scheduling_policy_.websocket.core_id < portNUM_PROCESSORS;
+  websocket_cfg.task_core_id = scheduling_policy_.websocket.core_id;
+  websocket_cfg.crt_bundle_attach = esp_crt_bundle_attach;
+  websocket_cfg.buffer_size = kWebsocketBufferSize;
+  websocket_cfg.buffer_caps = heap::Caps(placement_policy_.websocket_buffers);
+
+  CLOGI("url: %s", websocket_cfg.uri);
+  web_socket_client_ = esp_websocket_client_init(&websocket_cfg);
+  if (web_socket_client_ == nullptr) {
+    CLOGE("esp_websocket_client_init failed with %s", websocket_cfg.uri);
+    abort();
+  }
+  for (const auto &[key, value] : websocket_headers_) {
+    esp_websocket_client_append_header(web_socket_client_, key.c_str(), value.c_str());
+  }
+  esp_websocket_client_append_header(web_socket_client_, "Protocol-Version", "1");
+  esp_websocket_client_append_header(web_socket_client_, "Device-Id", GetMacAddress().c_str());
+  esp_websocket_client_append_header(web_socket_client_, "Client-Id", uuid_.c_str());
+  esp_websocket_register_events(web_socket_client_, WEBSOCKET_EVENT_ANY, &EngineImpl::OnWebsocketEvent, this);
+  // 缓冲区由组件内部分配, 按配置的大小记账: 收发缓冲区各一个, 加上首次发送时分配的整帧缓冲区;
+  // 客户端结构体和连接时创建的 websocket 任务栈不计入, 任务栈由资源监控统计
+  web_socket_client_size_ = kWebsocketBufferSize * 2 + kWebsocketBufferSize + ESP_WEBSOCKET_FRAME_MAX_HEADER_LEN;
+  heap::Account(HeapTag::kWebsocket, web_socket_client_size_);
+}
+
+// 释放 websocket 任务栈和收发缓冲区, 连接中的会话先正常关闭
+void EngineImpl::DestroyWebSocketClient() {
+  if (web_socket_client_ == nullptr) {
+    return;
+  }
+
+  if (esp_websocket_client_is_connected(web_socket_client_)) {
+    esp_websocket_client_close(web_socket_client_, pdMS_TO_TICKS(1000));
+  }
+  esp_websocket_client_destroy(web_socket_client_);
+  web_socket_client_ = nullptr;
+  heap::Account(HeapTag::kWebsocket, -web_socket_client_size_);
+  web_socket_client_size_ = 0;
+}
+
+void EngineImpl::RunInTaskQueue(std::function<void()> &&task) {
+  const auto semaphore = xSemaphoreCreateBinary();
+  task_queue_->Enqueue([semaphore, task = std::move(task)]() {
+    task();
+    xSemaphoreGive(semaphore);
+  });
+  xSemaphoreTake(semaphore, portMAX_DELAY);
+  vSemaphoreDelete(semaphore);
+}
+
 void EngineImpl::SendIotDescriptions() {
   const auto descirptions = iot_manager_.DescriptionsJson();
   for (const auto &descirption : descirptions) {
@@ -725,6 +1292,8 @@ void EngineImpl::ChangeState(const State new_state) {
         return ChatState::kListening;
       case State::kSpeaking:
         return ChatState::kSpeaking;
+      case State::kSuspended:
+        return ChatState::kIdle;
       default:
         return ChatState::kIdle;
     }
@@ -736,8 +1305,84 @@ void EngineImpl::ChangeState(const State new_state) {
     observer_->PushEvent(Observer::StateChangedEvent{chat_state_, new_chat_state});
   }
 
+  auto &latency_tracker = LatencyTracker::GetInstance();
+  switch (new_state) {
+    case State::kWebsocketConnecting:
+    case State::kWebsocketConnectingWithWakeup: {
+      latency_tracker.Begin(LatencyStage::kWakeToConnect);
+      break;
+    }
+    case State::kWebsocketConnected:
+    case State::kWebsocketConnectedWithWakeup: {
+      latency_tracker.End(LatencyStage::kWakeToConnect);
+      latency_tracker.Begin(LatencyStage::kConnectToHello);
+      break;
+    }
+    case State::kListening: {
+      latency_tracker.End(LatencyStage::kHelloToListen);
+      break;
+    }
+    case State::kSpeaking: {
+      latency_tracker.Begin(LatencyStage::kTtsStartToFirstPcm);
+      break;
+    }
+    default: {
+      break;
+    }
+  }
+
+  power_manager_.SetActive(NeedsFullSpeed(new_state));
   state_ = new_state;
   chat_state_ = new_chat_state;
 }
 
+bool EngineImpl::NeedsFullSpeed(const State state) const {
+  switch (state) {
+    case State::kIdle:
+    case State::kSuspended: {
+      return false;
+    }
+    case State::kStandby: {
+#ifdef ARDUINO_ESP32S3_DEV
+      // WakeNet 每 32 ms 处理一块音频, 降频会跟不上麦克风
+      return wake_net_.stats().running;
+#else
+      return false;
+#endif
+    }
+    default: {
+      return true;
+    }
+  }
+}
+
+void EngineImpl::ReportBootPhase(const BootPhase phase) {
+  if (phase != BootPhase::kEngineStart && phase <= boot_phase_) {
+    return;
+  }
+
+  boot_phase_ = phase;
+  const auto time_ms = static_cast<uint32_t>(esp_timer_get_time() / 1000);
+  CLOGI("boot phase %u: %" PRIu32 " ms", phase, time_ms);
+  if (observer_) {
+    observer_->PushEvent(Observer::BootEvent{phase, time_ms});
+  }
+}
+
+void EngineImpl::SampleResources() {
+  auto task_stats = resource_monitor_.Sample();
+  {
+    std::lock_guard lock(task_stats_mutex_);
+    task_stats_ = std::move(task_stats);
+  }
+  task_queue_->EnqueueAt(std::chrono::steady_clock::now() + std::chrono::milliseconds(resource_monitor_interval_ms_),
+                         [this]() { SampleResources(); });
+}
+
+void EngineImpl::ReportLatency() {
+  LatencyTracker::GetInstance().Dump();
+  task_queue_->EnqueueAt(std::chrono::steady_clock::now() + std::chrono::milliseconds(latency_report_interval_ms_),
+                         [this]() { ReportLatency(); });
+}
+
 }  // namespace ai_vox
\ No newline at end of file
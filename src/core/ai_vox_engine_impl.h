@@ -9,6 +9,7 @@
 
 #include <condition_variable>
 #include <cstdint>
+#include <functional>
 #include <list>
 #include <map>
 #include <memory>
@@ -18,15 +19,20 @@
 #include <vector>
 
 #include "ai_vox_engine.h"
+#include "earcon/earcon_partition.h"
 #include "espressif_esp_websocket_client/esp_websocket_client.h"
 #include "flex_array/flex_array.h"
 #include "iot/iot_manager.h"
+#include "power/power_manager.h"
+#include "resource_monitor/resource_monitor.h"
 #include "task_queue/task_queue.h"
+#include "vad/vad.h"
 #include "wake_net/wake_net.h"
 
 struct button_dev_t;
 class AudioInputEngine;
 class AudioOutputEngine;
+class JsonWriter;
 
 namespace ai_vox {
 
@@ -40,7 +46,28 @@ class EngineImpl : public Engine {
   void SetOtaUrl(const std::string url) override;
   void ConfigWebsocket(const std::string url, const std::map<std::string, std::string> headers) override;
   void RegisterIotEntity(std::shared_ptr<iot::Entity> entity) override;
+  void ConfigVad(const VadConfig &config) override;
+  void ConfigEncoder(const EncoderConfig &config) override;
+  void SetSchedulingPolicy(const SchedulingPolicy &policy) override;
+  void SetPlacementPolicy(const PlacementPolicy &policy) override;
+  void ConfigResourceMonitor(const uint32_t interval_ms) override;
+  void ConfigLatencyReport(const uint32_t interval_ms) override;
+  void ConfigEarcons(const std::string &partition_label) override;
+  void ConfigOfflineCommands(const OfflineCommandConfig &config) override;
+  void ConfigHeapBudget(const HeapTag tag, const size_t bytes) override;
+  void ConfigPower(const PowerConfig &config) override;
   void Start(std::shared_ptr<AudioInputDevice> audio_input_device, std::shared_ptr<AudioOutputDevice> audio_output_device) override;
+  void Stop() override;
+  void Suspend() override;
+  void Resume() override;
+  void Trigger() override;
+  void PlayEarcon(const std::string &name) override;
+  std::vector<TaskStats> GetTaskStats() const override;
+  LatencyStats GetLatencyStats() const override;
+  HeapStats GetHeapStats() const override;
+  WakeNetStats GetWakeNetStats() const override;
+  PowerStats GetPowerStats() const override;
+  void DumpTrace() override;
 
  private:
   enum class State {
@@ -54,6 +81,7 @@ class EngineImpl : public Engine {
     kStandby,
     kListening,
     kSpeaking,
+    kSuspended,  // 音频, 网络和唤醒模型均已释放, 只保留主任务和配置
   };
 
   static void OnButtonClick(void *button_handle, void *usr_data);
@@ -68,16 +96,39 @@ class EngineImpl : public Engine {
   void OnAudioOutputDataConsumed();
   void OnTriggered();
   void OnWakeUp();
+  void OnVadEvent(const Vad::Event event);
+  void OnPlayEarcon(const std::string &name);
+  void OnEarconPlayed(const std::weak_ptr<AudioOutputEngine> &audio_output_engine);
+  void NotifyReplyEnd();
+  void ResetAudioOutput();  // 释放输出引擎, 丢弃等待提示音播完的回复音频
+  void OnOfflineCommand(const int command, const float probability);
+  void OnSuspend();
+  void OnResume();
+  void OnBoot();
 
+  void LoadModels();
+  void WaitForNetwork();
   void LoadProtocol();
   void StartListening();
+  void StopListening();
+  void StartConversation();
+  void SendListenState(const char *state);
+  void SendJson(JsonWriter &writer);
   void AbortSpeaking();
   void AbortSpeaking(const std::string &reason);
+  void CreateWebSocketClient();
+  void DestroyWebSocketClient();
   bool ConnectWebSocket();
   void DisconnectWebSocket();
   void SendIotDescriptions();
   void SendIotUpdatedStates(const bool force);
   void ChangeState(const State new_state);
+  bool NeedsFullSpeed(const State state) const;
+  void SampleResources();
+  void ReportLatency();
+  void ReportBootPhase(const BootPhase phase);
+  // 在主任务中执行并等待完成, 不能在主任务中调用
+  void RunInTaskQueue(std::function<void()> &&task);
 
   mutable std::mutex mutex_;
   State state_ = State::kIdle;
@@ -89,19 +140,48 @@ class EngineImpl : public Engine {
   std::shared_ptr<Observer> observer_;
   ai_vox::iot::Manager iot_manager_;
   esp_websocket_client_handle_t web_socket_client_ = nullptr;
+  ptrdiff_t web_socket_client_size_ = 0;
   std::string uuid_;
-  std::string session_id_;
+  char session_id_[64] = {};  // 定长, 每轮对话的 hello 都会更新
+  bool protocol_loaded_ = false;
+  bool booting_ = false;  // Start 之后尚未第一次进入待命
+  BootPhase boot_phase_ = BootPhase::kEngineStart;  // 已上报的最后阶段, 重试时不重复上报
+  bool config_retry_pending_ = false;
   std::shared_ptr<AudioInputEngine> audio_input_engine_;
   std::shared_ptr<AudioOutputEngine> audio_output_engine_;
+  bool reply_pending_ = false;      // 提示音播完后才创建回复的输出引擎, 期间的下行音频暂存在 pending_audio_frames_
+  bool reply_end_pending_ = false;  // 暂存期间已收到 tts stop
+  std::vector<FlexArray<uint8_t>> pending_audio_frames_;
   std::string ota_url_;
   std::string websocket_url_;
   std::map<std::string, std::string> websocket_headers_;
+  VadConfig vad_config_;
+  bool vad_endpointed_ = false;
+  bool speaking_aborted_ = false;
+  EncoderConfig encoder_config_;
 #ifdef ARDUINO_ESP32S3_DEV
   WakeNet wake_net_;
 #endif
-  TaskQueue task_queue_;
+  SchedulingPolicy scheduling_policy_;
+  PlacementPolicy placement_policy_;
+  PowerConfig power_config_;
+  PowerManager power_manager_;
+  std::unique_ptr<TaskQueue> task_queue_;
   std::unique_ptr<TaskQueue> transmit_queue_;
+  ResourceMonitor resource_monitor_;
+  uint32_t resource_monitor_interval_ms_ = 0;
+  mutable std::mutex task_stats_mutex_;
+  std::vector<TaskStats> task_stats_;
+  uint32_t latency_report_interval_ms_ = 0;
+  std::string earcon_partition_label_;
+  EarconPartition earcon_partition_;
+  OfflineCommandConfig offline_command_config_;
+  std::vector<iot::Manager::OfflineCommand> offline_commands_;
+  bool offline_command_pending_ = false;  // 唤醒后的本地命令识别尚未结束
+  bool session_cancelled_ = false;        // 命令已在本地执行, 本次连接不再开始对话
   const uint32_t audio_frame_duration_ = 60;
+  uint32_t downlink_sample_rate_ = 24000;
+  uint32_t downlink_frame_duration_ = 60;
 };
 }  // namespace ai_vox
 
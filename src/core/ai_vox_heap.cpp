@@ -0,0 +1,300 @@
+#include "ai_vox_heap.h"
+
+#include <esp_heap_caps.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cinttypes>
+#include <cstring>
+#include <iterator>
+
+#define CLOGGER_MODULE HEAP
+
+#ifndef CLOGGER_SEVERITY
+#define CLOGGER_SEVERITY CLOGGER_SEVERITY_WARN
+#endif
+
+#include "clogger/clogger.h"
+
+#if AI_VOX_STATIC_ALLOCATION && defined(CONFIG_ESP_WS_CLIENT_ENABLE_DYNAMIC_BUFFER)
+#error "AI_VOX_STATIC_ALLOCATION: remove CONFIG_ESP_WS_CLIENT_ENABLE_DYNAMIC_BUFFER, it allocates the websocket buffers on every frame"
+#endif
+
+namespace ai_vox::heap {
+namespace {
+struct Header {
+  uint32_t size;
+  HeapTag tag;
+  MemoryRegion region;
+  uint8_t size_class;  // 仅静态区使用
+  uint8_t reserved;
+};
+
+static_assert(sizeof(Header) == 8, "keeps the alignment of heap_caps_malloc");
+
+struct Counter {
+  std::atomic<int32_t> current = 0;  // Account 的释放可能先于分配到达, 用有符号数
+  std::atomic<int32_t> peak = 0;
+  std::atomic<uint32_t> failures = 0;
+  std::atomic<uint32_t> budget = 0;
+  std::atomic<uint32_t> over_budget = 0;
+};
+
+Counter g_counters[static_cast<size_t>(HeapTag::kMax)];
+
+#if AI_VOX_STATIC_ALLOCATION
+// 块大小按 2 的幂分段, 每段再四等分, 最多浪费 25%; 释放的块只回到同级的空闲链表, 不合并也不拆分
+constexpr uint32_t kMinBlockShift = 5;
+constexpr uint32_t kMaxBlockShift = 20;
+constexpr size_t kMinBlockSize = size_t{1} << kMinBlockShift;
+constexpr size_t kSizeClassCount = (kMaxBlockShift - kMinBlockShift) * 4 + 1;
+
+alignas(8) uint8_t g_arena[AI_VOX_STATIC_HEAP_SIZE];
+size_t g_carved = 0;
+uint32_t g_carves = 0;
+uint32_t g_arena_failures = 0;
+void *g_free_blocks[kSizeClassCount] = {};
+portMUX_TYPE g_arena_lock = portMUX_INITIALIZER_UNLOCKED;
+
+size_t SizeClass(const size_t bytes) {
+  if (bytes <= kMinBlockSize) {
+    return 0;
+  }
+  const uint32_t shift = 31 - __builtin_clz(bytes - 1);
+  const size_t base = size_t{1} << shift;
+  const size_t quarter = base / 4;
+  return (shift - kMinBlockShift) * 4 + (bytes - base + quarter - 1) / quarter;
+}
+
+size_t BlockSize(const size_t size_class) {
+  if (size_class == 0) {
+    return kMinBlockSize;
+  }
+  const size_t base = size_t{1} << ((size_class - 1) / 4 + kMinBlockShift);
+  return base + ((size_class - 1) % 4 + 1) * (base / 4);
+}
+
+Header *ArenaAllocate(const size_t bytes) {
+  if (bytes > (size_t{1} << kMaxBlockShift)) {
+    return nullptr;
+  }
+
+  const auto size_class = SizeClass(bytes);
+  Header *header = nullptr;
+  taskENTER_CRITICAL(&g_arena_lock);
+  if (g_free_blocks[size_class] != nullptr) {
+    header = reinterpret_cast<Header *>(g_free_blocks[size_class]);
+    g_free_blocks[size_class] = *reinterpret_cast<void **>(header);
+  } else if (g_carved + BlockSize(size_class) <= sizeof(g_arena)) {
+    header = reinterpret_cast<Header *>(g_arena + g_carved);
+    g_carved += BlockSize(size_class);
+    g_carves++;
+  } else {
+    g_arena_failures++;
+  }
+  taskEXIT_CRITICAL(&g_arena_lock);
+
+  if (header != nullptr) {
+    header->size_class = size_class;
+  }
+  return header;
+}
+
+void ArenaFree(Header *header) {
+  const auto size_class = header->size_class;
+  taskENTER_CRITICAL(&g_arena_lock);
+  *reinterpret_cast<void **>(header) = g_free_blocks[size_class];
+  g_free_blocks[size_class] = header;
+  taskEXIT_CRITICAL(&g_arena_lock);
+}
+#endif
+
+Counter &GetCounter(const HeapTag tag) {
+  return g_counters[static_cast<size_t>(tag) < std::size(g_counters) ? static_cast<size_t>(tag) : 0];
+}
+
+void Add(const HeapTag tag, const int32_t bytes) {
+  auto &counter = GetCounter(tag);
+  const auto current = counter.current.fetch_add(bytes) + bytes;
+  auto peak = counter.peak.load();
+  while (current > peak && !counter.peak.compare_exchange_weak(peak, current)) {
+  }
+
+  // 只在跨过预算的那一次计数
+  const int32_t budget = counter.budget;
+  if (bytes > 0 && budget > 0 && current > budget && current - bytes <= budget) {
+    counter.over_budget++;
+    CLOGW("%s over budget: %" PRIi32 " > %" PRIi32 " bytes", TagName(tag), current, budget);
+  }
+}
+
+void Fail(const HeapTag tag, const size_t size, const uint32_t caps) {
+  GetCounter(tag).failures++;
+  CLOGE("%s: failed to allocate %zu bytes, largest free block: %zu", TagName(tag), size, heap_caps_get_largest_free_block(caps));
+}
+
+#if !AI_VOX_STATIC_ALLOCATION
+// PSRAM 不足时退回默认能力, 放置策略只影响位置, 不应让原本能成功的分配失败
+void *Allocate(const size_t size, const MemoryRegion region) {
+  const auto caps = Caps(region);
+  auto ptr = heap_caps_malloc(size, caps);
+  if (ptr == nullptr && caps != MALLOC_CAP_DEFAULT && region == MemoryRegion::kSpiram) {
+    ptr = heap_caps_malloc(size, MALLOC_CAP_DEFAULT);
+  }
+  return ptr;
+}
+#endif
+}  // namespace
+
+void *Malloc(const HeapTag tag, const size_t size, const MemoryRegion region) {
+#if AI_VOX_STATIC_ALLOCATION
+  auto header = ArenaAllocate(sizeof(Header) + size);
+#else
+  auto header = reinterpret_cast<Header *>(Allocate(sizeof(Header) + size, region));
+#endif
+  if (header == nullptr) {
+    Fail(tag, size, Caps(region));
+    return nullptr;
+  }
+
+  header->size = size;
+  header->tag = tag;
+  header->region = region;
+  Add(tag, size);
+  return header + 1;
+}
+
+void *Realloc(const HeapTag tag, void *ptr, const size_t size) {
+  if (ptr == nullptr) {
+    return Malloc(tag, size);
+  }
+
+  const auto old_header = reinterpret_cast<Header *>(ptr) - 1;
+  const auto old_size = old_header->size;
+  const auto old_tag = old_header->tag;
+  const auto region = old_header->region;
+#if AI_VOX_STATIC_ALLOCATION
+  // 缩小或仍在同一级时原地修改
+  auto header = old_header;
+  if (BlockSize(old_header->size_class) < sizeof(Header) + size) {
+    header = ArenaAllocate(sizeof(Header) + size);
+    if (header != nullptr) {
+      memcpy(header + 1, old_header + 1, std::min<size_t>(old_size, size));
+      ArenaFree(old_header);
+    }
+  }
+#else
+  auto header = reinterpret_cast<Header *>(heap_caps_realloc(old_header, sizeof(Header) + size, Caps(region)));
+  if (header == nullptr && region == MemoryRegion::kSpiram) {
+    header = reinterpret_cast<Header *>(heap_caps_realloc(old_header, sizeof(Header) + size, MALLOC_CAP_DEFAULT));
+  }
+#endif
+  if (header == nullptr) {
+    Fail(tag, size, Caps(region));
+    return nullptr;
+  }
+
+  Add(old_tag, -static_cast<int32_t>(old_size));
+  header->size = size;
+  header->tag = tag;
+  header->region = region;
+  Add(tag, size);
+  return header + 1;
+}
+
+void Free(void *ptr) {
+  if (ptr == nullptr) {
+    return;
+  }
+
+  const auto header = reinterpret_cast<Header *>(ptr) - 1;
+  Add(header->tag, -static_cast<int32_t>(header->size));
+#if AI_VOX_STATIC_ALLOCATION
+  ArenaFree(header);
+#else
+  heap_caps_free(header);
+#endif
+}
+
+void Account(const HeapTag tag, const ptrdiff_t bytes) {
+  Add(tag, bytes);
+}
+
+bool OverBudget(const HeapTag tag, const size_t extra) {
+  const auto &counter = GetCounter(tag);
+  const int64_t budget = counter.budget;
+  return budget > 0 && counter.current + static_cast<int64_t>(extra) > budget;
+}
+
+void SetBudget(const HeapTag tag, const size_t bytes) {
+  GetCounter(tag).budget = bytes;
+}
+
+StaticHeapStats StaticStats() {
+#if AI_VOX_STATIC_ALLOCATION
+  taskENTER_CRITICAL(&g_arena_lock);
+  const StaticHeapStats stats{sizeof(g_arena), g_carved, g_carves, g_arena_failures};
+  taskEXIT_CRITICAL(&g_arena_lock);
+  return stats;
+#else
+  return {};
+#endif
+}
+
+bool Owns(const void *ptr) {
+#if AI_VOX_STATIC_ALLOCATION
+  return ptr >= g_arena && ptr < g_arena + sizeof(g_arena);
+#else
+  return false;
+#endif
+}
+
+uint32_t Caps(const MemoryRegion region) {
+  switch (region) {
+    case MemoryRegion::kInternal:
+      return MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT;
+    case MemoryRegion::kSpiram:
+      return heap_caps_get_total_size(MALLOC_CAP_SPIRAM) > 0 ? MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT : MALLOC_CAP_DEFAULT;
+    default:
+      return MALLOC_CAP_DEFAULT;
+  }
+}
+
+HeapStats Stats() {
+  HeapStats stats{};
+  for (size_t i = 0; i < stats.size(); i++) {
+    const auto &counter = g_counters[i];
+    stats[i].current = std::max<int32_t>(counter.current, 0);
+    stats[i].peak = std::max<int32_t>(counter.peak, 0);
+    stats[i].failures = counter.failures;
+    stats[i].budget = counter.budget;
+    stats[i].over_budget = counter.over_budget;
+  }
+  return stats;
+}
+
+const char *TagName(const HeapTag tag) {
+  switch (tag) {
+    case HeapTag::kEngine:
+      return "engine";
+    case HeapTag::kAudioInput:
+      return "audio_input";
+    case HeapTag::kAudioOutput:
+      return "audio_output";
+    case HeapTag::kWebsocket:
+      return "websocket";
+    case HeapTag::kWakeNet:
+      return "wake_net";
+    case HeapTag::kIot:
+      return "iot";
+    case HeapTag::kObserver:
+      return "observer";
+    case HeapTag::kDisplay:
+      return "display";
+    default:
+      return "unknown";
+  }
+}
+}  // namespace ai_vox::heap
@@ -1,13 +1,20 @@
 #include "audio_input_engine.h"
 
+#include <esp_timer.h>
 #include <freertos/FreeRTOS.h>
 #include <freertos/task.h>
 
+#include <cstring>
+
+#define CLOGGER_MODULE AUDIO_INPUT
+
 #ifndef CLOGGER_SEVERITY
 #define CLOGGER_SEVERITY CLOGGER_SEVERITY_WARN
 #endif
 
 #include "clogger/clogger.h"
+#include "latency/latency_tracker.h"
+#include "trace/trace.h"
 
 #ifdef ARDUINO
 #include "libopus/opus.h"
@@ -21,24 +28,60 @@ constexpr uint32_t kFrameDuration = 20;                          // ms
 constexpr uint32_t kDefaultSampleRate = 16000;                   // Hz
 constexpr uint32_t kDefaultChannels = 1;                         // Mono
 constexpr size_t kMaxFrameSize = 16000 / 1000 * kFrameDuration;  // 16000 Hz * 20 ms
+
+// 取自 libopus/src/opus_private.h, 该头文件依赖 CELT 内部头文件, 无法直接包含
+// 私有请求不在 libopus 的兼容承诺之内, 升级 libopus 后须核对 OPUS_SET_FORCE_MODE_REQUEST 和 MODE_SILK_ONLY 的取值
+constexpr int kOpusSetForceModeRequest = 11002;
+constexpr int kOpusModeSilkOnly = 1000;
+
+int ToOpusBandwidth(const ai_vox::EncoderConfig::Bandwidth bandwidth) {
+  switch (bandwidth) {
+    case ai_vox::EncoderConfig::Bandwidth::kNarrowband:
+      return OPUS_BANDWIDTH_NARROWBAND;
+    case ai_vox::EncoderConfig::Bandwidth::kMediumband:
+      return OPUS_BANDWIDTH_MEDIUMBAND;
+    default:
+      return OPUS_BANDWIDTH_WIDEBAND;
+  }
+}
 }  // namespace
 
 AudioInputEngine::AudioInputEngine(std::shared_ptr<ai_vox::AudioInputDevice> audio_input_device,
                                    AudioInputEngine::DataHandler &&handler,
-                                   const uint32_t frame_duration)
-    : handler_(std::move(handler)), audio_input_device_(std::move(audio_input_device)) {
-  int error = 0;
-  opus_encoder_ = opus_encoder_create(kDefaultSampleRate, kDefaultChannels, OPUS_APPLICATION_VOIP, &error);
-  assert(opus_encoder_ != nullptr);
-  if (opus_encoder_ == nullptr) {
-    CLOG("opus_encoder_create failed: %d", error);
-    abort();
+                                   const uint32_t frame_duration,
+                                   const ai_vox::EncoderConfig &encoder_config,
+                                   const ai_vox::TaskConfig &task_config,
+                                   const ai_vox::PlacementPolicy &placement_policy,
+                                   std::unique_ptr<Vad> vad,
+                                   AudioInputEngine::VadHandler &&vad_handler,
+                                   AudioInputEngine::Source &&source)
+    : handler_(std::move(handler)),
+      vad_(std::move(vad)),
+      vad_handler_(std::move(vad_handler)),
+      source_(std::move(source)),
+      audio_reader_(std::move(audio_input_device), kDefaultSampleRate),
+      packet_region_(placement_policy.uplink_packets) {
+  // 编码器状态经带标签的分配器分配, 分配失败时不再 abort, 只是不采集
+  uint32_t stack_size = 32 << 10;
+  const auto encoder_size = opus_encoder_get_size(kDefaultChannels);
+  const bool over_budget = ai_vox::heap::OverBudget(ai_vox::HeapTag::kAudioInput, encoder_size + stack_size);
+  if (over_budget) {
+    CLOGW("over budget, falling back to the low memory encoder");
+  }
+
+  opus_encoder_ = reinterpret_cast<OpusEncoder *>(ai_vox::heap::Malloc(ai_vox::HeapTag::kAudioInput, encoder_size, placement_policy.codec));
+  const int error = opus_encoder_ != nullptr ? opus_encoder_init(opus_encoder_, kDefaultSampleRate, kDefaultChannels, OPUS_APPLICATION_VOIP)
+                                             : OPUS_ALLOC_FAIL;
+  if (error != OPUS_OK) {
+    CLOGE("opus_encoder_init failed: %d", error);
+    ai_vox::heap::Free(opus_encoder_);
+    opus_encoder_ = nullptr;
     return;
   }
 
-  uint32_t stack_size = 32 << 10;
   opus_encoder_ctl(opus_encoder_, OPUS_SET_DTX(1));
-  if (heap_caps_get_total_size(MALLOC_CAP_SPIRAM) == 0) {
+  if (heap_caps_get_total_size(MALLOC_CAP_SPIRAM) == 0 || over_budget) {
+    // 复杂度 0 时编码所需的栈也小得多
     opus_encoder_ctl(opus_encoder_, OPUS_SET_COMPLEXITY(0));
     opus_encoder_ctl(opus_encoder_, OPUS_SET_BITRATE(8000));
     stack_size = 20 << 10;
@@ -46,32 +89,95 @@ AudioInputEngine::AudioInputEngine(std::shared_ptr<ai_vox::AudioInputDevice> aud
     opus_encoder_ctl(opus_encoder_, OPUS_SET_COMPLEXITY(5));
   }
 
-  audio_input_device_->Open(kDefaultSampleRate);
-  task_queue_ = new TaskQueue("AudioInput", stack_size, tskIDLE_PRIORITY + 1);
-  task_queue_->Enqueue([this, samples = 16000 / 1000 * frame_duration]() { PullData(samples); });
+  if (encoder_config.mode == ai_vox::EncoderConfig::Mode::kLowPower) {
+    // DISABLE_FLOAT_API 下本就不做音调分析, 省下的是 SILK 的运算量: 降低编码带宽即降低 SILK 内部采样率
+    opus_encoder_ctl(opus_encoder_, OPUS_SET_COMPLEXITY(0));
+    opus_encoder_ctl(opus_encoder_, OPUS_SET_SIGNAL(OPUS_SIGNAL_VOICE));
+    opus_encoder_ctl(opus_encoder_, OPUS_SET_BANDWIDTH(ToOpusBandwidth(encoder_config.bandwidth)));
+    opus_encoder_ctl(opus_encoder_, kOpusSetForceModeRequest, kOpusModeSilkOnly);
+  }
+
+  const uint32_t samples = kDefaultSampleRate / 1000 * frame_duration;
+  pcm_ = std::make_unique<int16_t[]>(samples);
+  if (vad_) {
+    pre_roll_ = std::make_unique<int16_t[]>(samples);
+  }
+
+  if (!source_) {
+    audio_reader_.Open();
+    audio_reader_opened_ = true;
+  }
+  task_queue_ = new TaskQueue(
+      "AudioInput", stack_size, task_config.priority, task_config.core_id, ai_vox::HeapTag::kAudioInput, placement_policy.audio_input_stack);
+  task_queue_->Enqueue([this, samples]() { PullData(samples); });
   CLOGI("OK");
 }
 
 AudioInputEngine::~AudioInputEngine() {
-  delete task_queue_;
-  audio_input_device_->Close();
-  opus_encoder_destroy(opus_encoder_);
+  if (task_queue_ != nullptr) {
+    delete task_queue_;
+  }
+  if (audio_reader_opened_) {
+    audio_reader_.Close();
+  }
+  ai_vox::heap::Free(opus_encoder_);
   CLOG("OK");
 }
 
 void AudioInputEngine::PullData(const uint32_t samples) {
-  auto pcm = new int16_t[samples];
-  audio_input_device_->Read(pcm, samples);
+  TRACE_SCOPE(TraceEvent::kAudioInputPullData, samples, 0);
+  auto pcm = pcm_.get();
+  size_t offset = 0;
+  if (source_) {
+    offset = source_(pcm, samples);
+    if (offset < samples) {
+      // source 读完时麦克风已经释放, 帧的剩余部分接着从麦克风读取
+      source_ = nullptr;
+      audio_reader_.Open();
+      audio_reader_opened_ = true;
+    }
+  }
+  if (offset < samples) {
+    audio_reader_.Read(pcm + offset, samples - offset);
+  }
+
+  if (vad_) {
+    const auto event = vad_->Process(pcm, samples);
+    if (event != Vad::Event::kNone && vad_handler_) {
+      vad_handler_(event);
+    }
+
+    if (event == Vad::Event::kSpeechStart && pre_roll_valid_) {
+      // 补发语音起点前一帧, 避免首字被截断
+      Encode(pre_roll_.get(), samples);
+    }
+
+    pre_roll_valid_ = !vad_->voiced();
+    if (pre_roll_valid_) {
+      memcpy(pre_roll_.get(), pcm, samples * sizeof(pcm[0]));
+    } else {
+      Encode(pcm, samples);
+    }
+  } else {
+    Encode(pcm, samples);
+  }
+
+  task_queue_->Enqueue([this, samples]() { PullData(samples); });
+}
 
-  FlexArray<uint8_t> data(kMaxOpusPacketSize);
+void AudioInputEngine::Encode(const int16_t *pcm, const uint32_t samples) {
+  TRACE_SCOPE(TraceEvent::kAudioInputEncode, samples, 0);
+  FlexArray<uint8_t> data(kMaxOpusPacketSize, ai_vox::HeapTag::kAudioInput, packet_region_);
+  if (data.data() == nullptr) {
+    return;
+  }
+  const auto start_time = esp_timer_get_time();
   const auto ret = opus_encode(opus_encoder_, pcm, samples, data.data(), data.size());
+  LatencyTracker::GetInstance().Record(ai_vox::LatencyStage::kEncode, esp_timer_get_time() - start_time);
   if (ret > 0) {
     data.Resize(ret);
     handler_(std::move(data));
   } else {
     CLOGE("opus_encode failed with: %d", ret);
   }
-  delete[] pcm;
-
-  task_queue_->Enqueue([this, samples]() { PullData(samples); });
 }
\ No newline at end of file
@@ -10,26 +10,47 @@
 #include <memory>
 #include <vector>
 
+#include "../ai_vox_engine.h"
 #include "../audio_input_device.h"
 #include "flex_array/flex_array.h"
+#include "resampler/resampler.h"
 #include "task_queue/task_queue.h"
+#include "vad/vad.h"
 
 struct OpusDecoder;
 class AudioInputEngine {
  public:
   using DataHandler = std::function<void(FlexArray<uint8_t> &&)>;
+  using VadHandler = std::function<void(Vad::Event)>;
+  // 在麦克风之前读取的 16 kHz 音频, 如 WakeNet 捕获的唤醒后音频; 返回读到的样本数, 少于请求数表示已读完, 之后改从麦克风读取
+  using Source = std::function<size_t(int16_t *, size_t)>;
 
   AudioInputEngine(std::shared_ptr<ai_vox::AudioInputDevice> audio_input_device,
                    AudioInputEngine::DataHandler &&handler,
-                   const uint32_t frame_duration);
+                   const uint32_t frame_duration,
+                   const ai_vox::EncoderConfig &encoder_config,
+                   const ai_vox::TaskConfig &task_config,
+                   const ai_vox::PlacementPolicy &placement_policy,
+                   std::unique_ptr<Vad> vad = nullptr,
+                   AudioInputEngine::VadHandler &&vad_handler = nullptr,
+                   AudioInputEngine::Source &&source = nullptr);
   ~AudioInputEngine();
 
  private:
   void PullData(const uint32_t samples);
+  void Encode(const int16_t *pcm, const uint32_t samples);
 
   const DataHandler handler_;
-  std::shared_ptr<ai_vox::AudioInputDevice> audio_input_device_;
+  std::unique_ptr<Vad> vad_;
+  const VadHandler vad_handler_;
+  std::unique_ptr<int16_t[]> pcm_;
+  std::unique_ptr<int16_t[]> pre_roll_;
+  bool pre_roll_valid_ = false;
+  Source source_;  // 仅在采集任务中访问
+  ResamplingAudioReader audio_reader_;
+  bool audio_reader_opened_ = false;
   struct OpusEncoder *opus_encoder_ = nullptr;
+  const ai_vox::MemoryRegion packet_region_;
   TaskQueue *task_queue_ = nullptr;
 };
 
@@ -1,9 +1,18 @@
 #include "audio_output_engine.h"
 
+#include <esp_timer.h>
+
+#include <algorithm>
+#include <cinttypes>
+
+#define CLOGGER_MODULE AUDIO_OUTPUT
+
 #ifndef CLOGGER_SEVERITY
 #define CLOGGER_SEVERITY CLOGGER_SEVERITY_WARN
 #endif
 #include "clogger/clogger.h"
+#include "latency/latency_tracker.h"
+#include "trace/trace.h"
 
 #ifdef ARDUINO
 #include "libopus/opus.h"
@@ -12,43 +21,192 @@
 #endif
 
 namespace {
-constexpr uint32_t kDefaultSampleRate = 24000;
 constexpr uint32_t kDefaultChannels = 1;
-constexpr uint32_t kDefaultDurationMs = 20;  // Duration in milliseconds
-constexpr uint32_t kDefaultFrameSize = kDefaultSampleRate / 1000 * kDefaultChannels * kDefaultDurationMs;
+constexpr uint32_t kWriteChunkMs = 10;  // 分段写入设备, Flush 最多等待一段
+constexpr size_t kOverBudgetQueueSize = 3;  // 超出内存预算时待播放队列的上限, 约 180 ms
+
+bool IsOpusSampleRate(const uint32_t sample_rate) {
+  switch (sample_rate) {
+    case 8000:
+    case 12000:
+    case 16000:
+    case 24000:
+    case 48000:
+      return true;
+    default:
+      return false;
+  }
+}
 }  // namespace
 
-AudioOutputEngine::AudioOutputEngine(std::shared_ptr<ai_vox::AudioOutputDevice> audio_output_device, const uint32_t frame_duration)
-    : audio_output_device_(std::move(audio_output_device)), samples_(kDefaultSampleRate / 1000 * kDefaultChannels * frame_duration) {
-  int error = -1;
-  opus_decoder_ = opus_decoder_create(kDefaultSampleRate, kDefaultChannels, &error);
-  assert(opus_decoder_ != nullptr);
-  audio_output_device_->Open(kDefaultSampleRate);
+AudioOutputEngine::AudioOutputEngine(std::shared_ptr<ai_vox::AudioOutputDevice> audio_output_device,
+                                     const uint32_t sample_rate,
+                                     const uint32_t frame_duration,
+                                     const ai_vox::TaskConfig& task_config,
+                                     const ai_vox::PlacementPolicy& placement_policy)
+    : audio_output_device_(std::move(audio_output_device)), sample_rate_(sample_rate), frame_duration_(frame_duration) {
+  // Opus 解码器可以直接输出 8/12/16/24/48 kHz 中的任意一种, 设备原生采样率属于其中时直接按该采样率解码, 省掉重采样
+  const auto native_sample_rate = audio_output_device_->native_sample_rate();
+  uint32_t decode_sample_rate = sample_rate;
+  if (native_sample_rate != 0 && IsOpusSampleRate(native_sample_rate)) {
+    decode_sample_rate = native_sample_rate;
+  } else if (native_sample_rate != 0) {
+    resampler_ = std::make_unique<Resampler>(sample_rate, native_sample_rate);
+  }
+
+  decode_sample_rate_ = decode_sample_rate;
+  samples_ = decode_sample_rate / 1000 * kDefaultChannels * frame_duration;
+  if (resampler_) {
+    // 每帧输出样本数在 samples_ * 倍率上下浮动 1 个
+    resampled_.resize(static_cast<uint64_t>(samples_) * native_sample_rate / decode_sample_rate + 2);
+  }
+
+  pcm_ = std::make_unique<int16_t[]>(samples_);
+  opus_decoder_ = reinterpret_cast<OpusDecoder*>(
+      ai_vox::heap::Malloc(ai_vox::HeapTag::kAudioOutput, opus_decoder_get_size(kDefaultChannels), placement_policy.codec));
+  const int error = opus_decoder_ != nullptr ? opus_decoder_init(opus_decoder_, decode_sample_rate, kDefaultChannels) : OPUS_ALLOC_FAIL;
+  if (error != OPUS_OK) {
+    // 不 abort, 之后收到的数据全部丢弃
+    CLOGE("opus_decoder_init failed: %d", error);
+    ai_vox::heap::Free(opus_decoder_);
+    opus_decoder_ = nullptr;
+  }
+  device_sample_rate_ = native_sample_rate != 0 ? native_sample_rate : decode_sample_rate;
+  audio_output_device_->Open(device_sample_rate_);
+  CLOGI("stream: %" PRIu32 " Hz, decode: %" PRIu32 " Hz, device: %" PRIu32 " Hz", sample_rate, decode_sample_rate, native_sample_rate);
 
   uint32_t stack_size = 9 << 10;
-  task_queue_ = new TaskQueue("AudioOutput", stack_size, tskIDLE_PRIORITY + 1);
+  task_queue_ = new TaskQueue(
+      "AudioOutput", stack_size, task_config.priority, task_config.core_id, ai_vox::HeapTag::kAudioOutput, placement_policy.audio_output_stack);
   CLOGI("OK");
 }
 
 AudioOutputEngine::~AudioOutputEngine() {
   delete task_queue_;
   audio_output_device_->Close();
-  opus_decoder_destroy(opus_decoder_);
+  ai_vox::heap::Free(opus_decoder_);
 }
 
 void AudioOutputEngine::Write(FlexArray<uint8_t>&& data) {
-  task_queue_->Enqueue([this, data = std::move(data)]() mutable { ProcessData(std::move(data)); });
+  // 排队的数据包计入 kAudioOutput, 超出预算时缩短队列, 宁可丢帧也不耗尽内存
+  if (task_queue_->Size() >= kOverBudgetQueueSize && ai_vox::heap::OverBudget(ai_vox::HeapTag::kAudioOutput)) {
+    CLOGW("over budget, dropping %zu bytes", data.size());
+    return;
+  }
+
+  task_queue_->Enqueue([this, data = std::move(data), generation = generation_.load()]() mutable { ProcessData(std::move(data), generation); });
 }
 
 void AudioOutputEngine::NotifyDataEnd(std::function<void()>&& callback) {
   task_queue_->Enqueue(std::move(callback));
 }
 
-void AudioOutputEngine::ProcessData(FlexArray<uint8_t>&& data) {
-  auto pcm = new int16_t[samples_];
+void AudioOutputEngine::Play(const uint8_t* clip, const size_t size) {
+  task_queue_->Enqueue([this, clip, size, generation = generation_.load()]() { PlayClip(clip, size, generation); });
+}
+
+void AudioOutputEngine::Flush(const uint32_t fade_ms) {
+  fade_ms_ = fade_ms;
+  const auto generation = ++generation_;
+  task_queue_->Enqueue([this, generation]() { Silence(generation); });
+  CLOGI("generation: %" PRIu32, generation);
+}
+
+void AudioOutputEngine::ProcessData(FlexArray<uint8_t>&& data, const uint32_t generation) {
+  if (generation != generation_ || opus_decoder_ == nullptr) {
+    return;
+  }
+
+  TRACE_SCOPE(TraceEvent::kAudioOutputProcessData, data.size(), 0);
+  auto& latency_tracker = LatencyTracker::GetInstance();
+  auto pcm = pcm_.get();
+  const auto decode_start_time = esp_timer_get_time();
   const auto ret = opus_decode(opus_decoder_, data.data(), data.size(), pcm, samples_, 0);
+  const auto write_start_time = esp_timer_get_time();
+  latency_tracker.Record(ai_vox::LatencyStage::kDecode, write_start_time - decode_start_time);
   if (ret >= 0) {
-    audio_output_device_->Write(pcm, samples_);
+    Output(pcm, ret, generation);
+    latency_tracker.Record(ai_vox::LatencyStage::kWrite, esp_timer_get_time() - write_start_time);
+    latency_tracker.End(ai_vox::LatencyStage::kTtsStartToFirstPcm);
   }
-  delete[] pcm;
-}
\ No newline at end of file
+}
+
+void AudioOutputEngine::PlayClip(const uint8_t* data, const size_t size, const uint32_t generation) {
+  if (opus_decoder_ == nullptr) {
+    return;
+  }
+
+  // 片段与下行音频共用解码器, 前后各复位一次, 互不影响
+  opus_decoder_ctl(opus_decoder_, OPUS_RESET_STATE);
+  std::vector<int16_t> pcm;
+  size_t offset = 0;
+  while (offset + 2 <= size && generation == generation_) {
+    const size_t length = data[offset] | (data[offset + 1] << 8);
+    offset += 2;
+    if (length > size - offset) {
+      CLOGE("truncated clip");
+      break;
+    }
+
+    const auto samples = opus_packet_get_nb_samples(data + offset, length, decode_sample_rate_);
+    if (samples > 0) {
+      pcm.resize(samples);
+      const auto ret = opus_decode(opus_decoder_, data + offset, length, pcm.data(), samples, 0);
+      if (ret > 0) {
+        Output(pcm.data(), ret, generation);
+      }
+    }
+    offset += length;
+  }
+  opus_decoder_ctl(opus_decoder_, OPUS_RESET_STATE);
+}
+
+void AudioOutputEngine::Output(int16_t* pcm, const size_t samples, const uint32_t generation) {
+  if (!resampler_) {
+    WritePcm(pcm, samples, generation);
+    return;
+  }
+
+  // 输出缓冲按下行帧长分配, 更长的片段帧分多次取出, 剩余输入留在重采样器中
+  auto count = resampler_->Process(pcm, samples, resampled_.data(), resampled_.size());
+  while (count > 0 && generation == generation_) {
+    WritePcm(resampled_.data(), count, generation);
+    count = resampler_->Process(nullptr, 0, resampled_.data(), resampled_.size());
+  }
+}
+
+void AudioOutputEngine::WritePcm(int16_t* pcm, const size_t samples, const uint32_t generation) {
+  const size_t chunk_samples = device_sample_rate_ / 1000 * kWriteChunkMs;
+  size_t offset = 0;
+  while (offset < samples) {
+    if (generation != generation_) {
+      if (flushed_generation_ == generation_) {
+        return;
+      }
+
+      // 先清空 DMA 中排队的数据, 再用本帧接下来的一小段线性淡出, 避免直接截断产生爆音
+      audio_output_device_->Clear();
+      const size_t fade_samples = std::min<size_t>(samples - offset, device_sample_rate_ / 1000 * fade_ms_);
+      for (size_t i = 0; i < fade_samples; i++) {
+        pcm[offset + i] = static_cast<int32_t>(pcm[offset + i]) * static_cast<int32_t>(fade_samples - i) / static_cast<int32_t>(fade_samples);
+      }
+      audio_output_device_->Write(pcm + offset, fade_samples);
+      flushed_generation_ = generation_;
+      LatencyTracker::GetInstance().End(ai_vox::LatencyStage::kAbortToSilence);
+      return;
+    }
+
+    const auto count = std::min(chunk_samples, samples - offset);
+    audio_output_device_->Write(pcm + offset, count);
+    offset += count;
+  }
+}
+
+void AudioOutputEngine::Silence(const uint32_t generation) {
+  // 正在播放的帧已经淡出时不再清空, 否则会把淡出的尾巴也丢掉
+  if (flushed_generation_ != generation) {
+    audio_output_device_->Clear();
+    flushed_generation_ = generation;
+  }
+  LatencyTracker::GetInstance().End(ai_vox::LatencyStage::kAbortToSilence);
+}
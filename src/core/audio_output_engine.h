@@ -4,6 +4,7 @@
 #include <freertos/FreeRTOS.h>
 #include <freertos/task.h>
 
+#include <atomic>
 #include <condition_variable>
 #include <functional>
 #include <list>
@@ -11,26 +12,61 @@
 #include <thread>
 #include <vector>
 
+#include "../ai_vox_engine.h"
 #include "../audio_output_device.h"
 #include "flex_array/flex_array.h"
+#include "resampler/resampler.h"
 #include "task_queue/task_queue.h"
 
 class OpusDecoder;
 class AudioOutputEngine {
  public:
-  AudioOutputEngine(std::shared_ptr<ai_vox::AudioOutputDevice> audio_output_device, const uint32_t frame_duration);
+  AudioOutputEngine(std::shared_ptr<ai_vox::AudioOutputDevice> audio_output_device,
+                    const uint32_t sample_rate,
+                    const uint32_t frame_duration,
+                    const ai_vox::TaskConfig& task_config,
+                    const ai_vox::PlacementPolicy& placement_policy);
   ~AudioOutputEngine();
 
   void Write(FlexArray<uint8_t>&& data);
   void NotifyDataEnd(std::function<void()>&& callback);
+  // 播放本地 Opus 片段, 格式为连续的 [uint16_t 小端长度][Opus 数据包], 帧长不限
+  // 不做拷贝, clip 必须在播放结束前保持有效, 通常指向 esp_partition_mmap 映射的分区
+  void Play(const uint8_t* clip, const size_t size);
+  // 丢弃尚未播放的数据: 队列中的数据包直接跳过, 正在播放的帧在 fade_ms 内淡出, 设备 DMA 中的数据被清空
+  // 之后 Write 的数据正常播放, NotifyDataEnd 的回调不受影响
+  void Flush(const uint32_t fade_ms);
+
+  // 构造时的下行参数, 用于判断提示音的临时引擎能否直接用于回复
+  uint32_t sample_rate() const {
+    return sample_rate_;
+  }
+
+  uint32_t frame_duration() const {
+    return frame_duration_;
+  }
 
  private:
   static void Loop(void* self);
   void Loop();
-  void ProcessData(FlexArray<uint8_t>&& data);
+  void ProcessData(FlexArray<uint8_t>&& data, const uint32_t generation);
+  void PlayClip(const uint8_t* data, const size_t size, const uint32_t generation);
+  void Output(int16_t* pcm, const size_t samples, const uint32_t generation);
+  void WritePcm(int16_t* pcm, const size_t samples, const uint32_t generation);
+  void Silence(const uint32_t generation);
 
   std::shared_ptr<ai_vox::AudioOutputDevice> audio_output_device_;
+  const uint32_t sample_rate_;
+  const uint32_t frame_duration_;
   struct OpusDecoder* opus_decoder_ = nullptr;
   TaskQueue* task_queue_ = nullptr;
-  const uint32_t samples_ = 0;
+  std::unique_ptr<Resampler> resampler_;
+  std::unique_ptr<int16_t[]> pcm_;
+  std::vector<int16_t> resampled_;
+  uint32_t samples_ = 0;
+  uint32_t decode_sample_rate_ = 0;
+  uint32_t device_sample_rate_ = 0;
+  std::atomic<uint32_t> generation_ = 0;
+  std::atomic<uint32_t> fade_ms_ = 0;
+  uint32_t flushed_generation_ = 0;
 };
\ No newline at end of file
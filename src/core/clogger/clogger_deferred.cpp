@@ -0,0 +1,229 @@
+#ifdef ARDUINO_ARCH_ESP32
+
+#include "clogger.h"
+
+#if CLOGGER_DEFERRED
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/ringbuf.h>
+#include <freertos/task.h>
+
+#include <atomic>
+#include <cstdio>
+#include <ctime>
+
+namespace {
+constexpr size_t kMaxLineLength = 512;
+constexpr uint32_t kTaskStackSize = 4 << 10;
+
+class Writer {
+ public:
+  static Writer &GetInstance() {
+    static Writer s_instance;
+    return s_instance;
+  }
+
+  void Push(const uint8_t *data, const size_t size) {
+    if (ring_buffer_ == nullptr || xRingbufferSend(ring_buffer_, data, size, 0) != pdTRUE) {
+      dropped_.fetch_add(1, std::memory_order_relaxed);
+    }
+  }
+
+ private:
+  Writer() : ring_buffer_(xRingbufferCreate(CLOGGER_DEFERRED_BUFFER_SIZE, RINGBUF_TYPE_NOSPLIT)) {
+    if (ring_buffer_ != nullptr) {
+      xTaskCreate(&Loop, "Clogger", kTaskStackSize, this, tskIDLE_PRIORITY, nullptr);
+    }
+  }
+
+  static void Loop(void *self) {
+    reinterpret_cast<Writer *>(self)->Loop();
+  }
+
+  void Loop() {
+    while (true) {
+      size_t size = 0;
+      auto *item = reinterpret_cast<uint8_t *>(xRingbufferReceive(ring_buffer_, &size, portMAX_DELAY));
+      if (item == nullptr) {
+        continue;
+      }
+
+      const auto dropped = dropped_.exchange(0, std::memory_order_relaxed);
+      if (dropped > 0) {
+        printf("clogger: %" PRIu32 " records dropped\n", dropped);
+      }
+
+      Print(item, size);
+      vRingbufferReturnItem(ring_buffer_, item);
+    }
+  }
+
+  void Print(const uint8_t *data, const size_t size) {
+    ClogDeferred::Header header;
+    if (size < sizeof(header)) {
+      return;
+    }
+    memcpy(&header, data, sizeof(header));
+
+    const auto time_sec = static_cast<time_t>(header.time_us / 1000000);
+    const auto ms = static_cast<int>(header.time_us / 1000 % 1000);
+    std::tm tm;
+    localtime_r(&time_sec, &tm);
+
+    int length = snprintf(line_,
+                          sizeof(line_),
+                          "%02d:%02d:%02d.%03d %c %s:%" PRIu32 " %s] ",
+                          tm.tm_hour,
+                          tm.tm_min,
+                          tm.tm_sec,
+                          ms,
+                          Clogger::SeverityToChar(header.severity),
+                          header.file_name,
+                          header.line_num,
+                          header.function);
+    length = std::min<int>(std::max(length, 0), sizeof(line_) - 1);
+    length += Format(header.fmt, data + sizeof(header), data + size, line_ + length, sizeof(line_) - length);
+    if (length >= static_cast<int>(sizeof(line_) - 1)) {
+      line_[sizeof(line_) - 2] = '\n';  // 截断时保留换行
+      length = sizeof(line_) - 1;
+    }
+    fwrite(line_, 1, length, stdout);
+  }
+
+  // 逐个解析格式说明符, 按记录中的参数类型重写长度修饰后单独格式化
+  static size_t Format(const char *fmt, const uint8_t *args, const uint8_t *args_end, char *output, const size_t capacity) {
+    size_t length = 0;
+    auto append = [&](const int written) {
+      if (written > 0) {
+        length = std::min(length + written, capacity - 1);
+      }
+    };
+
+    auto next_arg = [&](ClogDeferred::ArgType &type, const uint8_t *&value) {
+      if (args >= args_end) {
+        return false;
+      }
+      type = static_cast<ClogDeferred::ArgType>(*args++);
+      value = args;
+      switch (type) {
+        case ClogDeferred::ArgType::kInt32:
+          args += sizeof(uint32_t);
+          break;
+        case ClogDeferred::ArgType::kInt64:
+        case ClogDeferred::ArgType::kDouble:
+          args += sizeof(uint64_t);
+          break;
+        case ClogDeferred::ArgType::kPointer:
+          args += sizeof(uintptr_t);
+          break;
+        case ClogDeferred::ArgType::kString:
+          args += strnlen(reinterpret_cast<const char *>(args), args_end - args) + 1;
+          break;
+      }
+      return args <= args_end;
+    };
+
+    auto read_int64 = [](const ClogDeferred::ArgType type, const uint8_t *value) -> int64_t {
+      if (type == ClogDeferred::ArgType::kInt32) {
+        int32_t result;
+        memcpy(&result, value, sizeof(result));
+        return result;
+      } else if (type == ClogDeferred::ArgType::kInt64) {
+        int64_t result;
+        memcpy(&result, value, sizeof(result));
+        return result;
+      }
+      return 0;
+    };
+
+    while (*fmt != '\0' && length < capacity - 1) {
+      if (*fmt != '%') {
+        output[length++] = *fmt++;
+        continue;
+      }
+
+      if (fmt[1] == '%') {
+        output[length++] = '%';
+        fmt += 2;
+        continue;
+      }
+
+      char spec[32] = {'%'};
+      size_t spec_length = 1;
+      ++fmt;
+      while (*fmt != '\0' && strchr("-+ #0123456789.*", *fmt) != nullptr && spec_length < sizeof(spec) - 16) {
+        if (*fmt == '*') {
+          ClogDeferred::ArgType type;
+          const uint8_t *value = nullptr;
+          if (!next_arg(type, value)) {
+            return length;
+          }
+          spec_length += snprintf(spec + spec_length, sizeof(spec) - spec_length, "%d", static_cast<int>(read_int64(type, value)));
+        } else {
+          spec[spec_length++] = *fmt;
+        }
+        ++fmt;
+      }
+      while (*fmt != '\0' && strchr("hlLqjzt", *fmt) != nullptr) {
+        ++fmt;
+      }
+      const char conversion = *fmt;
+      if (conversion == '\0') {
+        break;
+      }
+      ++fmt;
+
+      ClogDeferred::ArgType type;
+      const uint8_t *value = nullptr;
+      if (!next_arg(type, value)) {
+        break;
+      }
+
+      char *const out = output + length;
+      const size_t remaining = capacity - length;
+      if (strchr("diouxXc", conversion) != nullptr) {
+        if (type == ClogDeferred::ArgType::kInt64) {
+          spec[spec_length++] = 'l';
+          spec[spec_length++] = 'l';
+          spec[spec_length++] = conversion;
+          append(snprintf(out, remaining, spec, static_cast<long long>(read_int64(type, value))));
+        } else if (conversion == 'd' || conversion == 'i' || conversion == 'c') {
+          spec[spec_length++] = conversion;
+          append(snprintf(out, remaining, spec, static_cast<int>(read_int64(type, value))));
+        } else {
+          spec[spec_length++] = conversion;
+          append(snprintf(out, remaining, spec, static_cast<unsigned int>(read_int64(type, value))));
+        }
+      } else if (strchr("fFeEgGaA", conversion) != nullptr && type == ClogDeferred::ArgType::kDouble) {
+        double number;
+        memcpy(&number, value, sizeof(number));
+        spec[spec_length++] = conversion;
+        append(snprintf(out, remaining, spec, number));
+      } else if (conversion == 's' && type == ClogDeferred::ArgType::kString) {
+        spec[spec_length++] = conversion;
+        append(snprintf(out, remaining, spec, reinterpret_cast<const char *>(value)));
+      } else if (conversion == 'p' && type == ClogDeferred::ArgType::kPointer) {
+        uintptr_t pointer;
+        memcpy(&pointer, value, sizeof(pointer));
+        spec[spec_length++] = conversion;
+        append(snprintf(out, remaining, spec, reinterpret_cast<void *>(pointer)));
+      } else {
+        append(snprintf(out, remaining, "<?%c>", conversion));
+      }
+    }
+    return length;
+  }
+
+  RingbufHandle_t ring_buffer_ = nullptr;
+  std::atomic<uint32_t> dropped_ = 0;
+  char line_[kMaxLineLength];
+};
+}  // namespace
+
+void ClogDeferred::Commit(const uint8_t *data, const size_t size) {
+  Writer::GetInstance().Push(data, size);
+}
+
+#endif  // CLOGGER_DEFERRED
+
+#endif  // ARDUINO_ARCH_ESP32
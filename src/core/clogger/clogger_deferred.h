@@ -0,0 +1,117 @@
+#pragma once
+
+#ifndef __CLOGGER_DEFERRED_H__
+#define __CLOGGER_DEFERRED_H__
+
+#include <stdint.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <type_traits>
+
+// 延迟日志缓冲区大小 (字节)
+#ifndef CLOGGER_DEFERRED_BUFFER_SIZE
+#define CLOGGER_DEFERRED_BUFFER_SIZE (4096)
+#endif
+
+// 单条日志记录最大长度 (字节), 超出部分的字符串参数会被截断
+#ifndef CLOGGER_DEFERRED_RECORD_SIZE
+#define CLOGGER_DEFERRED_RECORD_SIZE (256)
+#endif
+
+// 调用处只保存格式串指针和原始参数, 由低优先级任务完成时间转换与格式化
+class ClogDeferred {
+ public:
+  enum class ArgType : uint8_t {
+    kInt32,
+    kInt64,
+    kDouble,
+    kPointer,
+    kString,
+  };
+
+  struct Header {
+    int64_t time_us;
+    const char *file_name;
+    const char *function;
+    const char *fmt;
+    uint32_t line_num;
+    uint8_t severity;
+  };
+
+  template <typename... Args>
+  static void Log(const int32_t severity, const char *file_name, const uint32_t line_num, const char *function, const char *fmt, const Args &...args) {
+    Record record;
+    const Header header = {
+        std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::system_clock::now().time_since_epoch()).count(),
+        file_name,
+        function,
+        fmt,
+        line_num,
+        static_cast<uint8_t>(severity),
+    };
+    record.Append(&header, sizeof(header));
+    (record.Push(args), ...);
+    Commit(record.data, record.size);
+  }
+
+ private:
+  struct Record {
+    uint8_t data[CLOGGER_DEFERRED_RECORD_SIZE];
+    size_t size = 0;
+
+    bool Append(const void *value, const size_t length) {
+      if (size + length > sizeof(data)) {
+        return false;
+      }
+      memcpy(data + size, value, length);
+      size += length;
+      return true;
+    }
+
+    template <typename T>
+    void PushValue(const ArgType type, const T value) {
+      if (size + 1 + sizeof(value) <= sizeof(data)) {
+        data[size++] = static_cast<uint8_t>(type);
+        Append(&value, sizeof(value));
+      }
+    }
+
+    void PushString(const char *value) {
+      if (value == nullptr) {
+        value = "(null)";
+      }
+      if (size + 2 > sizeof(data)) {
+        return;
+      }
+      data[size++] = static_cast<uint8_t>(ArgType::kString);
+      const auto length = std::min(strlen(value), sizeof(data) - size - 1);
+      Append(value, length);
+      data[size++] = '\0';
+    }
+
+    template <typename T>
+    void Push(const T &value) {
+      using Type = std::decay_t<T>;
+      if constexpr (std::is_same_v<Type, char *> || std::is_same_v<Type, const char *>) {
+        PushString(value);
+      } else if constexpr (std::is_pointer_v<Type>) {
+        PushValue(ArgType::kPointer, reinterpret_cast<uintptr_t>(value));
+      } else if constexpr (std::is_floating_point_v<Type>) {
+        PushValue(ArgType::kDouble, static_cast<double>(value));
+      } else if constexpr (std::is_enum_v<Type>) {
+        Push(static_cast<std::underlying_type_t<Type>>(value));
+      } else if constexpr (std::is_integral_v<Type> && sizeof(Type) <= sizeof(int32_t)) {
+        PushValue(ArgType::kInt32, static_cast<uint32_t>(value));
+      } else {
+        static_assert(std::is_integral_v<Type>, "unsupported clogger argument type");
+        PushValue(ArgType::kInt64, static_cast<uint64_t>(value));
+      }
+    }
+  };
+
+  static void Commit(const uint8_t *data, const size_t size);
+};
+
+#endif
@@ -19,10 +19,31 @@
 #define CLOGGER_SEVERITY_FATAL (6)
 #define CLOGGER_SEVERITY_NONE (7)
 
+#define CLOGGER_CONCAT_INNER(a, b) a##b
+#define CLOGGER_CONCAT(a, b) CLOGGER_CONCAT_INNER(a, b)
+
+// 模块级日志等级: 源文件定义 CLOGGER_MODULE (如 AUDIO_INPUT) 后, 可通过 -D CLOGGER_SEVERITY_AUDIO_INPUT=x 单独覆盖该模块的等级
+#ifdef CLOGGER_MODULE
+#if CLOGGER_CONCAT(CLOGGER_SEVERITY_, CLOGGER_MODULE) > 0
+#undef CLOGGER_SEVERITY
+#define CLOGGER_SEVERITY CLOGGER_CONCAT(CLOGGER_SEVERITY_, CLOGGER_MODULE)
+#endif
+#endif
+
 #ifndef CLOGGER_SEVERITY
 #define CLOGGER_SEVERITY CLOGGER_SEVERITY_INFO
 #endif
 
+// -D CLOGGER_DEFERRED=1 时日志在调用处只入队, 由低优先级任务格式化输出
+#ifndef CLOGGER_DEFERRED
+#define CLOGGER_DEFERRED (0)
+#endif
+
+// 延迟模式下不低于该等级的日志仍同步输出, 保证 abort 前的错误信息不丢失
+#ifndef CLOGGER_DEFERRED_SYNC_SEVERITY
+#define CLOGGER_DEFERRED_SYNC_SEVERITY CLOGGER_SEVERITY_ERROR
+#endif
+
 class Clogger {
  public:
   static constexpr char SeverityToChar(const int severity) {
@@ -95,46 +116,56 @@ class Clogger {
   }
 };
 
+#if CLOGGER_DEFERRED
+#include "clogger_deferred.h"
+
+#define CLOGGER_LOG(severity, fmt, ...)                                                                                         \
+  do {                                                                                                                          \
+    if (severity >= CLOGGER_DEFERRED_SYNC_SEVERITY) {                                                                           \
+      Clogger::Log(severity, __FILE__ + Clogger::FileNameOffset(__FILE__), __LINE__, __FUNCTION__, fmt "\n", ##__VA_ARGS__);      \
+    } else {                                                                                                                    \
+      ClogDeferred::Log(severity, __FILE__ + Clogger::FileNameOffset(__FILE__), __LINE__, __FUNCTION__, fmt "\n", ##__VA_ARGS__); \
+    }                                                                                                                           \
+  } while (0)
+#else
+#define CLOGGER_LOG(severity, fmt, ...) \
+  Clogger::Log(severity, __FILE__ + Clogger::FileNameOffset(__FILE__), __LINE__, __FUNCTION__, fmt "\n", ##__VA_ARGS__)
+#endif
+
 #define CLOG(fmt, ...) CLOGI(fmt, ##__VA_ARGS__)
 
 #if CLOGGER_SEVERITY <= CLOGGER_SEVERITY_VERBOSE
-#define CLOGV(fmt, ...) \
-  Clogger::Log(CLOGGER_SEVERITY_VERBOSE, __FILE__ + Clogger::FileNameOffset(__FILE__), __LINE__, __FUNCTION__, fmt "\n", ##__VA_ARGS__)
+#define CLOGV(fmt, ...) CLOGGER_LOG(CLOGGER_SEVERITY_VERBOSE, fmt, ##__VA_ARGS__)
 #else
 #define CLOGV(fmt, ...)
 #endif
 
 #if CLOGGER_SEVERITY <= CLOGGER_SEVERITY_DEBUG
-#define CLOGD(fmt, ...) \
-  Clogger::Log(CLOGGER_SEVERITY_DEBUG, __FILE__ + Clogger::FileNameOffset(__FILE__), __LINE__, __FUNCTION__, fmt "\n", ##__VA_ARGS__)
+#define CLOGD(fmt, ...) CLOGGER_LOG(CLOGGER_SEVERITY_DEBUG, fmt, ##__VA_ARGS__)
 #else
 #define CLOGD(fmt, ...)
 #endif
 
 #if CLOGGER_SEVERITY <= CLOGGER_SEVERITY_INFO
-#define CLOGI(fmt, ...) \
-  Clogger::Log(CLOGGER_SEVERITY_INFO, __FILE__ + Clogger::FileNameOffset(__FILE__), __LINE__, __FUNCTION__, fmt "\n", ##__VA_ARGS__)
+#define CLOGI(fmt, ...) CLOGGER_LOG(CLOGGER_SEVERITY_INFO, fmt, ##__VA_ARGS__)
 #else
 #define CLOGI(fmt, ...)
 #endif
 
 #if CLOGGER_SEVERITY <= CLOGGER_SEVERITY_WARN
-#define CLOGW(fmt, ...) \
-  Clogger::Log(CLOGGER_SEVERITY_WARN, __FILE__ + Clogger::FileNameOffset(__FILE__), __LINE__, __FUNCTION__, fmt "\n", ##__VA_ARGS__)
+#define CLOGW(fmt, ...) CLOGGER_LOG(CLOGGER_SEVERITY_WARN, fmt, ##__VA_ARGS__)
 #else
 #define CLOGW(fmt, ...)
 #endif
 
 #if CLOGGER_SEVERITY <= CLOGGER_SEVERITY_ERROR
-#define CLOGE(fmt, ...) \
-  Clogger::Log(CLOGGER_SEVERITY_ERROR, __FILE__ + Clogger::FileNameOffset(__FILE__), __LINE__, __FUNCTION__, fmt "\n", ##__VA_ARGS__)
+#define CLOGE(fmt, ...) CLOGGER_LOG(CLOGGER_SEVERITY_ERROR, fmt, ##__VA_ARGS__)
 #else
 #define CLOGE(fmt, ...)
 #endif
 
 #if CLOGGER_SEVERITY <= CLOGGER_SEVERITY_FATAL
-#define CLOGF(fmt, ...) \
-  Clogger::Log(CLOGGER_SEVERITY_FATAL, __FILE__ + Clogger::FileNameOffset(__FILE__), __LINE__, __FUNCTION__, fmt "\n", ##__VA_ARGS__)
+#define CLOGF(fmt, ...) CLOGGER_LOG(CLOGGER_SEVERITY_FATAL, fmt, ##__VA_ARGS__)
 #else
 #define CLOGF(fmt, ...)
 #endif
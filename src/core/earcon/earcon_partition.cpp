@@ -0,0 +1,71 @@
+#include "earcon_partition.h"
+
+#include <cstring>
+
+#define CLOGGER_MODULE EARCON
+
+#ifndef CLOGGER_SEVERITY
+#define CLOGGER_SEVERITY CLOGGER_SEVERITY_WARN
+#endif
+
+#include "../clogger/clogger.h"
+
+EarconPartition::~EarconPartition() {
+  if (data_ != nullptr) {
+    esp_partition_munmap(mmap_handle_);
+  }
+}
+
+bool EarconPartition::Map(const std::string &label) {
+  if (data_ != nullptr) {
+    return true;
+  }
+
+  const auto partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, label.c_str());
+  if (partition == nullptr) {
+    CLOGW("partition '%s' not found", label.c_str());
+    return false;
+  }
+
+  const void *data = nullptr;
+  const auto err = esp_partition_mmap(partition, 0, partition->size, ESP_PARTITION_MMAP_DATA, &data, &mmap_handle_);
+  if (err != ESP_OK) {
+    CLOGE("esp_partition_mmap failed: %d", err);
+    return false;
+  }
+
+  const auto header = reinterpret_cast<const Header *>(data);
+  if (partition->size < sizeof(Header) || memcmp(header->magic, kMagic, sizeof(kMagic)) != 0 || header->version != kVersion ||
+      partition->size < sizeof(Header) + header->count * sizeof(Entry)) {
+    CLOGW("partition '%s' has no earcons", label.c_str());
+    esp_partition_munmap(mmap_handle_);
+    return false;
+  }
+
+  data_ = reinterpret_cast<const uint8_t *>(data);
+  size_ = partition->size;
+  CLOGI("partition '%s': %u earcons", label.c_str(), header->count);
+  return true;
+}
+
+std::optional<EarconPartition::Clip> EarconPartition::Find(const std::string &name) const {
+  if (data_ == nullptr) {
+    return std::nullopt;
+  }
+
+  const auto header = reinterpret_cast<const Header *>(data_);
+  const auto entries = reinterpret_cast<const Entry *>(data_ + sizeof(Header));
+  for (uint16_t i = 0; i < header->count; i++) {
+    const auto &entry = entries[i];
+    if (strncmp(entry.name, name.c_str(), sizeof(entry.name)) != 0) {
+      continue;
+    }
+
+    if (entry.offset > size_ || entry.size > size_ - entry.offset) {
+      CLOGE("earcon '%s' out of range", name.c_str());
+      return std::nullopt;
+    }
+    return Clip{data_ + entry.offset, entry.size};
+  }
+  return std::nullopt;
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#ifndef _EARCON_PARTITION_H_
+#define _EARCON_PARTITION_H_
+
+#include <esp_partition.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+
+// 提示音分区, 由 tools/earcon_pack 生成, 整个分区通过 esp_partition_mmap 映射后直接播放, 不占用 RAM
+//
+// 分区格式 (小端):
+//   Header        magic "AVEC", version, count
+//   Entry[count]  name, 片段相对分区起始的 offset 和 size
+//   片段数据      连续的 [uint16_t 长度][Opus 数据包]
+class EarconPartition {
+ public:
+  struct Clip {
+    const uint8_t *data;
+    size_t size;
+  };
+
+  struct Header {
+    char magic[4];
+    uint16_t version;
+    uint16_t count;
+  };
+
+  struct Entry {
+    char name[24];  // 以 '\0' 结尾
+    uint32_t offset;
+    uint32_t size;
+  };
+
+  static_assert(sizeof(Header) == 8 && sizeof(Entry) == 32, "layout shared with tools/earcon_pack");
+
+  static constexpr char kMagic[4] = {'A', 'V', 'E', 'C'};
+  static constexpr uint16_t kVersion = 1;
+
+  EarconPartition() = default;
+  ~EarconPartition();
+
+  bool Map(const std::string &label);
+  std::optional<Clip> Find(const std::string &name) const;
+
+ private:
+  EarconPartition(const EarconPartition &) = delete;
+  EarconPartition &operator=(const EarconPartition &) = delete;
+
+  esp_partition_mmap_handle_t mmap_handle_ = 0;
+  const uint8_t *data_ = nullptr;
+  size_t size_ = 0;
+};
+
+#endif
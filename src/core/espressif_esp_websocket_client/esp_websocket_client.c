@@ -7,6 +7,7 @@
 #include <stdio.h>
 
 #include "esp_websocket_client.h"
+#include "esp_websocket_frame.h"
 #include "esp_transport.h"
 #include "esp_transport_tcp.h"
 #include "esp_transport_ssl.h"
@@ -20,6 +21,8 @@
 #include "esp_timer.h"
 #include "esp_tls_crypto.h"
 #include "esp_system.h"
+#include "esp_heap_caps.h"
+#include "esp_random.h"
 #include <errno.h>
 #include <arpa/inet.h>
 
@@ -71,6 +74,7 @@ typedef struct {
     const char                 *task_name;
     int                         task_stack;
     int                         task_prio;
+    BaseType_t                  task_core_id;
     char                        *uri;
     char                        *host;
     char                        *path;
@@ -118,6 +122,7 @@ struct esp_websocket_client {
     esp_websocket_error_codes_t error_handle;
     esp_transport_list_handle_t transport_list;
     esp_transport_handle_t      transport;
+    esp_transport_handle_t      parent_transport;
     websocket_config_storage_t *config;
     websocket_client_state_t    state;
     uint64_t                    keepalive_tick_ms;
@@ -135,6 +140,8 @@ struct esp_websocket_client {
     char                        *rx_buffer;
     char                        *tx_buffer;
     int                         buffer_size;
+    uint32_t                    buffer_caps;
+    uint8_t                     *frame_buffer;
     bool                        last_fin;
     ws_transport_opcodes_t      last_opcode;
     int                         payload_len;
@@ -148,6 +155,12 @@ static uint64_t _tick_get_ms(void)
     return esp_timer_get_time() / 1000;
 }
 
+static void *esp_websocket_alloc_buf(uint32_t caps, int size)
+{
+    void *buffer = caps != 0 ? heap_caps_malloc(size, caps) : NULL;
+    return buffer != NULL ? buffer : malloc(size);
+}
+
 static esp_err_t esp_websocket_new_buf(esp_websocket_client_handle_t client, bool is_tx)
 {
 #ifdef CONFIG_ESP_WS_CLIENT_ENABLE_DYNAMIC_BUFFER
@@ -156,15 +169,17 @@ static esp_err_t esp_websocket_new_buf(esp_websocket_client_handle_t client, boo
             free(client->tx_buffer);
         }
 
-        client->tx_buffer = calloc(1, client->buffer_size);
+        client->tx_buffer = esp_websocket_alloc_buf(client->buffer_caps, client->buffer_size);
         ESP_WS_CLIENT_MEM_CHECK(TAG, client->tx_buffer, return ESP_ERR_NO_MEM);
+        memset(client->tx_buffer, 0, client->buffer_size);
     } else {
         if (client->rx_buffer) {
             free(client->rx_buffer);
         }
 
-        client->rx_buffer = calloc(1, client->buffer_size);
+        client->rx_buffer = esp_websocket_alloc_buf(client->buffer_caps, client->buffer_size);
         ESP_WS_CLIENT_MEM_CHECK(TAG, client->rx_buffer, return ESP_ERR_NO_MEM);
+        memset(client->rx_buffer, 0, client->buffer_size);
     }
 #endif
     return ESP_OK;
@@ -312,6 +327,8 @@ static esp_err_t esp_websocket_client_set_config(esp_websocket_client_handle_t c
 
     cfg->task_name = config->task_name;
 
+    cfg->task_core_id = config->task_pinned ? config->task_core_id : tskNO_AFFINITY;
+
     cfg->task_stack = config->task_stack;
     if (cfg->task_stack == 0) {
         cfg->task_stack = WEBSOCKET_TASK_STACK;
@@ -441,6 +458,7 @@ static void destroy_and_free_resources(esp_websocket_client_handle_t client)
     vSemaphoreDelete(client->lock);
     free(client->tx_buffer);
     free(client->rx_buffer);
+    free(client->frame_buffer);
     free(client->errormsg_buffer);
     if (client->status_bits) {
         vEventGroupDelete(client->status_bits);
@@ -493,6 +511,7 @@ static esp_err_t esp_websocket_client_create_transport(esp_websocket_client_hand
         client->transport_list = NULL;
     }
 
+    client->parent_transport = NULL;
     client->transport_list = esp_transport_list_init();
     ESP_WS_CLIENT_MEM_CHECK(TAG, client->transport_list, return ESP_ERR_NO_MEM);
     if (strcasecmp(client->config->scheme, WS_OVER_TCP_SCHEME) == 0) {
@@ -501,6 +520,7 @@ static esp_err_t esp_websocket_client_create_transport(esp_websocket_client_hand
 
         esp_transport_set_default_port(tcp, WEBSOCKET_TCP_DEFAULT_PORT);
         esp_transport_list_add(client->transport_list, tcp, "_tcp"); // need to save to transport list, for cleanup
+        client->parent_transport = tcp;
         if (client->keep_alive_cfg.keep_alive_enable) {
             esp_transport_tcp_set_keep_alive(tcp, &client->keep_alive_cfg);
         }
@@ -520,6 +540,7 @@ static esp_err_t esp_websocket_client_create_transport(esp_websocket_client_hand
 
         esp_transport_set_default_port(ssl, WEBSOCKET_SSL_DEFAULT_PORT);
         esp_transport_list_add(client->transport_list, ssl, "_ssl"); // need to save to transport list, for cleanup
+        client->parent_transport = ssl;
         if (client->keep_alive_cfg.keep_alive_enable) {
             esp_transport_ssl_set_keep_alive(ssl, &client->keep_alive_cfg);
         }
@@ -655,6 +676,61 @@ unlock_and_return:
     return ret;
 }
 
+static int esp_websocket_client_send_single_write(esp_websocket_client_handle_t client, ws_transport_opcodes_t opcode, const uint8_t *data, int len, TickType_t timeout)
+{
+    if (client == NULL || len < 0 || (data == NULL && len > 0)) {
+        ESP_LOGE(TAG, "Invalid arguments");
+        return -1;
+    }
+
+    if (!esp_websocket_client_is_connected(client)) {
+        ESP_LOGE(TAG, "Websocket client is not connected");
+        return -1;
+    }
+
+    if (xSemaphoreTakeRecursive(client->lock, timeout) != pdPASS) {
+        ESP_LOGE(TAG, "Could not lock ws-client within %" PRIu32 " timeout", timeout);
+        return -1;
+    }
+
+    int ret = -1;
+    const int frame_buffer_size = client->buffer_size + ESP_WEBSOCKET_FRAME_MAX_HEADER_LEN;
+    if (client->frame_buffer == NULL) {
+        client->frame_buffer = esp_websocket_alloc_buf(client->buffer_caps, frame_buffer_size);
+        ESP_WS_CLIENT_MEM_CHECK(TAG, client->frame_buffer, goto unlock_and_return);
+    }
+
+    uint32_t mask = esp_random();
+    uint8_t mask_key[4];
+    memcpy(mask_key, &mask, sizeof(mask_key));
+    const size_t frame_len = esp_websocket_frame_build(client->frame_buffer, frame_buffer_size, opcode, data, len, mask_key);
+    const int timeout_ms = (timeout == portMAX_DELAY) ? -1 : timeout * portTICK_PERIOD_MS;
+
+    // header and payload go out in one write, i.e. one TLS record; tcp may still accept only part of it
+    size_t widx = 0;
+    while (widx < frame_len) {
+        const int wlen = esp_transport_write(client->parent_transport, (const char *)client->frame_buffer + widx, frame_len - widx, timeout_ms);
+        if (wlen <= 0) {
+            esp_tls_error_handle_t error_handle = esp_transport_get_error_handle(client->parent_transport);
+            if (error_handle) {
+                esp_websocket_client_error(client, "esp_transport_write() returned %d, transport_error=%s, tls_error_code=%i, tls_flags=%i, errno=%d",
+                                           wlen, esp_err_to_name(error_handle->last_error), error_handle->esp_tls_error_code,
+                                           error_handle->esp_tls_flags, errno);
+            } else {
+                esp_websocket_client_error(client, "esp_transport_write() returned %d, errno=%d", wlen, errno);
+            }
+            esp_websocket_client_abort_connection(client, WEBSOCKET_ERROR_TYPE_TCP_TRANSPORT);
+            goto unlock_and_return;
+        }
+        widx += wlen;
+    }
+    ret = len;
+
+unlock_and_return:
+    xSemaphoreGiveRecursive(client->lock);
+    return ret;
+}
+
 esp_websocket_client_handle_t esp_websocket_client_init(const esp_websocket_client_config_t *config)
 {
     esp_websocket_client_handle_t client = calloc(1, sizeof(struct esp_websocket_client));
@@ -756,11 +832,11 @@ esp_websocket_client_handle_t esp_websocket_client_init(const esp_websocket_clie
     client->errormsg_buffer = NULL;
     client->errormsg_size = 0;
 #ifndef CONFIG_ESP_WS_CLIENT_ENABLE_DYNAMIC_BUFFER
-    client->rx_buffer = malloc(buffer_size);
+    client->rx_buffer = esp_websocket_alloc_buf(config->buffer_caps, buffer_size);
     ESP_WS_CLIENT_MEM_CHECK(TAG, client->rx_buffer, {
         goto _websocket_init_fail;
     });
-    client->tx_buffer = malloc(buffer_size);
+    client->tx_buffer = esp_websocket_alloc_buf(config->buffer_caps, buffer_size);
     ESP_WS_CLIENT_MEM_CHECK(TAG, client->tx_buffer, {
         goto _websocket_init_fail;
     });
@@ -772,6 +848,7 @@ esp_websocket_client_handle_t esp_websocket_client_init(const esp_websocket_clie
     xEventGroupSetBits(client->status_bits, STOPPED_BIT);
 
     client->buffer_size = buffer_size;
+    client->buffer_caps = config->buffer_caps;
     return client;
 
 _websocket_init_fail:
@@ -1162,8 +1239,9 @@ esp_err_t esp_websocket_client_start(esp_websocket_client_handle_t client)
         }
     }
 
-    if (xTaskCreate(esp_websocket_client_task, client->config->task_name ? client->config->task_name : "websocket_task",
-                    client->config->task_stack, client, client->config->task_prio, &client->task_handle) != pdTRUE) {
+    if (xTaskCreatePinnedToCore(esp_websocket_client_task, client->config->task_name ? client->config->task_name : "websocket_task",
+                                client->config->task_stack, client, client->config->task_prio, &client->task_handle,
+                                client->config->task_core_id) != pdTRUE) {
         ESP_LOGE(TAG, "Error create websocket task");
         return ESP_FAIL;
     }
@@ -1286,6 +1364,14 @@ int esp_websocket_client_send_with_opcode(esp_websocket_client_handle_t client,
     return esp_websocket_client_send_with_exact_opcode(client, opcode | WS_TRANSPORT_OPCODES_FIN, data, len, timeout);
 }
 
+int esp_websocket_client_send_frame(esp_websocket_client_handle_t client, ws_transport_opcodes_t opcode, const uint8_t *data, int len, TickType_t timeout)
+{
+    if (client != NULL && client->parent_transport != NULL && len >= 0 && len <= client->buffer_size) {
+        return esp_websocket_client_send_single_write(client, opcode | WS_TRANSPORT_OPCODES_FIN, data, len, timeout);
+    }
+    return esp_websocket_client_send_with_opcode(client, opcode, data, len, timeout);
+}
+
 bool esp_websocket_client_is_connected(esp_websocket_client_handle_t client)
 {
     if (client == NULL) {
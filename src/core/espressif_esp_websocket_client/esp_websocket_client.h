@@ -105,7 +105,10 @@ typedef struct {
     int                         task_prio;                  /*!< Websocket task priority */
     const char                 *task_name;                  /*!< Websocket task name */
     int                         task_stack;                 /*!< Websocket task stack */
+    bool                        task_pinned;                /*!< Pin websocket task to task_core_id */
+    int                         task_core_id;               /*!< Websocket task core, used when task_pinned is set */
     int                         buffer_size;                /*!< Websocket buffer size */
+    uint32_t                    buffer_caps;                /*!< heap_caps_malloc capabilities of the rx/tx buffers, 0 or failure falls back to malloc */
     const char                  *cert_pem;                  /*!< Pointer to certificate data in PEM or DER format for server verify (with SSL), default is NULL, not required to verify the server. PEM-format must have a terminating NULL-character. DER-format requires the length to be passed in cert_len. */
     size_t                      cert_len;                   /*!< Length of the buffer pointed to by cert_pem. May be 0 for null-terminated pem */
     const char                  *client_cert;               /*!< Pointer to certificate data in PEM or DER format for SSL mutual authentication, default is NULL, not required if mutual authentication is not needed. If it is not NULL, also `client_key` or `client_ds_data` (if supported) has to be provided. PEM-format must have a terminating NULL-character. DER-format requires the length to be passed in client_cert_len. */
@@ -357,6 +360,27 @@ int esp_websocket_client_send_fin(esp_websocket_client_handle_t client, TickType
  */
 int esp_websocket_client_send_with_opcode(esp_websocket_client_handle_t client, ws_transport_opcodes_t opcode, const uint8_t *data, int len, TickType_t timeout);
 
+/**
+ * @brief      Write a complete message as a single frame with a single transport write
+ *
+ * @param[in]  client  The client
+ * @param[in]  opcode  The opcode
+ * @param[in]  data    The data
+ * @param[in]  len     The length
+ * @param[in]  timeout Write data timeout in RTOS ticks
+ *
+ *  Notes:
+ *  - The header and the masked payload are built in a buffer of buffer_size + 14 bytes that is allocated on
+ *    the first call and kept until the client is destroyed, also with CONFIG_ESP_WS_CLIENT_ENABLE_DYNAMIC_BUFFER
+ *  - Over TLS the frame is one record instead of one record for the header plus one per buffer_size chunk
+ *  - Messages longer than buffer_size, or clients using ext_transport, fall back to esp_websocket_client_send_with_opcode
+ *
+ * @return
+ *     - Number of data was sent
+ *     - (-1) if any errors
+ */
+int esp_websocket_client_send_frame(esp_websocket_client_handle_t client, ws_transport_opcodes_t opcode, const uint8_t *data, int len, TickType_t timeout);
+
 /**
  * @brief      Close the WebSocket connection in a clean way
  *
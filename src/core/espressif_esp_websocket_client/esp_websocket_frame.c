@@ -0,0 +1,71 @@
+/*
+ * SPDX-FileCopyrightText: 2015-2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "esp_websocket_frame.h"
+
+#include <string.h>
+
+#define WS_MASK_BIT         (0x80)
+#define WS_SIZE16           (126)
+#define WS_SIZE64           (127)
+#define WS_MASK_KEY_LEN     (4)
+
+size_t esp_websocket_frame_header_len(size_t len)
+{
+    if (len < WS_SIZE16) {
+        return 2 + WS_MASK_KEY_LEN;
+    } else if (len <= 0xFFFF) {
+        return 4 + WS_MASK_KEY_LEN;
+    }
+    return 10 + WS_MASK_KEY_LEN;
+}
+
+static void esp_websocket_frame_mask_copy(uint8_t *dst, const uint8_t *src, size_t len, const uint8_t mask_key[4])
+{
+    /* memcpy keeps the word accesses legal for unaligned dst/src, the compiler turns them into plain loads/stores */
+    uint32_t mask;
+    memcpy(&mask, mask_key, sizeof(mask));
+    size_t i = 0;
+    for (; i + sizeof(mask) <= len; i += sizeof(mask)) {
+        uint32_t word;
+        memcpy(&word, src + i, sizeof(word));
+        word ^= mask;
+        memcpy(dst + i, &word, sizeof(word));
+    }
+    for (; i < len; i++) {
+        dst[i] = src[i] ^ mask_key[i % WS_MASK_KEY_LEN];
+    }
+}
+
+size_t esp_websocket_frame_build(uint8_t *out, size_t out_size, uint8_t opcode, const uint8_t *data, size_t len, const uint8_t mask_key[4])
+{
+    const size_t header_len = esp_websocket_frame_header_len(len);
+    if (out_size < header_len || out_size - header_len < len) {
+        return 0;
+    }
+
+    size_t pos = 0;
+    out[pos++] = opcode;
+    if (len < WS_SIZE16) {
+        out[pos++] = WS_MASK_BIT | (uint8_t)len;
+    } else if (len <= 0xFFFF) {
+        out[pos++] = WS_MASK_BIT | WS_SIZE16;
+        out[pos++] = (uint8_t)(len >> 8);
+        out[pos++] = (uint8_t)len;
+    } else {
+        out[pos++] = WS_MASK_BIT | WS_SIZE64;
+        for (int shift = 56; shift >= 0; shift -= 8) {
+            out[pos++] = (uint8_t)((uint64_t)len >> shift);
+        }
+    }
+    memcpy(out + pos, mask_key, WS_MASK_KEY_LEN);
+    pos += WS_MASK_KEY_LEN;
+
+    if (len > 0) {
+        esp_websocket_frame_mask_copy(out + pos, data, len, mask_key);
+    }
+    return pos + len;
+}
@@ -0,0 +1,49 @@
+/*
+ * SPDX-FileCopyrightText: 2015-2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef _ESP_WEBSOCKET_FRAME_H_
+#define _ESP_WEBSOCKET_FRAME_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Largest client frame header: 2 bytes + 8 bytes extended length + 4 bytes mask key */
+#define ESP_WEBSOCKET_FRAME_MAX_HEADER_LEN (14)
+
+/**
+ * @brief      Length of the masked client frame header for a payload of len bytes
+ */
+size_t esp_websocket_frame_header_len(size_t len);
+
+/**
+ * @brief      Build a complete masked client frame (header + payload) in out
+ *
+ *  Notes:
+ *  - The payload is masked while it is copied, four bytes at a time, data is left untouched
+ *  - out must hold esp_websocket_frame_header_len(len) + len bytes
+ *
+ * @param[out] out       The frame buffer
+ * @param[in]  out_size  Size of out
+ * @param[in]  opcode    First header byte, opcode with the FIN bit
+ * @param[in]  data      The payload, may be NULL when len is 0
+ * @param[in]  len       The payload length
+ * @param[in]  mask_key  The masking key, in wire byte order
+ *
+ * @return
+ *     - Frame length
+ *     - 0 if out is too small
+ */
+size_t esp_websocket_frame_build(uint8_t *out, size_t out_size, uint8_t opcode, const uint8_t *data, size_t len, const uint8_t mask_key[4]);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
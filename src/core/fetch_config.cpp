@@ -13,6 +13,8 @@
 #include <string>
 #include <vector>
 
+#define CLOGGER_MODULE FETCH_CONFIG
+
 #ifndef CLOGGER_SEVERITY
 #define CLOGGER_SEVERITY CLOGGER_SEVERITY_WARN
 #endif
@@ -7,28 +7,35 @@
 #include <cstdlib>
 #include <utility>
 
+#include "ai_vox_heap.h"
+
 template <typename T>
 class FlexArray {
   static_assert(std::is_trivial_v<T>, "FlexArray supports only trivial types");
 
  public:
-  explicit FlexArray(const size_t size) noexcept : size_(size), buffer_(reinterpret_cast<T*>(std::malloc(size * sizeof(T)))) {
+  // 分配失败时 data() 为 nullptr, size() 为 0
+  FlexArray(const size_t size, const ai_vox::HeapTag tag, const ai_vox::MemoryRegion region = ai_vox::MemoryRegion::kDefault) noexcept
+      : tag_(tag), buffer_(reinterpret_cast<T*>(ai_vox::heap::Malloc(tag, size * sizeof(T), region))) {
+    size_ = buffer_ != nullptr ? size : 0;
   }
 
-  FlexArray(FlexArray&& other) noexcept : size_(other.size_), buffer_(other.buffer_) {
+  FlexArray(FlexArray&& other) noexcept : tag_(other.tag_), size_(other.size_), buffer_(other.buffer_) {
     other.buffer_ = nullptr;
     other.size_ = 0;
   }
 
   ~FlexArray() {
-    if (buffer_ != nullptr) {
-      std::free(buffer_);
-    }
+    ai_vox::heap::Free(buffer_);
   }
 
+  // 失败时保持原有内容和大小
   void Resize(const size_t size) noexcept {
-    buffer_ = reinterpret_cast<T*>(std::realloc(buffer_, size * sizeof(T)));
-    size_ = size;
+    const auto buffer = reinterpret_cast<T*>(ai_vox::heap::Realloc(tag_, buffer_, size * sizeof(T)));
+    if (buffer != nullptr) {
+      buffer_ = buffer;
+      size_ = size;
+    }
   }
 
   size_t size() const noexcept {
@@ -43,6 +50,7 @@ class FlexArray {
   FlexArray(const FlexArray&) = delete;
   FlexArray& operator=(const FlexArray&) = delete;
 
+  ai_vox::HeapTag tag_;
   size_t size_ = 0;
   T* buffer_ = nullptr;
 };
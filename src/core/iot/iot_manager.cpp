@@ -1,9 +1,45 @@
 #include "iot_manager.h"
 
+#include <cctype>
+
 #include "cJSON.h"
+
+#define CLOGGER_MODULE IOT
+
 #include "core/clogger/clogger.h"
 
 namespace ai_vox::iot {
+namespace {
+// "TurnOn" -> "turn on", "LEDStrip" -> "led strip"; 含非 ASCII 字符时返回空串
+std::string SplitWords(const std::string &name) {
+  std::string words;
+  for (size_t i = 0; i < name.size(); i++) {
+    const unsigned char c = name[i];
+    if (c >= 0x80) {
+      return {};
+    }
+
+    if (!isalnum(c)) {
+      if (!words.empty() && words.back() != ' ') {
+        words += ' ';
+      }
+      continue;
+    }
+
+    const bool word_start = isupper(c) && i > 0 && (islower(name[i - 1]) || (i + 1 < name.size() && islower(name[i + 1])));
+    if (word_start && !words.empty() && words.back() != ' ') {
+      words += ' ';
+    }
+    words += static_cast<char>(tolower(c));
+  }
+
+  while (!words.empty() && words.back() == ' ') {
+    words.pop_back();
+  }
+  return words;
+}
+}  // namespace
+
 void Manager::RegisterEntity(std::shared_ptr<Entity> entity) {
   entities_.emplace_back(std::move(entity));
 }
@@ -103,6 +139,37 @@ std::vector<std::string> Manager::UpdatedJson(const bool force) {
   return result;
 }
 
+std::vector<Manager::OfflineCommand> Manager::OfflineCommands(const bool derive_phrases) const {
+  std::vector<OfflineCommand> result;
+  for (auto &entity : entities_) {
+    for (auto &[_, function] : entity->functions()) {
+      if (!function.parameters.empty()) {
+        continue;
+      }
+
+      OfflineCommand command{entity->name(), function.name, function.offline_phrases};
+      if (derive_phrases && command.phrases.empty()) {
+        const auto action = SplitWords(function.name);
+        const auto target = SplitWords(entity->name());
+        if (!action.empty() && !target.empty()) {
+          command.phrases.push_back(action + ' ' + target);
+        }
+
+        const auto description = SplitWords(function.description);
+        if (!description.empty()) {
+          command.phrases.push_back(description);
+        }
+      }
+
+      if (!command.phrases.empty()) {
+        CLOGD("%s.%s: %zu phrases", command.entity.c_str(), command.function.c_str(), command.phrases.size());
+        result.push_back(std::move(command));
+      }
+    }
+  }
+  return result;
+}
+
 std::unordered_map<std::string, Value> Manager::UpdateStates(const std::string &name,
                                                              std::unordered_map<std::string, Value> states,
                                                              const bool force) {
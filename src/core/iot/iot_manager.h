@@ -14,12 +14,20 @@ namespace ai_vox::iot {
 
 class Manager {
  public:
+  struct OfflineCommand {
+    std::string entity;
+    std::string function;
+    std::vector<std::string> phrases;
+  };
+
   Manager() = default;
   ~Manager() = default;
 
   void RegisterEntity(std::shared_ptr<Entity> entity);
   std::vector<std::string> DescriptionsJson() const;
   std::vector<std::string> UpdatedJson(const bool force);
+  // 可以离线识别的无参数函数, derive_phrases 为 true 时 (英文模型) 补充由函数名和实体名推导的命令词
+  std::vector<OfflineCommand> OfflineCommands(const bool derive_phrases) const;
 
  private:
   std::unordered_map<std::string, Value> UpdateStates(const std::string& name, std::unordered_map<std::string, Value> states, const bool force);
@@ -0,0 +1,285 @@
+#include "json_reader.h"
+
+#include <cstring>
+
+namespace {
+constexpr uint32_t kMaxDepth = 16;  // 主任务栈有限, 嵌套更深的消息视为无效
+
+const char* SkipWhitespace(const char* p, const char* end) {
+  while (p < end && (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r')) {
+    p++;
+  }
+  return p;
+}
+
+// p 指向开头的 '"', 返回结尾 '"' 之后的位置
+const char* SkipString(const char* p, const char* end) {
+  for (p++; p < end; p++) {
+    if (*p == '\\') {
+      p++;
+    } else if (*p == '"') {
+      return p + 1;
+    } else if (static_cast<unsigned char>(*p) < 0x20) {
+      return nullptr;
+    }
+  }
+  return nullptr;
+}
+
+const char* SkipLiteral(const char* p, const char* end, const char* literal) {
+  const auto length = strlen(literal);
+  return static_cast<size_t>(end - p) >= length && memcmp(p, literal, length) == 0 ? p + length : nullptr;
+}
+
+const char* SkipNumber(const char* p, const char* end) {
+  const auto begin = p;
+  while (p < end && ((*p >= '0' && *p <= '9') || *p == '-' || *p == '+' || *p == '.' || *p == 'e' || *p == 'E')) {
+    p++;
+  }
+  return p > begin ? p : nullptr;
+}
+
+const char* SkipValue(const char* p, const char* end, const uint32_t depth);
+
+// p 指向 '{' 或 '[', 返回对应的 '}' 或 ']' 之后的位置
+const char* SkipContainer(const char* p, const char* end, const uint32_t depth) {
+  if (depth >= kMaxDepth) {
+    return nullptr;
+  }
+
+  const bool is_object = *p == '{';
+  const char close = is_object ? '}' : ']';
+  p = SkipWhitespace(p + 1, end);
+  if (p < end && *p == close) {
+    return p + 1;
+  }
+
+  while (p < end) {
+    if (is_object) {
+      if (*p != '"' || (p = SkipString(p, end)) == nullptr) {
+        return nullptr;
+      }
+      p = SkipWhitespace(p, end);
+      if (p >= end || *p != ':') {
+        return nullptr;
+      }
+      p = SkipWhitespace(p + 1, end);
+    }
+
+    if ((p = SkipValue(p, end, depth + 1)) == nullptr) {
+      return nullptr;
+    }
+    p = SkipWhitespace(p, end);
+    if (p < end && *p == close) {
+      return p + 1;
+    } else if (p >= end || *p != ',') {
+      return nullptr;
+    }
+    p = SkipWhitespace(p + 1, end);
+  }
+  return nullptr;
+}
+
+const char* SkipValue(const char* p, const char* end, const uint32_t depth) {
+  if (p >= end) {
+    return nullptr;
+  }
+
+  switch (*p) {
+    case '"':
+      return SkipString(p, end);
+    case '{':
+    case '[':
+      return SkipContainer(p, end, depth);
+    case 't':
+      return SkipLiteral(p, end, "true");
+    case 'f':
+      return SkipLiteral(p, end, "false");
+    case 'n':
+      return SkipLiteral(p, end, "null");
+    default:
+      return SkipNumber(p, end);
+  }
+}
+
+int HexDigit(const char c) {
+  if (c >= '0' && c <= '9') {
+    return c - '0';
+  } else if (c >= 'a' && c <= 'f') {
+    return c - 'a' + 10;
+  } else if (c >= 'A' && c <= 'F') {
+    return c - 'A' + 10;
+  }
+  return -1;
+}
+
+// 读取 \u 之后的 4 位十六进制数, 失败返回 -1
+int32_t ParseHex4(const char* p, const char* end) {
+  if (end - p < 4) {
+    return -1;
+  }
+  int32_t value = 0;
+  for (int i = 0; i < 4; i++) {
+    const auto digit = HexDigit(p[i]);
+    if (digit < 0) {
+      return -1;
+    }
+    value = value << 4 | digit;
+  }
+  return value;
+}
+
+size_t EncodeUtf8(uint32_t code_point, char* out) {
+  if (code_point < 0x80) {
+    out[0] = code_point;
+    return 1;
+  } else if (code_point < 0x800) {
+    out[0] = 0xC0 | code_point >> 6;
+    out[1] = 0x80 | (code_point & 0x3F);
+    return 2;
+  } else if (code_point < 0x10000) {
+    out[0] = 0xE0 | code_point >> 12;
+    out[1] = 0x80 | (code_point >> 6 & 0x3F);
+    out[2] = 0x80 | (code_point & 0x3F);
+    return 3;
+  }
+  out[0] = 0xF0 | code_point >> 18;
+  out[1] = 0x80 | (code_point >> 12 & 0x3F);
+  out[2] = 0x80 | (code_point >> 6 & 0x3F);
+  out[3] = 0x80 | (code_point & 0x3F);
+  return 4;
+}
+}  // namespace
+
+JsonReader::JsonReader(const char* data, const size_t size) {
+  const auto end = data + size;
+  const auto p = SkipWhitespace(data, end);
+  if (p >= end || *p != '{') {
+    return;
+  }
+
+  const auto object_end = SkipContainer(p, end, 0);
+  if (object_end != nullptr) {
+    begin_ = p;
+    end_ = object_end;
+  }
+}
+
+// 构造时已校验整个对象, 这里只需逐个跳过成员
+const char* JsonReader::Find(const char* key) const {
+  if (begin_ == nullptr) {
+    return nullptr;
+  }
+
+  const auto key_length = strlen(key);
+  auto p = SkipWhitespace(begin_ + 1, end_);
+  while (p < end_ && *p == '"') {
+    const auto key_end = SkipString(p, end_);
+    const bool matched = static_cast<size_t>(key_end - p) == key_length + 2 && memcmp(p + 1, key, key_length) == 0;
+    p = SkipWhitespace(SkipWhitespace(key_end, end_) + 1, end_);
+    if (matched) {
+      return p;
+    }
+    p = SkipWhitespace(SkipValue(p, end_, 1), end_);
+    if (p < end_ && *p == ',') {
+      p = SkipWhitespace(p + 1, end_);
+    }
+  }
+  return nullptr;
+}
+
+bool JsonReader::GetString(const char* key, char* out, const size_t size) const {
+  const auto value = Find(key);
+  if (value == nullptr || *value != '"' || size == 0) {
+    return false;
+  }
+
+  const auto value_end = SkipString(value, end_) - 1;
+  size_t length = 0;
+  char utf8[4];
+  for (auto p = value + 1; p < value_end; p++) {
+    size_t count = 1;
+    utf8[0] = *p;
+    if (*p == '\\') {
+      p++;
+      switch (*p) {
+        case 'b':
+          utf8[0] = '\b';
+          break;
+        case 'f':
+          utf8[0] = '\f';
+          break;
+        case 'n':
+          utf8[0] = '\n';
+          break;
+        case 'r':
+          utf8[0] = '\r';
+          break;
+        case 't':
+          utf8[0] = '\t';
+          break;
+        case 'u': {
+          int32_t code_point = ParseHex4(p + 1, value_end);
+          if (code_point < 0) {
+            return false;
+          }
+          p += 4;
+          // UTF-16 代理对
+          if (code_point >= 0xD800 && code_point <= 0xDBFF && value_end - p > 6 && p[1] == '\\' && p[2] == 'u') {
+            const auto low = ParseHex4(p + 3, value_end);
+            if (low >= 0xDC00 && low <= 0xDFFF) {
+              code_point = 0x10000 + ((code_point - 0xD800) << 10) + (low - 0xDC00);
+              p += 6;
+            }
+          }
+          count = EncodeUtf8(code_point, utf8);
+          break;
+        }
+        default:
+          utf8[0] = *p;
+          break;
+      }
+    }
+
+    if (length + count > size - 1) {
+      break;
+    }
+    memcpy(out + length, utf8, count);
+    length += count;
+  }
+  out[length] = '\0';
+  return true;
+}
+
+bool JsonReader::GetInt(const char* key, int32_t& value) const {
+  auto p = Find(key);
+  if (p == nullptr || (*p != '-' && (*p < '0' || *p > '9'))) {
+    return false;
+  }
+
+  const bool negative = *p == '-';
+  if (negative) {
+    p++;
+  }
+  int64_t result = 0;
+  for (; p < end_ && *p >= '0' && *p <= '9'; p++) {
+    if (result <= INT32_MAX) {
+      result = result * 10 + (*p - '0');
+    }
+  }
+  if (negative) {
+    result = -result;
+  }
+  value = result > INT32_MAX ? INT32_MAX : (result < INT32_MIN ? INT32_MIN : result);
+  return true;
+}
+
+JsonReader JsonReader::GetObject(const char* key) const {
+  JsonReader object;
+  const auto value = Find(key);
+  if (value != nullptr && *value == '{') {
+    object.begin_ = value;
+    object.end_ = SkipContainer(value, end_, 1);
+  }
+  return object;
+}
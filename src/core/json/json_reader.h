@@ -0,0 +1,37 @@
+#pragma once
+
+#ifndef _JSON_READER_H_
+#define _JSON_READER_H_
+
+#include <cstddef>
+#include <cstdint>
+
+// 在收到的消息上直接按字段查找, 不建树也不分配内存; 用于引擎自己的浅层消息, IoT 命令仍由 cJSON 解析
+// 键按原始字节比较, 不处理键中的转义
+class JsonReader {
+ public:
+  // data 须在 JsonReader 使用期间保持有效, 不要求以 '\0' 结尾
+  JsonReader(const char* data, const size_t size);
+
+  // 是一个完整的 JSON 对象
+  bool valid() const {
+    return begin_ != nullptr;
+  }
+
+  // 字段不存在或类型不符时返回 false; 字符串反转义为 UTF-8 后写入 out 并以 '\0' 结尾, 超出 size - 1 的部分截断
+  bool GetString(const char* key, char* out, const size_t size) const;
+  // 小数部分被截断, 超出范围时取边界值
+  bool GetInt(const char* key, int32_t& value) const;
+  // 字段不存在或不是对象时返回的 JsonReader 无效
+  JsonReader GetObject(const char* key) const;
+
+ private:
+  JsonReader() = default;
+
+  const char* Find(const char* key) const;
+
+  const char* begin_ = nullptr;  // '{'
+  const char* end_ = nullptr;    // '}' 之后
+};
+
+#endif
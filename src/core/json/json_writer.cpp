@@ -0,0 +1,80 @@
+#include "json_writer.h"
+
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+
+JsonWriter::JsonWriter(char* buffer, const size_t size) : buffer_(buffer), size_(size) {
+  Append("{", 1);
+}
+
+JsonWriter& JsonWriter::Add(const char* key, const char* value) {
+  Key(key);
+  AppendEscaped(value);
+  return *this;
+}
+
+JsonWriter& JsonWriter::Add(const char* key, const int32_t value) {
+  Key(key);
+  char text[12];
+  Append(text, snprintf(text, sizeof(text), "%" PRId32, value));
+  return *this;
+}
+
+JsonWriter& JsonWriter::BeginObject(const char* key) {
+  Key(key);
+  Append("{", 1);
+  first_ = true;
+  return *this;
+}
+
+JsonWriter& JsonWriter::EndObject() {
+  Append("}", 1);
+  first_ = false;
+  return *this;
+}
+
+const char* JsonWriter::Finish() {
+  Append("}", 1);
+  if (overflow_ || length_ >= size_) {
+    return nullptr;
+  }
+  buffer_[length_] = '\0';
+  return buffer_;
+}
+
+void JsonWriter::Key(const char* key) {
+  if (!first_) {
+    Append(",", 1);
+  }
+  first_ = false;
+  AppendEscaped(key);
+  Append(":", 1);
+}
+
+void JsonWriter::Append(const char* text, const size_t length) {
+  if (overflow_ || length_ + length > size_) {
+    overflow_ = true;
+    return;
+  }
+  memcpy(buffer_ + length_, text, length);
+  length_ += length;
+}
+
+// 与 cJSON_PrintUnformatted 一致, 非 ASCII 字符按 UTF-8 原样输出
+void JsonWriter::AppendEscaped(const char* text) {
+  Append("\"", 1);
+  for (auto p = text; *p != '\0'; p++) {
+    const auto c = static_cast<unsigned char>(*p);
+    if (c == '"' || c == '\\') {
+      const char escaped[2] = {'\\', static_cast<char>(c)};
+      Append(escaped, sizeof(escaped));
+    } else if (c < 0x20) {
+      char escaped[7];
+      Append(escaped, snprintf(escaped, sizeof(escaped), "\\u%04x", c));
+    } else {
+      Append(p, 1);
+    }
+  }
+  Append("\"", 1);
+}
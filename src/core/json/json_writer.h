@@ -0,0 +1,38 @@
+#pragma once
+
+#ifndef _JSON_WRITER_H_
+#define _JSON_WRITER_H_
+
+#include <cstddef>
+#include <cstdint>
+
+// 在调用方给出的缓冲区中拼出 JSON 对象, 不分配内存; 用于引擎每轮对话都要发送的消息
+class JsonWriter {
+ public:
+  JsonWriter(char* buffer, const size_t size);
+
+  JsonWriter& Add(const char* key, const char* value);
+  JsonWriter& Add(const char* key, const int32_t value);
+  JsonWriter& BeginObject(const char* key);
+  JsonWriter& EndObject();
+
+  // 补上最外层的 '}', 返回以 '\0' 结尾的消息; 缓冲区不足时返回 nullptr
+  const char* Finish();
+
+  size_t size() const {
+    return length_;
+  }
+
+ private:
+  void Key(const char* key);
+  void Append(const char* text, const size_t length);
+  void AppendEscaped(const char* text);
+
+  char* const buffer_;
+  const size_t size_;
+  size_t length_ = 0;
+  bool overflow_ = false;
+  bool first_ = true;  // 当前对象中还没有成员
+};
+
+#endif
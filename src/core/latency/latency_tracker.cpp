@@ -0,0 +1,124 @@
+#include "latency_tracker.h"
+
+#include <esp_timer.h>
+#include <inttypes.h>
+
+#include <cstdio>
+
+namespace {
+const char* StageName(const ai_vox::LatencyStage stage) {
+  switch (stage) {
+    case ai_vox::LatencyStage::kWakeToConnect:
+      return "wake_to_connect";
+    case ai_vox::LatencyStage::kConnectToHello:
+      return "connect_to_hello";
+    case ai_vox::LatencyStage::kHelloToListen:
+      return "hello_to_listen";
+    case ai_vox::LatencyStage::kLastUserFrameToStt:
+      return "last_user_frame_to_stt";
+    case ai_vox::LatencyStage::kTtsStartToFirstPcm:
+      return "tts_start_to_first_pcm";
+    case ai_vox::LatencyStage::kAbortToSilence:
+      return "abort_to_silence";
+    case ai_vox::LatencyStage::kEncode:
+      return "encode";
+    case ai_vox::LatencyStage::kSend:
+      return "send";
+    case ai_vox::LatencyStage::kReceive:
+      return "receive";
+    case ai_vox::LatencyStage::kDecode:
+      return "decode";
+    case ai_vox::LatencyStage::kWrite:
+      return "write";
+    default:
+      return "unknown";
+  }
+}
+}  // namespace
+
+LatencyTracker& LatencyTracker::GetInstance() {
+  static LatencyTracker s_instance;
+  return s_instance;
+}
+
+void LatencyTracker::Begin(const ai_vox::LatencyStage stage) {
+  const auto now = static_cast<uint32_t>(esp_timer_get_time());
+  begin_time_[static_cast<size_t>(stage)].store(now != 0 ? now : 1, std::memory_order_relaxed);
+}
+
+void LatencyTracker::End(const ai_vox::LatencyStage stage) {
+  const auto begin_time = begin_time_[static_cast<size_t>(stage)].exchange(0, std::memory_order_relaxed);
+  if (begin_time != 0) {
+    Record(stage, static_cast<uint32_t>(esp_timer_get_time()) - begin_time);
+  }
+}
+
+void LatencyTracker::Record(const ai_vox::LatencyStage stage, const int64_t elapsed_us) {
+  if (elapsed_us < 0) {
+    return;
+  }
+
+  const uint32_t value = elapsed_us > UINT32_MAX ? UINT32_MAX : static_cast<uint32_t>(elapsed_us);
+  auto& histogram = histograms_[static_cast<size_t>(stage)];
+
+  size_t bucket = 0;
+  while (bucket < std::size(ai_vox::LatencyHistogram::kBucketBoundsUs) && value > ai_vox::LatencyHistogram::kBucketBoundsUs[bucket]) {
+    bucket++;
+  }
+  histogram.buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+  histogram.count.fetch_add(1, std::memory_order_relaxed);
+  if (histogram.sum_us_low.fetch_add(value, std::memory_order_relaxed) > UINT32_MAX - value) {
+    histogram.sum_us_high.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  auto min_us = histogram.min_us.load(std::memory_order_relaxed);
+  while (value < min_us && !histogram.min_us.compare_exchange_weak(min_us, value, std::memory_order_relaxed)) {
+  }
+
+  auto max_us = histogram.max_us.load(std::memory_order_relaxed);
+  while (value > max_us && !histogram.max_us.compare_exchange_weak(max_us, value, std::memory_order_relaxed)) {
+  }
+}
+
+ai_vox::LatencyStats LatencyTracker::Snapshot() const {
+  ai_vox::LatencyStats stats;
+  for (size_t i = 0; i < stats.size(); i++) {
+    const auto& histogram = histograms_[i];
+    for (size_t j = 0; j < ai_vox::LatencyHistogram::kBucketCount; j++) {
+      stats[i].buckets[j] = histogram.buckets[j].load(std::memory_order_relaxed);
+    }
+    stats[i].count = histogram.count.load(std::memory_order_relaxed);
+    stats[i].min_us = stats[i].count > 0 ? histogram.min_us.load(std::memory_order_relaxed) : 0;
+    stats[i].max_us = histogram.max_us.load(std::memory_order_relaxed);
+    // 高位前后两次读取一致才采用, 低位刚回绕而高位尚未进位时会短暂偏小
+    uint32_t high = 0;
+    uint32_t low = 0;
+    do {
+      high = histogram.sum_us_high.load(std::memory_order_relaxed);
+      low = histogram.sum_us_low.load(std::memory_order_relaxed);
+    } while (high != histogram.sum_us_high.load(std::memory_order_relaxed));
+    stats[i].sum_us = (static_cast<uint64_t>(high) << 32) | low;
+  }
+  return stats;
+}
+
+void LatencyTracker::Dump() const {
+  const auto stats = Snapshot();
+  for (size_t i = 0; i < stats.size(); i++) {
+    const auto& histogram = stats[i];
+    if (histogram.count == 0) {
+      continue;
+    }
+
+    printf("latency %-22s count: %" PRIu32 ", min: %" PRIu32 " us, avg: %" PRIu64 " us, p50: %" PRIu32 " us, p90: %" PRIu32 " us, p99: %" PRIu32
+           " us, max: %" PRIu32 " us\n",
+           StageName(static_cast<ai_vox::LatencyStage>(i)),
+           histogram.count,
+           histogram.min_us,
+           histogram.sum_us / histogram.count,
+           histogram.PercentileUs(50),
+           histogram.PercentileUs(90),
+           histogram.PercentileUs(99),
+           histogram.max_us);
+  }
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#ifndef _LATENCY_TRACKER_H_
+#define _LATENCY_TRACKER_H_
+
+#include <atomic>
+#include <cstdint>
+
+#include "ai_vox_engine.h"
+
+// 固定分桶的时延统计, 记录路径上只有 32 位原子操作 (Xtensa 上 64 位原子操作需要加锁), 不分配内存
+class LatencyTracker {
+ public:
+  static LatencyTracker& GetInstance();
+
+  // Begin 记录起点, End 与最近一次 Begin 配对后清除起点, 未配对的 End 被忽略
+  void Begin(const ai_vox::LatencyStage stage);
+  void End(const ai_vox::LatencyStage stage);
+  void Record(const ai_vox::LatencyStage stage, const int64_t elapsed_us);
+
+  ai_vox::LatencyStats Snapshot() const;
+  void Dump() const;
+
+ private:
+  struct Histogram {
+    std::atomic<uint32_t> buckets[ai_vox::LatencyHistogram::kBucketCount] = {};
+    std::atomic<uint32_t> count = 0;
+    std::atomic<uint32_t> min_us = UINT32_MAX;
+    std::atomic<uint32_t> max_us = 0;
+    // 64 位累加和拆成两个 32 位原子量, 低位回绕时高位进一
+    std::atomic<uint32_t> sum_us_low = 0;
+    std::atomic<uint32_t> sum_us_high = 0;
+  };
+
+  LatencyTracker() = default;
+  LatencyTracker(const LatencyTracker&) = delete;
+  LatencyTracker& operator=(const LatencyTracker&) = delete;
+
+  // esp_timer 时间戳截断到 32 位, 无符号相减在约 71 分钟内不受回绕影响, 0 表示未开始
+  std::atomic<uint32_t> begin_time_[static_cast<size_t>(ai_vox::LatencyStage::kMax)] = {};
+  Histogram histograms_[static_cast<size_t>(ai_vox::LatencyStage::kMax)];
+};
+
+#endif
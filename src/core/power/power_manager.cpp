@@ -0,0 +1,137 @@
+#include "power_manager.h"
+
+#include <esp_timer.h>
+
+#define CLOGGER_MODULE POWER
+
+#ifndef CLOGGER_SEVERITY
+#define CLOGGER_SEVERITY CLOGGER_SEVERITY_WARN
+#endif
+
+#include "../clogger/clogger.h"
+
+PowerManager::~PowerManager() {
+  Stop();
+}
+
+bool PowerManager::Start(const ai_vox::PowerConfig& config) {
+  std::lock_guard lock(mutex_);
+  if (started_) {
+    return true;
+  }
+
+  // 未开启 CONFIG_PM_ENABLE 时 esp_pm 的接口均返回 ESP_ERR_NOT_SUPPORTED
+  auto ret = esp_pm_get_configuration(&previous_config_);
+  if (ret != ESP_OK) {
+    CLOGW("esp_pm_get_configuration failed: %s, CONFIG_PM_ENABLE is required", esp_err_to_name(ret));
+    return false;
+  }
+
+  ret = esp_pm_lock_create(ESP_PM_CPU_FREQ_MAX, 0, "AiVoxCpu", &cpu_lock_);
+  if (ret == ESP_OK) {
+    ret = esp_pm_lock_create(ESP_PM_NO_LIGHT_SLEEP, 0, "AiVoxNoSleep", &no_sleep_lock_);
+  }
+  if (ret != ESP_OK) {
+    CLOGE("esp_pm_lock_create failed: %s", esp_err_to_name(ret));
+    if (cpu_lock_ != nullptr) {
+      esp_pm_lock_delete(cpu_lock_);
+      cpu_lock_ = nullptr;
+    }
+    return false;
+  }
+
+  // 先持有锁再应用新配置, 启动过程不会被降频
+  esp_pm_lock_acquire(cpu_lock_);
+  esp_pm_lock_acquire(no_sleep_lock_);
+
+  esp_pm_config_t pm_config = {
+      .max_freq_mhz = static_cast<int>(config.max_freq_mhz),
+      .min_freq_mhz = static_cast<int>(config.min_freq_mhz),
+      .light_sleep_enable = config.light_sleep,
+  };
+  ret = esp_pm_configure(&pm_config);
+  if (ret == ESP_ERR_NOT_SUPPORTED && pm_config.light_sleep_enable) {
+    // 没有开启 CONFIG_FREERTOS_USE_TICKLESS_IDLE, 退回只调频
+    CLOGW("light sleep not supported, dfs only");
+    pm_config.light_sleep_enable = false;
+    ret = esp_pm_configure(&pm_config);
+  }
+  if (ret != ESP_OK) {
+    CLOGE("esp_pm_configure failed: %s", esp_err_to_name(ret));
+    esp_pm_lock_release(no_sleep_lock_);
+    esp_pm_lock_release(cpu_lock_);
+    esp_pm_lock_delete(no_sleep_lock_);
+    esp_pm_lock_delete(cpu_lock_);
+    no_sleep_lock_ = nullptr;
+    cpu_lock_ = nullptr;
+    return false;
+  }
+
+  started_ = true;
+  active_ = true;
+  light_sleep_ = pm_config.light_sleep_enable;
+  since_ = esp_timer_get_time();
+  CLOGI("max: %d MHz, min: %d MHz, light sleep: %d", pm_config.max_freq_mhz, pm_config.min_freq_mhz, light_sleep_);
+  return true;
+}
+
+void PowerManager::Stop() {
+  std::lock_guard lock(mutex_);
+  if (!started_) {
+    return;
+  }
+
+  Account(esp_timer_get_time());
+  if (active_) {
+    esp_pm_lock_release(no_sleep_lock_);
+    esp_pm_lock_release(cpu_lock_);
+  }
+  esp_pm_lock_delete(no_sleep_lock_);
+  esp_pm_lock_delete(cpu_lock_);
+  no_sleep_lock_ = nullptr;
+  cpu_lock_ = nullptr;
+  esp_pm_configure(&previous_config_);
+  started_ = false;
+  active_ = false;
+  light_sleep_ = false;
+  CLOGI("OK");
+}
+
+void PowerManager::SetActive(const bool active) {
+  std::lock_guard lock(mutex_);
+  if (!started_ || active == active_) {
+    return;
+  }
+
+  Account(esp_timer_get_time());
+  active_ = active;
+  if (active) {
+    ++wakeups_;
+    esp_pm_lock_acquire(cpu_lock_);
+    esp_pm_lock_acquire(no_sleep_lock_);
+  } else {
+    esp_pm_lock_release(no_sleep_lock_);
+    esp_pm_lock_release(cpu_lock_);
+  }
+}
+
+ai_vox::PowerStats PowerManager::stats() const {
+  std::lock_guard lock(mutex_);
+  auto standby_us = standby_us_;
+  auto active_us = active_us_;
+  if (started_) {
+    (active_ ? active_us : standby_us) += esp_timer_get_time() - since_;
+  }
+  return {
+      .enabled = started_,
+      .light_sleep = light_sleep_,
+      .standby_ms = static_cast<uint32_t>(standby_us / 1000),
+      .active_ms = static_cast<uint32_t>(active_us / 1000),
+      .wakeups = wakeups_,
+  };
+}
+
+void PowerManager::Account(const int64_t now) {
+  (active_ ? active_us_ : standby_us_) += now - since_;
+  since_ = now;
+}
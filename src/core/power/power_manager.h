@@ -0,0 +1,46 @@
+#pragma once
+
+#ifndef _POWER_MANAGER_H_
+#define _POWER_MANAGER_H_
+
+#include <esp_pm.h>
+
+#include <cstdint>
+#include <mutex>
+
+#include "ai_vox_engine.h"
+
+// 持有 CPU_FREQ_MAX 和 NO_LIGHT_SLEEP 两把锁时保持最高频率, 释放后由 esp_pm 调频并在空闲时进入 light sleep
+// 触发按键以 enable_power_save 创建, 已由 iot_button 注册为 GPIO 唤醒源
+class PowerManager {
+ public:
+  PowerManager() = default;
+  ~PowerManager();
+
+  // 保存当前的 esp_pm 配置后应用 config, 成功后处于活动状态 (持有锁); 失败时 SetActive 无效果
+  bool Start(const ai_vox::PowerConfig& config);
+  // 释放锁并恢复 Start 之前的 esp_pm 配置
+  void Stop();
+  void SetActive(const bool active);
+  ai_vox::PowerStats stats() const;
+
+ private:
+  PowerManager(const PowerManager&) = delete;
+  PowerManager& operator=(const PowerManager&) = delete;
+
+  void Account(const int64_t now);
+
+  mutable std::mutex mutex_;
+  bool started_ = false;
+  bool active_ = false;
+  bool light_sleep_ = false;
+  esp_pm_config_t previous_config_ = {};
+  esp_pm_lock_handle_t cpu_lock_ = nullptr;
+  esp_pm_lock_handle_t no_sleep_lock_ = nullptr;
+  int64_t since_ = 0;
+  int64_t standby_us_ = 0;
+  int64_t active_us_ = 0;
+  uint32_t wakeups_ = 0;
+};
+
+#endif
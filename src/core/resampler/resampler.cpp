@@ -0,0 +1,139 @@
+#include "resampler.h"
+
+#include <algorithm>
+#include <cinttypes>
+#include <cmath>
+#include <numeric>
+
+#define CLOGGER_MODULE RESAMPLER
+
+#ifndef CLOGGER_SEVERITY
+#define CLOGGER_SEVERITY CLOGGER_SEVERITY_WARN
+#endif
+
+#include "../clogger/clogger.h"
+
+namespace {
+constexpr uint32_t kTapsPerPhase = 16;
+constexpr float kPassband = 0.9f;  // 截止频率相对较低奈奎斯特频率的比例
+constexpr int kCoefficientShift = 14;
+constexpr float kPi = 3.14159265358979f;
+
+int16_t Saturate(const int32_t value) {
+  if (value > INT16_MAX) {
+    return INT16_MAX;
+  } else if (value < INT16_MIN) {
+    return INT16_MIN;
+  }
+  return static_cast<int16_t>(value);
+}
+}  // namespace
+
+Resampler::Resampler(const uint32_t input_rate, const uint32_t output_rate) : input_rate_(input_rate), output_rate_(output_rate) {
+  const auto divisor = std::gcd(input_rate, output_rate);
+  up_ = output_rate / divisor;
+  down_ = input_rate / divisor;
+  taps_ = kTapsPerPhase * ((down_ + up_ - 1) / up_);
+
+  // 原型低通滤波器工作在 up_ 倍上采样后的采样率上, Blackman 窗 sinc
+  const uint32_t length = taps_ * up_;
+  const float cutoff = kPassband * 0.5f / std::max(up_, down_);
+  std::vector<float> prototype(length);
+  float sum = 0.0f;
+  for (uint32_t i = 0; i < length; i++) {
+    const float x = i - (length - 1) * 0.5f;
+    const float sinc = x == 0.0f ? 2.0f * cutoff : sinf(2.0f * kPi * cutoff * x) / (kPi * x);
+    const float phase = 2.0f * kPi * i / (length - 1);
+    const float window = 0.42f - 0.5f * cosf(phase) + 0.08f * cosf(2.0f * phase);
+    prototype[i] = sinc * window;
+    sum += prototype[i];
+  }
+
+  // 插零后每个相位的直流增益为 1
+  coefficients_.resize(length);
+  const float scale = up_ * (1 << kCoefficientShift) / sum;
+  for (uint32_t phase = 0; phase < up_; phase++) {
+    for (uint32_t tap = 0; tap < taps_; tap++) {
+      coefficients_[phase * taps_ + tap] = static_cast<int16_t>(lrintf(prototype[phase + tap * up_] * scale));
+    }
+  }
+
+  buffer_.assign(taps_ - 1, 0);
+  position_ = taps_ - 1;
+  CLOGI("%" PRIu32 " -> %" PRIu32 " Hz, %" PRIu32 "/%" PRIu32 ", taps: %" PRIu32, input_rate_, output_rate_, up_, down_, taps_);
+}
+
+size_t Resampler::InputSamplesFor(const size_t output_samples) const {
+  if (output_samples == 0) {
+    return 0;
+  }
+
+  const size_t last = position_ + (phase_ + static_cast<uint64_t>(output_samples - 1) * down_) / up_;
+  return last < buffer_.size() ? 0 : last + 1 - buffer_.size();
+}
+
+size_t Resampler::MaxOutputSamples(const size_t input_samples) const {
+  const size_t end = buffer_.size() + input_samples;
+  if (end <= position_) {
+    return 0;
+  }
+
+  const uint64_t span = static_cast<uint64_t>(end - position_) * up_ - phase_;
+  return (span + down_ - 1) / down_;
+}
+
+size_t Resampler::Process(const int16_t *input, const size_t input_samples, int16_t *output, const size_t output_samples) {
+  buffer_.insert(buffer_.end(), input, input + input_samples);
+
+  size_t count = 0;
+  while (position_ < buffer_.size() && count < output_samples) {
+    const int16_t *coefficients = &coefficients_[phase_ * taps_];
+    const int16_t *samples = &buffer_[position_];
+    // 系数绝对值之和约为 1.3 (Q14), 32 位累加不会溢出
+    int32_t sum = 1 << (kCoefficientShift - 1);
+    for (uint32_t tap = 0; tap < taps_; tap++) {
+      sum += static_cast<int32_t>(coefficients[tap]) * samples[-static_cast<int32_t>(tap)];
+    }
+    output[count++] = Saturate(sum >> kCoefficientShift);
+
+    phase_ += down_;
+    position_ += phase_ / up_;
+    phase_ %= up_;
+  }
+
+  // 只保留下一个输出需要的历史样本
+  const size_t consumed = std::min(position_, buffer_.size()) - (taps_ - 1);
+  buffer_.erase(buffer_.begin(), buffer_.begin() + consumed);
+  position_ -= consumed;
+  return count;
+}
+
+ResamplingAudioReader::ResamplingAudioReader(std::shared_ptr<ai_vox::AudioInputDevice> audio_input_device, const uint32_t sample_rate)
+    : audio_input_device_(std::move(audio_input_device)), sample_rate_(sample_rate) {
+}
+
+bool ResamplingAudioReader::Open() {
+  const auto native_sample_rate = audio_input_device_->native_sample_rate();
+  if (native_sample_rate == 0 || native_sample_rate == sample_rate_) {
+    resampler_.reset();
+    return audio_input_device_->Open(sample_rate_);
+  }
+
+  CLOGI("device sample rate: %" PRIu32 ", resample to %" PRIu32, native_sample_rate, sample_rate_);
+  resampler_ = std::make_unique<Resampler>(native_sample_rate, sample_rate_);
+  return audio_input_device_->Open(native_sample_rate);
+}
+
+void ResamplingAudioReader::Close() {
+  audio_input_device_->Close();
+}
+
+size_t ResamplingAudioReader::Read(int16_t *pcm, const size_t samples) {
+  if (!resampler_) {
+    return audio_input_device_->Read(pcm, samples);
+  }
+
+  buffer_.resize(resampler_->InputSamplesFor(samples));
+  const auto read = audio_input_device_->Read(buffer_.data(), buffer_.size());
+  return resampler_->Process(buffer_.data(), std::min(read, buffer_.size()), pcm, samples);
+}
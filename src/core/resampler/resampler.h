@@ -0,0 +1,64 @@
+#pragma once
+
+#ifndef _RESAMPLER_H_
+#define _RESAMPLER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "../../audio_input_device.h"
+
+// 有理数倍率的定点多相 FIR 重采样器, 单声道 int16
+// 系数为 Q14, 每个相位 16 抽头 (降采样时按倍率增加), 通带约为较低奈奎斯特频率的 90%
+class Resampler {
+ public:
+  Resampler(const uint32_t input_rate, const uint32_t output_rate);
+
+  // 恰好输出 output_samples 个样本还需要输入的样本数
+  size_t InputSamplesFor(const size_t output_samples) const;
+
+  // 输入 input_samples 个样本时最多输出的样本数
+  size_t MaxOutputSamples(const size_t input_samples) const;
+
+  // 最多输出 output_samples 个样本, 未用完的输入留到下次, 返回写入 output 的样本数
+  size_t Process(const int16_t *input, const size_t input_samples, int16_t *output, const size_t output_samples);
+
+  uint32_t input_rate() const {
+    return input_rate_;
+  }
+
+  uint32_t output_rate() const {
+    return output_rate_;
+  }
+
+ private:
+  const uint32_t input_rate_;
+  const uint32_t output_rate_;
+  uint32_t up_ = 1;
+  uint32_t down_ = 1;
+  uint32_t taps_ = 0;
+  std::vector<int16_t> coefficients_;  // [相位][抽头], 抽头 0 对应最新的输入样本
+  std::vector<int16_t> buffer_;        // 最近 taps_ - 1 个历史样本 + 未处理的输入
+  size_t position_ = 0;                // 下一个输出对应的最新输入样本在 buffer_ 中的下标
+  uint32_t phase_ = 0;
+};
+
+// 以固定采样率从输入设备读取, 设备声明了不同的原生采样率时按原生采样率打开并在读取后重采样
+class ResamplingAudioReader {
+ public:
+  ResamplingAudioReader(std::shared_ptr<ai_vox::AudioInputDevice> audio_input_device, const uint32_t sample_rate);
+
+  bool Open();
+  void Close();
+  size_t Read(int16_t *pcm, const size_t samples);
+
+ private:
+  std::shared_ptr<ai_vox::AudioInputDevice> audio_input_device_;
+  const uint32_t sample_rate_;
+  std::unique_ptr<Resampler> resampler_;
+  std::vector<int16_t> buffer_;
+};
+
+#endif
@@ -0,0 +1,70 @@
+#include "resource_monitor.h"
+
+#include "../task_queue/task_queue.h"
+
+void ResourceMonitor::AddTask(const std::string& name, const uint32_t stack_size) {
+  extra_tasks_.insert_or_assign(name, stack_size);
+}
+
+std::vector<ai_vox::TaskStats> ResourceMonitor::Sample() {
+  struct QueueInfo {
+    uint32_t stack_size;
+    size_t queue_depth;
+  };
+
+  std::map<TaskHandle_t, QueueInfo> queues;
+  TaskQueue::ForEach([&queues](const TaskQueue& queue) { queues.emplace(queue.task_handle(), QueueInfo{queue.stack_depth(), queue.Size()}); });
+
+  std::vector<ai_vox::TaskStats> result;
+
+#if configUSE_TRACE_FACILITY
+  std::vector<TaskStatus_t> statuses(uxTaskGetNumberOfTasks() + 2);
+  uint32_t total_run_time = 0;
+  statuses.resize(uxTaskGetSystemState(statuses.data(), statuses.size(), &total_run_time));
+  const uint32_t elapsed = total_run_time - last_total_run_time_;
+
+  std::map<TaskHandle_t, uint32_t> run_time;
+  for (const auto& status : statuses) {
+    ai_vox::TaskStats stats{
+        .name = status.pcTaskName,
+        .cpu_percent = 0,
+        .stack_size = 0,
+        .stack_free_min = static_cast<uint32_t>(status.usStackHighWaterMark),
+        .queue_depth = 0,
+        .priority = status.uxCurrentPriority,
+    };
+
+    if (const auto it = queues.find(status.xHandle); it != queues.end()) {
+      stats.stack_size = it->second.stack_size;
+      stats.queue_depth = it->second.queue_depth;
+    } else if (const auto it = extra_tasks_.find(status.pcTaskName); it != extra_tasks_.end()) {
+      stats.stack_size = it->second;
+    } else {
+      continue;
+    }
+
+#if configGENERATE_RUN_TIME_STATS
+    run_time[status.xHandle] = status.ulRunTimeCounter;
+    if (const auto it = last_run_time_.find(status.xHandle); it != last_run_time_.end() && elapsed > 0) {
+      stats.cpu_percent = 100.0f * (status.ulRunTimeCounter - it->second) / elapsed;
+    }
+#endif
+    result.emplace_back(std::move(stats));
+  }
+
+  last_run_time_ = std::move(run_time);
+  last_total_run_time_ = total_run_time;
+#else
+  for (const auto& [handle, info] : queues) {
+    result.emplace_back(ai_vox::TaskStats{
+        .name = pcTaskGetName(handle),
+        .cpu_percent = 0,
+        .stack_size = info.stack_size,
+        .stack_free_min = static_cast<uint32_t>(uxTaskGetStackHighWaterMark(handle)),
+        .queue_depth = info.queue_depth,
+        .priority = uxTaskPriorityGet(handle),
+    });
+  }
+#endif
+  return result;
+}
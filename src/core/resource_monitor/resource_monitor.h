@@ -0,0 +1,34 @@
+#pragma once
+
+#ifndef _RESOURCE_MONITOR_H_
+#define _RESOURCE_MONITOR_H_
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "ai_vox_engine.h"
+
+class ResourceMonitor {
+ public:
+  ResourceMonitor() = default;
+
+  // 监控不是由 TaskQueue 创建的任务, 如 websocket 任务
+  void AddTask(const std::string& name, const uint32_t stack_size);
+
+  // 采样所有 TaskQueue 及额外登记的任务, CPU 占用为距上次采样的增量
+  std::vector<ai_vox::TaskStats> Sample();
+
+ private:
+  ResourceMonitor(const ResourceMonitor&) = delete;
+  ResourceMonitor& operator=(const ResourceMonitor&) = delete;
+
+  std::map<std::string, uint32_t> extra_tasks_;
+  std::map<TaskHandle_t, uint32_t> last_run_time_;
+  uint32_t last_total_run_time_ = 0;
+};
+
+#endif
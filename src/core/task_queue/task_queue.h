@@ -4,47 +4,96 @@
 #define _TASK_QUEUE_H_
 
 #include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
 #include <freertos/task.h>
 
+#include <cassert>
 #include <chrono>
 #include <condition_variable>
+#include <cstdlib>
 #include <functional>
 #include <memory>
 #include <mutex>
 #include <queue>
 #include <string>
 #include <utility>
+#include <vector>
+
+#include "../trace/trace.h"
+#include "ai_vox_heap.h"
 
 #define TASK_QUEUE_DEBUG (0)
 
 class TaskQueue {
  public:
-  TaskQueue(const std::string& name, const uint32_t stack_depth, UBaseType_t priority)
+  TaskQueue(const std::string& name, const uint32_t stack_depth, UBaseType_t priority) : TaskQueue(name, stack_depth, priority, tskNO_AFFINITY) {
+  }
+
+  // 任务栈计入 tag 对应的内存用量; 栈放在 PSRAM 的任务不能在 flash 操作期间运行, 不能写 NVS 或 OTA
+  TaskQueue(const std::string& name,
+            const uint32_t stack_depth,
+            UBaseType_t priority,
+            const BaseType_t core_id,
+            const ai_vox::HeapTag tag = ai_vox::HeapTag::kEngine,
+            const ai_vox::MemoryRegion stack_region = ai_vox::MemoryRegion::kDefault)
       :
 #if TASK_QUEUE_DEBUG
         name_(name),
 #endif
-        stack_buffer_(new StackType_t[stack_depth]),
-        task_handle_(xTaskCreateStatic(&Loop, name.c_str(), stack_depth, this, priority, stack_buffer_, &task_buffer_)) {
+        tasks_(std::greater<>(), ReservedTasks()),
+        stack_depth_(stack_depth),
+        stack_buffer_(reinterpret_cast<StackType_t*>(ai_vox::heap::Malloc(tag, stack_depth * sizeof(StackType_t), StackRegion(stack_region)))),
+        task_handle_(xTaskCreateStaticPinnedToCore(&Loop,
+                                                   name.c_str(),
+                                                   stack_depth,
+                                                   this,
+                                                   priority,
+                                                   stack_buffer_,
+                                                   &task_buffer_,
+                                                   core_id >= 0 && core_id < portNUM_PROCESSORS ? core_id : tskNO_AFFINITY)) {
     assert(stack_buffer_ != nullptr && task_handle_ != nullptr);
     if (stack_buffer_ == nullptr || task_handle_ == nullptr) {
       abort();
     }
+
+    std::lock_guard<std::mutex> lock(InstancesMutex());
+    next_ = Instances();
+    Instances() = this;
   }
 
+#if AI_VOX_STATIC_ALLOCATION
+  // 音频任务每轮对话创建一次, TCB 在对象内, 与任务栈一起从静态区分配
+  static void* operator new(size_t size) {
+    return StaticAllocate(size);
+  }
+
+  static void operator delete(void* ptr) {
+    StaticFree(ptr);
+  }
+#endif
+
   ~TaskQueue() {
-    const auto termination_sem = xSemaphoreCreateBinary();
-    Enqueue([termination_sem]() {
-      xSemaphoreGive(termination_sem);
-      vTaskDelay(portMAX_DELAY);
-    });
+    {
+      std::lock_guard<std::mutex> lock(InstancesMutex());
+      for (auto instance = &Instances(); *instance != nullptr; instance = &(*instance)->next_) {
+        if (*instance == this) {
+          *instance = next_;
+          break;
+        }
+      }
+    }
+
+    // 由 Loop 在释放完当前闭包后通知, vTaskDelete 不会执行任务栈上的析构
+    StaticSemaphore_t termination_sem_buffer;
+    const auto termination_sem = xSemaphoreCreateBinaryStatic(&termination_sem_buffer);
+    Enqueue([this, termination_sem]() { termination_sem_ = termination_sem; });
     xSemaphoreTake(termination_sem, portMAX_DELAY);
     vSemaphoreDelete(termination_sem);
 #if TASK_QUEUE_DEBUG
     printf("task %s minimum stack %u\n", name_.c_str(), uxTaskGetStackHighWaterMark(task_handle_));
 #endif
     vTaskDelete(task_handle_);
-    delete[] stack_buffer_;
+    ai_vox::heap::Free(stack_buffer_);
   }
 
   template <class F, class... Args>
@@ -72,13 +121,43 @@ class TaskQueue {
     return tasks_.size();
   }
 
+  TaskHandle_t task_handle() const {
+    return task_handle_;
+  }
+
+  uint32_t stack_depth() const {
+    return stack_depth_;
+  }
+
+  // 遍历当前存在的所有 TaskQueue, 用于资源监控
+  template <class F>
+  static void ForEach(F&& f) {
+    std::lock_guard<std::mutex> lock(InstancesMutex());
+    for (const auto* instance = Instances(); instance != nullptr; instance = instance->next_) {
+      f(*instance);
+    }
+  }
+
  private:
   TaskQueue(const TaskQueue&) = delete;
   TaskQueue& operator=(const TaskQueue&) = delete;
 
+  static constexpr size_t kReservedTasks = 16;  // 队列容量只增不减, 预留后稳态下入队不再扩容
+
   struct TaskInterface {
     virtual void Invoke() = 0;
     virtual ~TaskInterface() = default;
+
+#if AI_VOX_STATIC_ALLOCATION
+    // 每帧都要创建闭包, 从静态区分配
+    static void* operator new(size_t size) {
+      return StaticAllocate(size);
+    }
+
+    static void operator delete(void* ptr) {
+      StaticFree(ptr);
+    }
+#endif
   };
 
   template <typename Callable>
@@ -101,12 +180,94 @@ class TaskQueue {
     }
   };
 
+#if AI_VOX_STATIC_ALLOCATION
+  // 上行队列每轮对话创建一次, 任务数组也从静态区分配
+  template <typename T>
+  struct StaticAllocator {
+    using value_type = T;
+
+    StaticAllocator() = default;
+
+    template <typename U>
+    StaticAllocator(const StaticAllocator<U>&) {
+    }
+
+    T* allocate(const size_t count) {
+      return reinterpret_cast<T*>(StaticAllocate(count * sizeof(T)));
+    }
+
+    void deallocate(T* ptr, size_t) {
+      StaticFree(ptr);
+    }
+
+    bool operator==(const StaticAllocator&) const {
+      return true;
+    }
+
+    bool operator!=(const StaticAllocator&) const {
+      return false;
+    }
+  };
+
+  using TaskVector = std::vector<Task, StaticAllocator<Task>>;
+#else
+  using TaskVector = std::vector<Task>;
+#endif
+
+  static TaskVector ReservedTasks() {
+    TaskVector tasks;
+    tasks.reserve(kReservedTasks);
+    return tasks;
+  }
+
+#if AI_VOX_STATIC_ALLOCATION
+  // 静态区用尽时退回系统堆, 由 heap::StaticStats().failures 计数; 编译时未开启异常, 系统堆也用尽才终止
+  static void* StaticAllocate(const size_t size) {
+    auto ptr = ai_vox::heap::Malloc(ai_vox::HeapTag::kEngine, size);
+    if (ptr == nullptr) {
+      ptr = malloc(size);
+    }
+    if (ptr == nullptr) {
+      abort();
+    }
+    return ptr;
+  }
+
+  static void StaticFree(void* ptr) {
+    if (ai_vox::heap::Owns(ptr)) {
+      ai_vox::heap::Free(ptr);
+    } else {
+      free(ptr);
+    }
+  }
+#endif
+
+  // 侵入式单链表, 登记实例不分配内存
+  static TaskQueue*& Instances() {
+    static TaskQueue* s_instances = nullptr;
+    return s_instances;
+  }
+
+  static std::mutex& InstancesMutex() {
+    static std::mutex s_mutex;
+    return s_mutex;
+  }
+
+  // 未开启 CONFIG_SPIRAM_ALLOW_STACK_EXTERNAL_MEMORY 时 xTaskCreateStatic 不接受 PSRAM 中的栈
+  static ai_vox::MemoryRegion StackRegion(const ai_vox::MemoryRegion region) {
+#if CONFIG_SPIRAM_ALLOW_STACK_EXTERNAL_MEMORY
+    return region;
+#else
+    return region == ai_vox::MemoryRegion::kSpiram ? ai_vox::MemoryRegion::kInternal : region;
+#endif
+  }
+
   static void Loop(void* self) {
     reinterpret_cast<TaskQueue*>(self)->Loop();
   }
 
   void Loop() {
-    while (true) {
+    while (termination_sem_ == nullptr) {
       std::unique_ptr<TaskInterface> task;
       {
         std::unique_lock<std::mutex> lock(mutex_);
@@ -121,19 +282,25 @@ class TaskQueue {
         task = std::move(const_cast<Task&>(tasks_.top()).task);
         tasks_.pop();
       }
+      TRACE_SCOPE(TraceEvent::kTaskQueueInvoke, 0, 0);
       task->Invoke();
     }
+    xSemaphoreGive(termination_sem_);
+    vTaskDelay(portMAX_DELAY);
   }
 #if TASK_QUEUE_DEBUG
   const std::string name_;
 #endif
   mutable std::mutex mutex_;
   std::condition_variable condition_;
-  std::priority_queue<Task, std::vector<Task>, std::greater<>> tasks_;
+  std::priority_queue<Task, TaskVector, std::greater<>> tasks_;
+  SemaphoreHandle_t termination_sem_ = nullptr;  // 只在本任务中读写, 须在 task_handle_ 之前初始化
+  const uint32_t stack_depth_ = 0;
   StackType_t* stack_buffer_ = nullptr;
   StaticTask_t task_buffer_;
   TaskHandle_t task_handle_ = nullptr;
   uint64_t id_ = 0;
+  TaskQueue* next_ = nullptr;  // Instances() 链表, 由 InstancesMutex() 保护
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,113 @@
+#include "trace.h"
+
+#include <esp_heap_caps.h>
+#include <esp_timer.h>
+#include <freertos/task.h>
+
+#include <cinttypes>
+#include <cstdio>
+
+#include "../task_queue/task_queue.h"
+
+namespace {
+constexpr uint32_t kRecordsPerCore = AI_VOX_TRACE_RECORDS_PER_CORE;
+static_assert((kRecordsPerCore & (kRecordsPerCore - 1)) == 0, "AI_VOX_TRACE_RECORDS_PER_CORE must be a power of two");
+
+const char* EventName(const TraceEvent event) {
+  switch (event) {
+    case TraceEvent::kTaskQueueInvoke:
+      return "TaskQueue::Invoke";
+    case TraceEvent::kAudioInputPullData:
+      return "AudioInputEngine::PullData";
+    case TraceEvent::kAudioInputEncode:
+      return "AudioInputEngine::Encode";
+    case TraceEvent::kAudioOutputProcessData:
+      return "AudioOutputEngine::ProcessData";
+    case TraceEvent::kWakeNetFeedData:
+      return "WakeNet::FeedData";
+    case TraceEvent::kWakeNetDetectWakeWord:
+      return "WakeNet::DetectWakeWord";
+    case TraceEvent::kWebsocketSend:
+      return "Websocket::Send";
+    case TraceEvent::kWebsocketReceive:
+      return "Websocket::Receive";
+    default:
+      return "Unknown";
+  }
+}
+}  // namespace
+
+Tracer& Tracer::GetInstance() {
+  static Tracer s_instance;
+  return s_instance;
+}
+
+Tracer::Tracer() {
+#if AI_VOX_TRACE
+  for (auto& ring : rings_) {
+    ring.records = reinterpret_cast<TraceRecord*>(heap_caps_malloc(sizeof(TraceRecord) * kRecordsPerCore, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT));
+    if (ring.records == nullptr) {
+      ring.records = reinterpret_cast<TraceRecord*>(heap_caps_malloc(sizeof(TraceRecord) * kRecordsPerCore, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT));
+    }
+    if (ring.records == nullptr) {
+      abort();
+    }
+  }
+  enabled_.store(true, std::memory_order_release);
+#endif
+}
+
+void Tracer::Record(const TraceEvent event, const TracePhase phase, const uint32_t arg0, const uint32_t arg1) {
+  if (!enabled_.load(std::memory_order_acquire)) {
+    return;
+  }
+
+  // 每个核一个环, 同核任务之间的抢占由原子自增保证槽位不重复
+  const auto core = xPortGetCoreID();
+  auto& ring = rings_[core];
+  auto& record = ring.records[ring.head.fetch_add(1, std::memory_order_relaxed) & (kRecordsPerCore - 1)];
+  record.timestamp_us = esp_timer_get_time();
+  record.task = reinterpret_cast<uintptr_t>(xTaskGetCurrentTaskHandle());
+  record.event = static_cast<uint16_t>(event);
+  record.phase = static_cast<uint8_t>(phase);
+  record.core = static_cast<uint8_t>(core);
+  record.arg0 = arg0;
+  record.arg1 = arg1;
+}
+
+void Tracer::Dump() {
+#if AI_VOX_TRACE
+  enabled_.store(false, std::memory_order_release);
+  vTaskDelay(pdMS_TO_TICKS(10));  // 等待正在写入的记录完成
+
+  printf("[trace] begin %u %" PRIu32 "\n", static_cast<unsigned>(sizeof(TraceRecord)), kRecordsPerCore);
+  for (uint16_t i = 0; i < static_cast<uint16_t>(TraceEvent::kMax); i++) {
+    printf("[trace] event %u %s\n", i, EventName(static_cast<TraceEvent>(i)));
+  }
+
+  printf("[trace] task %08" PRIx32 " %s\n", static_cast<uint32_t>(reinterpret_cast<uintptr_t>(xTaskGetCurrentTaskHandle())), pcTaskGetName(nullptr));
+  TaskQueue::ForEach([](const TaskQueue& task_queue) {
+    const auto handle = task_queue.task_handle();
+    printf("[trace] task %08" PRIx32 " %s\n", static_cast<uint32_t>(reinterpret_cast<uintptr_t>(handle)), pcTaskGetName(handle));
+  });
+
+  for (auto& ring : rings_) {
+    const auto head = ring.head.load(std::memory_order_relaxed);
+    const auto count = head < kRecordsPerCore ? head : kRecordsPerCore;
+    for (uint32_t i = head - count; i != head; i++) {
+      const auto* bytes = reinterpret_cast<const uint8_t*>(&ring.records[i & (kRecordsPerCore - 1)]);
+      printf("[trace] record ");
+      for (size_t j = 0; j < sizeof(TraceRecord); j++) {
+        printf("%02x", bytes[j]);
+      }
+      printf("\n");
+    }
+    ring.head.store(0, std::memory_order_relaxed);
+  }
+  printf("[trace] end\n");
+
+  enabled_.store(true, std::memory_order_release);
+#else
+  printf("[trace] disabled, rebuild with -D AI_VOX_TRACE=1\n");
+#endif
+}
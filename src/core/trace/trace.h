@@ -0,0 +1,104 @@
+#pragma once
+
+#ifndef _TRACE_H_
+#define _TRACE_H_
+
+#include <freertos/FreeRTOS.h>
+
+#include <atomic>
+#include <cstdint>
+
+// 编译时加 -D AI_VOX_TRACE=1 开启事件跟踪, 关闭时所有宏为空
+#ifndef AI_VOX_TRACE
+#define AI_VOX_TRACE (0)
+#endif
+
+// 每个核的环形缓冲区记录条数
+#ifndef AI_VOX_TRACE_RECORDS_PER_CORE
+#define AI_VOX_TRACE_RECORDS_PER_CORE (1024)
+#endif
+
+enum class TraceEvent : uint16_t {
+  kTaskQueueInvoke,
+  kAudioInputPullData,
+  kAudioInputEncode,
+  kAudioOutputProcessData,
+  kWakeNetFeedData,
+  kWakeNetDetectWakeWord,
+  kWebsocketSend,
+  kWebsocketReceive,
+  kMax,
+};
+
+enum class TracePhase : uint8_t {
+  kBegin,
+  kEnd,
+  kInstant,
+};
+
+#pragma pack(push, 1)
+struct TraceRecord {
+  int64_t timestamp_us;
+  uint32_t task;
+  uint16_t event;
+  uint8_t phase;
+  uint8_t core;
+  uint32_t arg0;
+  uint32_t arg1;
+};
+#pragma pack(pop)
+
+static_assert(sizeof(TraceRecord) == 24, "TraceRecord layout is shared with tools/trace_to_chrome.py");
+
+class Tracer {
+ public:
+  static Tracer& GetInstance();
+
+  void Record(const TraceEvent event, const TracePhase phase, const uint32_t arg0, const uint32_t arg1);
+
+  // 以十六进制文本从串口输出所有记录, 输出期间暂停记录
+  void Dump();
+
+ private:
+  struct Ring {
+    TraceRecord* records = nullptr;
+    std::atomic<uint32_t> head = 0;
+  };
+
+  Tracer();
+  Tracer(const Tracer&) = delete;
+  Tracer& operator=(const Tracer&) = delete;
+
+  Ring rings_[portNUM_PROCESSORS];
+  std::atomic<bool> enabled_ = false;
+};
+
+class TraceScope {
+ public:
+  TraceScope(const TraceEvent event, const uint32_t arg0, const uint32_t arg1) : event_(event) {
+    Tracer::GetInstance().Record(event_, TracePhase::kBegin, arg0, arg1);
+  }
+
+  ~TraceScope() {
+    Tracer::GetInstance().Record(event_, TracePhase::kEnd, 0, 0);
+  }
+
+ private:
+  TraceScope(const TraceScope&) = delete;
+  TraceScope& operator=(const TraceScope&) = delete;
+
+  const TraceEvent event_;
+};
+
+#define TRACE_CONCAT_INNER(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+
+#if AI_VOX_TRACE
+#define TRACE_SCOPE(event, arg0, arg1) TraceScope TRACE_CONCAT(trace_scope_, __LINE__)(event, arg0, arg1)
+#define TRACE_INSTANT(event, arg0, arg1) Tracer::GetInstance().Record(event, TracePhase::kInstant, arg0, arg1)
+#else
+#define TRACE_SCOPE(event, arg0, arg1)
+#define TRACE_INSTANT(event, arg0, arg1)
+#endif
+
+#endif
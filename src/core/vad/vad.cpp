@@ -0,0 +1,58 @@
+#include "vad.h"
+
+#include <cmath>
+
+namespace {
+constexpr float kMinSpeechDb = 35.0f;         // 能量绝对下限, 约为 RMS 56
+constexpr float kNoiseFloorRiseRate = 0.05f;  // 噪声底缓慢上升
+constexpr float kNoiseFloorFallRate = 0.5f;   // 噪声底快速下降
+
+float EnergyDb(const int16_t* pcm, const size_t samples) {
+  if (samples == 0) {
+    return 0.0f;
+  }
+
+  int64_t sum = 0;
+  for (size_t i = 0; i < samples; i++) {
+    sum += static_cast<int32_t>(pcm[i]) * pcm[i];
+  }
+  return 10.0f * log10f(static_cast<float>(sum) / samples + 1.0f);
+}
+}  // namespace
+
+Vad::Vad(const uint32_t frame_duration, const uint32_t hangover_ms, const uint32_t threshold_db)
+    : frame_duration_(frame_duration), hangover_ms_(hangover_ms), threshold_db_(threshold_db) {
+}
+
+Vad::Event Vad::Process(const int16_t* pcm, const size_t samples) {
+  const auto energy_db = EnergyDb(pcm, samples);
+  if (noise_floor_db_ < 0) {
+    noise_floor_db_ = energy_db;
+  }
+
+  const bool speech = energy_db > kMinSpeechDb && energy_db > noise_floor_db_ + threshold_db_;
+
+  if (energy_db < noise_floor_db_) {
+    noise_floor_db_ += (energy_db - noise_floor_db_) * kNoiseFloorFallRate;
+  } else if (!speech) {
+    noise_floor_db_ += (energy_db - noise_floor_db_) * kNoiseFloorRiseRate;
+  }
+
+  if (speech) {
+    silence_ms_ = 0;
+    if (!voiced_) {
+      voiced_ = true;
+      return Event::kSpeechStart;
+    }
+    return Event::kNone;
+  }
+
+  if (voiced_) {
+    silence_ms_ += frame_duration_;
+    if (silence_ms_ >= hangover_ms_) {
+      voiced_ = false;
+      return Event::kSpeechEnd;
+    }
+  }
+  return Event::kNone;
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#ifndef _VAD_H_
+#define _VAD_H_
+
+#include <cstddef>
+#include <cstdint>
+
+class Vad {
+ public:
+  enum class Event : uint8_t {
+    kNone,
+    kSpeechStart,
+    kSpeechEnd,
+  };
+
+  Vad(const uint32_t frame_duration, const uint32_t hangover_ms, const uint32_t threshold_db);
+
+  Event Process(const int16_t* pcm, const size_t samples);
+
+  bool voiced() const {
+    return voiced_;
+  }
+
+ private:
+  const uint32_t frame_duration_;
+  const uint32_t hangover_ms_;
+  const float threshold_db_;
+  float noise_floor_db_ = -1.0f;
+  uint32_t silence_ms_ = 0;
+  bool voiced_ = false;
+};
+
+#endif
@@ -4,36 +4,110 @@
 
 #include <esp_afe_config.h>
 #include <esp_afe_sr_models.h>
+#include <esp_mn_models.h>
+#include <esp_mn_speech_commands.h>
+#include <esp_timer.h>
 #include <esp_wn_models.h>
+#include <freertos/semphr.h>
 #include <model_path.h>
 
+#include <algorithm>
 #include <cstring>
 
+#define CLOGGER_MODULE WAKE_NET
+
 #ifndef CLOGGER_SEVERITY
 #define CLOGGER_SEVERITY CLOGGER_SEVERITY_WARN
 #endif
 
 #include "core/clogger/clogger.h"
+#include "core/trace/trace.h"
+
+// 模型分区烧录后可以定义为 0, 应用镜像和 OTA 包不再携带约 570 KB 的模型, 见 tools/srmodels_to_partition.py
+#ifndef AI_VOX_WAKE_NET_EMBEDDED_MODEL
+#define AI_VOX_WAKE_NET_EMBEDDED_MODEL (1)
+#endif
 
 namespace {
 auto &g_afe_handle = ESP_AFE_SR_HANDLE;
 
+constexpr char kModelPartitionLabel[] = "model";
+constexpr uint32_t kFetchTimeoutMs = 100;
+constexpr uint32_t kCaptureMarginMs = 1000;  // 识别结束到连接建立, 开始上传之间的余量
+
+#if AI_VOX_WAKE_NET_EMBEDDED_MODEL
 constexpr uint8_t kSrmodels[] = {
 #include "srmodels.bin"
 };
+#endif
+
+srmodel_list_t *LoadModels() {
+  // esp_srmodel_init 通过 esp_partition_mmap 映射模型分区, 模型直接从 flash 读取
+  srmodel_list_t *models = esp_srmodel_init(kModelPartitionLabel);
+  if (models != nullptr && models->num > 0) {
+    CLOGI("models from partition '%s'", kModelPartitionLabel);
+    return models;
+  }
+
+  if (models != nullptr) {
+    esp_srmodel_deinit(models);
+  }
+#if AI_VOX_WAKE_NET_EMBEDDED_MODEL
+  CLOGI("models from app image");
+  return srmodel_load(kSrmodels);
+#else
+  CLOGE("no model in partition '%s'", kModelPartitionLabel);
+  return nullptr;
+#endif
+}
+
+// feed / detect 任务累计的运行时间, ESP-IDF 默认以 esp_timer 微秒计
+uint64_t TaskRunTime(TaskQueue *feed_task, TaskQueue *detect_task) {
+#if configGENERATE_RUN_TIME_STATS
+  return static_cast<uint64_t>(ulTaskGetRunTimeCounter(feed_task->task_handle())) + ulTaskGetRunTimeCounter(detect_task->task_handle());
+#else
+  return 0;
+#endif
+}
 }  // namespace
 
+struct WakeNet::CommandModel {
+  esp_mn_iface_t *multinet;
+  model_iface_data_t *data;
+  float threshold;
+};
+
 WakeNet::WakeNet(std::function<void()> &&handler) : handler_(std::move(handler)) {
-  CLOGI("OK");
-  srmodel_list_t *models = srmodel_load(kSrmodels);
-  if (models) {
-    for (int i = 0; i < models->num; i++) {
-      if (strstr(models->model_name[i], ESP_WN_PREFIX) != NULL) {
-        CLOGI("wakenet model in flash: %s", models->model_name[i]);
-      }
+}
+
+WakeNet::~WakeNet() {
+  Release();
+}
+
+bool WakeNet::Load() {
+  if (afe_data_ != nullptr) {
+    return true;
+  }
+
+  // 模型列表和 AFE 由 esp-sr 内部分配, esp-sr 没有给出其大小, 不计入 HeapTag::kWakeNet
+  srmodel_list_t *models = LoadModels();
+  if (models == nullptr) {
+    return false;
+  }
+
+  for (int i = 0; i < models->num; i++) {
+    if (strstr(models->model_name[i], ESP_WN_PREFIX) != NULL) {
+      CLOGI("wakenet model in flash: %s", models->model_name[i]);
     }
   }
 
+  // 内嵌模型只有 WakeNet, MultiNet 模型只能来自模型分区
+  const char *multinet_model_name = esp_srmodel_filter(models, ESP_MN_PREFIX, nullptr);
+  if (multinet_model_name != nullptr) {
+    CLOGI("multinet model in flash: %s", multinet_model_name);
+    command_model_name_ = multinet_model_name;
+  }
+
   afe_config_t afe_config = AFE_CONFIG_DEFAULT();
   CLOGI("esp_srmodel_filter");
   afe_config.wakenet_model_name = esp_srmodel_filter(models, ESP_WN_PREFIX, nullptr);
@@ -45,60 +119,362 @@ WakeNet::WakeNet(std::function<void()> &&handler) : handler_(std::move(handler))
 
   afe_data_ = g_afe_handle.create_from_config(&afe_config);
   CLOGI("afe_data: %p", afe_data_);
+  if (afe_data_ == nullptr) {
+    esp_srmodel_deinit(models);
+    return false;
+  }
+
+  models_ = models;
+  if (!commands_.empty()) {
+    CreateCommandModel();
+  }
+  return true;
 }
 
-WakeNet::~WakeNet() {
+void WakeNet::Release() {
+  Pause();
+  delete detect_task_;
+  detect_task_ = nullptr;
+  delete feed_task_;
+  feed_task_ = nullptr;
+  audio_reader_.reset();
+  ai_vox::heap::Free(feed_buffer_);
+  feed_buffer_ = nullptr;
+  DestroyCommandModel();
+  if (afe_data_ != nullptr) {
+    g_afe_handle.destroy(afe_data_);
+    afe_data_ = nullptr;
+  }
+  if (models_ != nullptr) {
+    esp_srmodel_deinit(static_cast<srmodel_list_t *>(models_));
+    models_ = nullptr;
+  }
   CLOGI("OK");
 }
 
-void WakeNet::Start(std::shared_ptr<ai_vox::AudioInputDevice> audio_input_device) {
-  CLOGI("audio_input_device: %p", audio_input_device.get());
-  audio_input_device->Open(16000);
-  feed_task_ = new TaskQueue("WakeNetFeed", 8 * 1024, tskIDLE_PRIORITY + 1);
-  detect_task_ = new TaskQueue("WakeNetDetect", 4 * 1024, tskIDLE_PRIORITY + 1);
+bool WakeNet::EnableCommands(const std::vector<std::vector<std::string>> &commands,
+                             const float threshold,
+                             const uint32_t window_ms,
+                             CommandHandler &&handler) {
+  DestroyCommandModel();
+  commands_ = commands;
+  command_threshold_ = threshold;
+  command_window_ms_ = window_ms;
+  command_handler_ = std::move(handler);
+  return afe_data_ != nullptr && CreateCommandModel();
+}
+
+bool WakeNet::english_commands() const {
+  return command_model_name_.find(ESP_MN_ENGLISH) != std::string::npos;
+}
+
+void WakeNet::DestroyCommandModel() {
+  if (command_model_) {
+    command_model_->multinet->destroy(command_model_->data);
+    command_model_.reset();
+  }
+
+  std::lock_guard lock(capture_mutex_);
+  ai_vox::heap::Free(capture_);
+  capture_ = nullptr;
+  capture_capacity_ = 0;
+  capture_size_ = 0;
+  capturing_ = false;
+}
+
+bool WakeNet::CreateCommandModel() {
+  if (command_model_name_.empty() || commands_.empty()) {
+    CLOGW("no multinet model");
+    return false;
+  }
+
+  // MultiNet 实例和命令表同样由 esp-sr 内部分配, 不计入 HeapTag::kWakeNet
+  // command_window_ms_ 交给 MultiNet 作为超时, 唤醒后到时未识别出命令即返回 ESP_MN_STATE_TIMEOUT
+  auto multinet = esp_mn_handle_from_name(command_model_name_.data());
+  auto data = multinet->create(command_model_name_.c_str(), command_window_ms_);
+  if (data == nullptr) {
+    CLOGE("failed to create %s", command_model_name_.c_str());
+    return false;
+  }
+
+  if (multinet->get_samp_chunksize(data) != g_afe_handle.get_fetch_chunksize(afe_data_)) {
+    CLOGE("chunk size mismatch: %d != %d", multinet->get_samp_chunksize(data), g_afe_handle.get_fetch_chunksize(afe_data_));
+    multinet->destroy(data);
+    return false;
+  }
+
+  esp_mn_commands_alloc(multinet, data);
+  esp_mn_commands_clear();
+  size_t phrase_count = 0;
+  for (size_t i = 0; i < commands_.size(); i++) {
+    for (const auto &phrase : commands_[i]) {
+      if (esp_mn_commands_add(i, phrase.c_str()) == ESP_OK) {
+        phrase_count++;
+      } else {
+        CLOGW("invalid phrase: %s", phrase.c_str());
+      }
+    }
+  }
 
-  feed_task_->Enqueue(
-      [this,
-       audio_input_device = std::move(audio_input_device),
-       afe_chunksize = g_afe_handle.get_feed_chunksize(afe_data_),
-       channels = g_afe_handle.get_total_channel_num(afe_data_)]() mutable { FeedData(std::move(audio_input_device), afe_chunksize, channels); });
-  detect_task_->Enqueue([this]() { DetectWakeWord(); });
+  // 模型不认识的音素 (如中文模型下的英文) 在 update 时才报告
+  const esp_mn_error_t *error = esp_mn_commands_update();
+  if (error != nullptr) {
+    for (int i = 0; i < error->num; i++) {
+      CLOGW("invalid phrase: %s", error->phrases[i]->string);
+    }
+    phrase_count -= std::min<size_t>(phrase_count, error->num);
+  }
+
+  if (phrase_count == 0) {
+    CLOGE("no valid phrase");
+    multinet->destroy(data);
+    return false;
+  }
+
+  CLOGI("%s: %zu commands, %zu phrases", command_model_name_.c_str(), commands_.size(), phrase_count);
+  command_model_ = std::make_unique<CommandModel>(CommandModel{multinet, data, command_threshold_});
+
+  // AFE 输出固定为 16 kHz 单声道; 分配失败时不捕获, 对话从识别结束后的麦克风数据开始
+  const size_t capacity = (command_window_ms_ + kCaptureMarginMs) * 16;
+  std::lock_guard lock(capture_mutex_);
+  capture_ = reinterpret_cast<int16_t *>(
+      ai_vox::heap::Malloc(ai_vox::HeapTag::kWakeNet, capacity * sizeof(int16_t), ai_vox::MemoryRegion::kSpiram));
+  capture_capacity_ = capture_ != nullptr ? capacity : 0;
+  if (capture_ == nullptr) {
+    CLOGW("failed to allocate the capture buffer");
+  }
+  return true;
+}
+
+void WakeNet::Start(std::shared_ptr<ai_vox::AudioInputDevice> audio_input_device,
+                    const ai_vox::TaskConfig &feed_task_config,
+                    const ai_vox::TaskConfig &detect_task_config,
+                    const ai_vox::MemoryRegion stack_region) {
+  if (!Load()) {
+    CLOGE("no wakenet model");
+    return;
+  }
+
+  if (feed_task_ == nullptr) {
+    CLOGI("audio_input_device: %p", audio_input_device.get());
+    audio_reader_ = std::make_unique<ResamplingAudioReader>(std::move(audio_input_device), 16000);
+    feed_samples_ = g_afe_handle.get_feed_chunksize(afe_data_) * g_afe_handle.get_total_channel_num(afe_data_);
+    feed_buffer_ = reinterpret_cast<int16_t *>(ai_vox::heap::Malloc(ai_vox::HeapTag::kWakeNet, feed_samples_ * sizeof(int16_t)));
+    if (feed_buffer_ == nullptr) {
+      CLOGE("failed to allocate feed buffer");
+      audio_reader_.reset();
+      return;
+    }
+    feed_task_ =
+        new TaskQueue("WakeNetFeed", 8 * 1024, feed_task_config.priority, feed_task_config.core_id, ai_vox::HeapTag::kWakeNet, stack_region);
+    detect_task_ =
+        new TaskQueue("WakeNetDetect", 4 * 1024, detect_task_config.priority, detect_task_config.core_id, ai_vox::HeapTag::kWakeNet, stack_region);
+  }
+  Resume();
+}
+
+void WakeNet::Resume() {
+  if (feed_task_ == nullptr || running_) {
+    return;
+  }
+
+  audio_reader_->Open();
+  // 丢弃上次暂停前残留在 AFE 中的音频, 避免用旧数据误唤醒
+  g_afe_handle.reset_buffer(afe_data_);
+  detecting_command_ = false;
+  {
+    std::lock_guard lock(capture_mutex_);
+    capture_size_ = 0;
+    capturing_ = false;
+    capture_detecting_ = false;
+    capture_reading_ = false;
+  }
+  {
+    std::lock_guard lock(stats_mutex_);
+    resume_time_ = esp_timer_get_time();
+    resume_run_time_ = TaskRunTime(feed_task_, detect_task_);
+  }
+  running_ = true;
+  feed_task_->Enqueue([this]() { FeedLoop(); });
+  detect_task_->Enqueue([this]() { DetectLoop(); });
   CLOGI("OK");
 }
 
-void WakeNet::Stop() {
-  if (detect_task_) {
-    delete detect_task_;
-    detect_task_ = nullptr;
+void WakeNet::Pause() {
+  std::lock_guard pause_lock(pause_mutex_);
+  if (!running_) {
+    return;
+  }
+
+  running_ = false;
+  // feed 循环最多再读一块 (32 ms), detect 循环最多再等一次 fetch 超时
+  Sync(feed_task_);
+  Sync(detect_task_);
+  audio_reader_->Close();
+  {
+    std::lock_guard lock(stats_mutex_);
+    running_time_us_ += esp_timer_get_time() - resume_time_;
+    run_time_ += TaskRunTime(feed_task_, detect_task_) - resume_run_time_;
   }
-  if (feed_task_) {
-    delete feed_task_;
-    feed_task_ = nullptr;
+  {
+    // detect 循环已退出, ReadCapture 不必再等待识别结果
+    std::lock_guard lock(capture_mutex_);
+    capturing_ = false;
+    capture_detecting_ = false;
   }
+  capture_condition_.notify_all();
   CLOGI("OK");
 }
 
-void WakeNet::FeedData(std::shared_ptr<ai_vox::AudioInputDevice> &&audio_input_device, const uint32_t afe_chunksize, const uint32_t channels) {
-  auto pcm = new int16_t[afe_chunksize * channels];
-  audio_input_device->Read(pcm, afe_chunksize * channels);
-  g_afe_handle.feed(afe_data_, pcm);
-  delete[] pcm;
+size_t WakeNet::ReadCapture(int16_t *pcm, const size_t samples) {
+  std::unique_lock lock(capture_mutex_);
+  capture_reading_ = true;
+  // 识别期间 AFE 每块输出都会通知, 识别结束和 Pause 也会通知
+  capture_condition_.wait(lock, [this, samples]() { return capture_size_ >= samples || !capture_detecting_; });
+
+  if (capture_size_ < samples && running_) {
+    // 识别已结束, 暂停后 detect 循环不再写入, 取走剩余数据后由调用方打开麦克风
+    lock.unlock();
+    Pause();
+    lock.lock();
+  }
+
+  const auto count = std::min(samples, capture_size_);
+  if (count == 0) {
+    return 0;
+  }
+
+  const auto first = std::min(count, capture_capacity_ - capture_head_);
+  memcpy(pcm, capture_ + capture_head_, first * sizeof(int16_t));
+  memcpy(pcm + first, capture_, (count - first) * sizeof(int16_t));
+  capture_head_ = (capture_head_ + count) % capture_capacity_;
+  capture_size_ -= count;
+  return count;
+}
+
+ai_vox::WakeNetStats WakeNet::stats() const {
+  std::lock_guard lock(stats_mutex_);
+  auto stats = stats_;
+  stats.running = running_;
+  auto running_time_us = running_time_us_;
+  auto run_time = run_time_;
+  if (stats.running) {
+    running_time_us += esp_timer_get_time() - resume_time_;
+    run_time += TaskRunTime(feed_task_, detect_task_) - resume_run_time_;
+  }
+  stats.cpu_percent = running_time_us > 0 ? 100.0f * run_time / running_time_us : 0;
+  return stats;
+}
 
-  feed_task_->Enqueue([this, audio_input_device = std::move(audio_input_device), afe_chunksize, channels]() mutable {
-    FeedData(std::move(audio_input_device), afe_chunksize, channels);
-  });
+void WakeNet::Sync(TaskQueue *task_queue) {
+  const auto semaphore = xSemaphoreCreateBinary();
+  task_queue->Enqueue([semaphore]() { xSemaphoreGive(semaphore); });
+  xSemaphoreTake(semaphore, portMAX_DELAY);
+  vSemaphoreDelete(semaphore);
 }
 
-void WakeNet::DetectWakeWord() {
-  afe_fetch_result_t *res = g_afe_handle.fetch(afe_data_);
-  if (res != nullptr && res->wakeup_state == WAKENET_DETECTED) {
-    CLOGI("Wake word detected");
-    if (handler_) {
-      handler_();
+void WakeNet::FeedLoop() {
+  while (running_) {
+    TRACE_SCOPE(TraceEvent::kWakeNetFeedData, feed_samples_, 0);
+    audio_reader_->Read(feed_buffer_, feed_samples_);
+    g_afe_handle.feed(afe_data_, feed_buffer_);
+  }
+}
+
+void WakeNet::DetectLoop() {
+  while (running_) {
+    // 阻塞等待 AFE 输出, 超时只是为了能在 Pause 后退出
+    afe_fetch_result_t *res = g_afe_handle.fetch_with_delay(afe_data_, pdMS_TO_TICKS(kFetchTimeoutMs));
+    if (res == nullptr || res->ret_value == ESP_FAIL) {
+      continue;
+    }
+
+    Capture(res->data, res->data_size / sizeof(int16_t));
+    if (detecting_command_) {
+      DetectCommand(res->data);
+      continue;
+    }
+
+    TRACE_SCOPE(TraceEvent::kWakeNetDetectWakeWord, res->wakeup_state, 0);
+    if (res->wakeup_state == WAKENET_DETECTED) {
+      CLOGI("Wake word detected, index: %d, volume: %.1f dB, length: %d", res->wake_word_index, res->data_volume, res->wake_word_length);
+      {
+        std::lock_guard lock(stats_mutex_);
+        stats_.detections++;
+        stats_.last_volume_db = res->data_volume;
+        stats_.last_word_ms = res->wake_word_length / 16;
+      }
+      if (handler_) {
+        handler_();
+      }
+
+      if (command_model_) {
+        command_model_->multinet->clean(command_model_->data);
+        detecting_command_ = true;
+        StartCapture();
+      }
     }
   }
-  taskYIELD();
-  detect_task_->Enqueue([this]() { DetectWakeWord(); });
+}
+
+void WakeNet::DetectCommand(int16_t *data) {
+  const auto state = command_model_->multinet->detect(command_model_->data, data);
+  if (state == ESP_MN_STATE_DETECTING) {
+    return;
+  }
+
+  int command = -1;
+  float probability = 0;
+  if (state == ESP_MN_STATE_DETECTED) {
+    const auto results = command_model_->multinet->get_results(command_model_->data);
+    if (results->num > 0) {
+      CLOGI("command: %d, phrase: %s, probability: %.2f", results->command_id[0], results->string, results->prob[0]);
+      probability = results->prob[0];
+      if (probability >= command_model_->threshold) {
+        command = results->command_id[0];
+      }
+    }
+  } else {
+    CLOGI("command timeout");
+  }
+
+  detecting_command_ = false;
+  {
+    std::lock_guard lock(capture_mutex_);
+    capture_detecting_ = false;
+  }
+  capture_condition_.notify_all();
+  command_handler_(command, probability);
+}
+
+void WakeNet::StartCapture() {
+  std::lock_guard lock(capture_mutex_);
+  if (capture_reading_ || capture_capacity_ == 0) {
+    return;
+  }
+
+  // 唤醒词本身不在缓冲区中, 从唤醒后的第一块输出开始
+  capture_head_ = 0;
+  capture_size_ = 0;
+  capturing_ = true;
+  capture_detecting_ = true;
+}
+
+void WakeNet::Capture(const int16_t *data, const size_t samples) {
+  {
+    std::lock_guard lock(capture_mutex_);
+    if (!capturing_) {
+      return;
+    }
+
+    const auto count = std::min(samples, capture_capacity_ - capture_size_);
+    const auto tail = (capture_head_ + capture_size_) % capture_capacity_;
+    const auto first = std::min(count, capture_capacity_ - tail);
+    memcpy(capture_ + tail, data, first * sizeof(int16_t));
+    memcpy(capture_, data + first, (count - first) * sizeof(int16_t));
+    capture_size_ += count;
+  }
+  capture_condition_.notify_all();
 }
 
 #endif  // ARDUINO_ESP32S3_DEV
\ No newline at end of file
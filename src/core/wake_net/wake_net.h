@@ -3,30 +3,105 @@
 #ifndef _WAKE_NET_H_
 #define _WAKE_NET_H_
 
+#include <atomic>
+#include <condition_variable>
 #include <functional>
 #include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
 
+#include "../resampler/resampler.h"
 #include "../task_queue/task_queue.h"
+#include "ai_vox_engine.h"
 #include "audio_input_device.h"
 
 struct esp_afe_sr_data_t;
 
+// feed / detect 两个任务在第一次 Start 时创建并一直保留到 Release, 对话期间 Pause 只关闭麦克风并让两个循环退出
 class WakeNet {
  public:
+  // command 为命令序号, 小于 0 表示窗口超时或置信度不足
+  using CommandHandler = std::function<void(int command, float probability)>;
+
   WakeNet(std::function<void()>&& handler);
   ~WakeNet();
 
-  void Start(std::shared_ptr<ai_vox::AudioInputDevice> audio_input_device);
-  void Stop();
+  // 加载模型并创建 AFE, 重复调用无副作用; Start 会自动调用
+  bool Load();
+  // 停止检测, 释放任务栈, 麦克风缓冲区, AFE, MultiNet 和模型, 之后可以重新 Start
+  void Release();
+
+  // 模型分区中有 MultiNet 模型时, 唤醒后的 window_ms 内把 AFE 输出交给 MultiNet 识别命令词, commands[i] 为第 i 条命令的所有说法
+  // 须在 Load 之后, Start 之前调用, Release 后再次 Load 时自动重建; 没有模型或命令词全部无效时返回 false
+  bool EnableCommands(const std::vector<std::vector<std::string>>& commands,
+                      const float threshold,
+                      const uint32_t window_ms,
+                      CommandHandler&& handler);
+  bool english_commands() const;
+
+  // 第一次调用时创建任务和缓冲区, 之后等同于 Resume, 重复调用无副作用
+  void Start(std::shared_ptr<ai_vox::AudioInputDevice> audio_input_device,
+             const ai_vox::TaskConfig& feed_task_config,
+             const ai_vox::TaskConfig& detect_task_config,
+             const ai_vox::MemoryRegion stack_region = ai_vox::MemoryRegion::kDefault);
+  void Resume();
+  // 返回时 feed / detect 循环均已退出, 麦克风已关闭, 可以交给 AudioInputEngine
+  void Pause();
+
+  // 开启命令词时, 唤醒后 AFE 的输出同时写入捕获缓冲区, 直到 Pause; 对话开始后 AudioInputEngine 经此先上传这段音频, 首句不会丢失
+  // 阻塞到读满 samples 或命令词识别结束; 识别结束后暂停 WakeNet 并取走剩余数据, 返回值小于 samples 表示之后应改从麦克风读取
+  size_t ReadCapture(int16_t* pcm, const size_t samples);
+
+  ai_vox::WakeNetStats stats() const;
 
  private:
-  void FeedData(std::shared_ptr<ai_vox::AudioInputDevice>&& audio_input_device, const uint32_t afe_chunksize, const uint32_t channels);
-  void DetectWakeWord();
+  struct CommandModel;
+
+  void FeedLoop();
+  void DetectLoop();
+  void DetectCommand(int16_t* data);
+  void StartCapture();
+  void Capture(const int16_t* data, const size_t samples);
+  bool CreateCommandModel();
+  void DestroyCommandModel();
+  void Sync(TaskQueue* task_queue);
 
   std::function<void()> handler_;
   TaskQueue* detect_task_ = nullptr;
   TaskQueue* feed_task_ = nullptr;
-  esp_afe_sr_data_t* afe_data_;
+  std::unique_ptr<ResamplingAudioReader> audio_reader_;
+  int16_t* feed_buffer_ = nullptr;
+  size_t feed_samples_ = 0;
+  void* models_ = nullptr;  // srmodel_list_t*, esp-sr 中是匿名结构体, 无法前置声明
+  esp_afe_sr_data_t* afe_data_ = nullptr;
+  std::atomic<bool> running_ = false;
+  std::mutex pause_mutex_;  // ReadCapture 在 AudioInput 任务中调用 Pause
+
+  std::string command_model_name_;
+  std::unique_ptr<CommandModel> command_model_;
+  std::vector<std::vector<std::string>> commands_;
+  float command_threshold_ = 0;
+  uint32_t command_window_ms_ = 0;
+  CommandHandler command_handler_;
+  bool detecting_command_ = false;  // 仅在 detect 任务中访问
+
+  std::mutex capture_mutex_;
+  std::condition_variable capture_condition_;
+  int16_t* capture_ = nullptr;  // 环形缓冲区, 大小为命令窗口加 kCaptureMarginMs, 写满后丢弃新数据以保留句首
+  size_t capture_capacity_ = 0;
+  size_t capture_head_ = 0;
+  size_t capture_size_ = 0;
+  bool capturing_ = false;          // 唤醒后到 Pause 之间
+  bool capture_detecting_ = false;  // 命令词识别尚未结束
+  bool capture_reading_ = false;    // 已有读者, 再次唤醒时不重置缓冲区
+
+  mutable std::mutex stats_mutex_;
+  ai_vox::WakeNetStats stats_{};
+  int64_t resume_time_ = 0;
+  int64_t running_time_us_ = 0;
+  uint64_t resume_run_time_ = 0;
+  uint64_t run_time_ = 0;
 };
 
-#endif  // _WAKE_NET_H_
\ No newline at end of file
+#endif  // _WAKE_NET_H_
@@ -3,6 +3,11 @@
 #include <cmath>
 
 namespace ai_vox {
+namespace {
+constexpr uint32_t kDmaDescNum = 2;
+constexpr uint32_t kDmaFrameNum = 480;
+}  // namespace
+
 I2sStdAudioOutputDevice::I2sStdAudioOutputDevice(gpio_num_t bclk, gpio_num_t ws, gpio_num_t dout)
     : gpio_cfg_({
           .mclk = I2S_GPIO_UNUSED,
@@ -29,8 +34,8 @@ bool I2sStdAudioOutputDevice::Open(uint32_t sample_rate) {
   i2s_chan_config_t tx_chan_cfg = {
       .id = I2S_NUM_0,
       .role = I2S_ROLE_MASTER,
-      .dma_desc_num = 2,
-      .dma_frame_num = 480,
+      .dma_desc_num = kDmaDescNum,
+      .dma_frame_num = kDmaFrameNum,
       .auto_clear_after_cb = true,
       .auto_clear_before_cb = false,
       .allow_pd = false,
@@ -95,4 +100,22 @@ size_t I2sStdAudioOutputDevice::Write(int16_t* pcm, size_t samples) {
   return buffer.size();
 }
 
+void I2sStdAudioOutputDevice::Clear() {
+  if (i2s_tx_handle_ == nullptr) {
+    return;
+  }
+
+  // 停止通道后用静音预装所有 DMA 描述符, 重新启动时从静音开始播放
+  i2s_channel_disable(i2s_tx_handle_);
+  const std::vector<int32_t> silence(kDmaFrameNum);
+  for (uint32_t i = 0; i < kDmaDescNum; i++) {
+    size_t bytes_loaded = 0;
+    i2s_channel_preload_data(i2s_tx_handle_, silence.data(), silence.size() * sizeof(silence[0]), &bytes_loaded);
+    if (bytes_loaded == 0) {
+      break;
+    }
+  }
+  i2s_channel_enable(i2s_tx_handle_);
+}
+
 }  // namespace ai_vox
\ No newline at end of file
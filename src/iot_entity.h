@@ -32,6 +32,8 @@ struct Function {
   std::string name;
   std::string description;
   std::vector<Parameter> parameters;
+  // 离线命令词, 只对无参数的函数生效; 中文 MultiNet 模型须写拼音, 如 "da kai deng"; 英文模型为空时由函数名和实体名推导, 如 "turn on led"
+  std::vector<std::string> offline_phrases = {};
 };
 
 struct Property {
@@ -0,0 +1,350 @@
+#include "wifi_station.h"
+
+#include <esp_heap_caps.h>
+#include <esp_timer.h>
+#include <nvs.h>
+#include <nvs_flash.h>
+
+#include <cinttypes>
+#include <cstring>
+
+#define CLOGGER_MODULE WIFI
+
+#ifndef CLOGGER_SEVERITY
+#define CLOGGER_SEVERITY CLOGGER_SEVERITY_WARN
+#endif
+
+#include "core/clogger/clogger.h"
+
+namespace ai_vox {
+
+namespace {
+enum Status : EventBits_t {
+  kStationStarted = 1 << 0,
+  kWifiConnected = 1 << 1,
+  kGotIp = 1 << 2,
+};
+
+constexpr char kNvsNamespace[] = "ai_vox_wifi";
+constexpr char kNvsKey[] = "ap";
+}  // namespace
+
+// 字段顺序或大小变化时 NVS 中的旧缓存长度不匹配, LoadCache 会把它当作不存在
+struct WifiStation::CachedAp {
+  char ssid[33];
+  uint8_t bssid[6];
+  uint8_t channel;
+  esp_netif_ip_info_t ip_info;  // DHCP 得到的地址, kStatic 时不保存
+  esp_ip4_addr_t dns;
+};
+
+WifiStation& WifiStation::GetInstance() {
+  static std::once_flag s_once_flag;
+  static WifiStation* s_instance = nullptr;
+  std::call_once(s_once_flag, []() { s_instance = new WifiStation(); });
+  return *s_instance;
+}
+
+WifiStation::WifiStation() : event_group_(xEventGroupCreate()) {
+  auto ret = nvs_flash_init();
+  if (ret == ESP_ERR_NVS_NO_FREE_PAGES || ret == ESP_ERR_NVS_NEW_VERSION_FOUND) {
+    ESP_ERROR_CHECK(nvs_flash_erase());
+    ret = nvs_flash_init();
+  }
+  ESP_ERROR_CHECK(ret);
+
+  ESP_ERROR_CHECK(esp_netif_init());
+  esp_event_loop_create_default();
+  ESP_ERROR_CHECK(esp_event_handler_register(WIFI_EVENT, ESP_EVENT_ANY_ID, &WifiEventHandler, this));
+  ESP_ERROR_CHECK(esp_event_handler_register(IP_EVENT, ESP_EVENT_ANY_ID, &IpEventHandler, this));
+  netif_ = esp_netif_create_default_wifi_sta();
+
+  wifi_init_config_t cfg = WIFI_INIT_CONFIG_DEFAULT();
+  if (heap_caps_get_total_size(MALLOC_CAP_SPIRAM) == 0) {
+    // 没有 PSRAM 时减少常驻的静态缓冲区, 其余按需动态分配
+    cfg.static_tx_buf_num = 0;
+    cfg.dynamic_tx_buf_num = 32;
+    cfg.tx_buf_type = 1;
+
+    cfg.static_rx_buf_num = 4;
+    cfg.dynamic_rx_buf_num = 32;
+
+    cfg.cache_tx_buf_num = 4;
+
+    cfg.rx_mgmt_buf_type = 1;
+    cfg.rx_mgmt_buf_num = 5;
+    cfg.mgmt_sbuf_num = 32;
+  }
+  ESP_ERROR_CHECK(esp_wifi_init(&cfg));
+  // 连接参数由 CachedAp 管理, 不需要驱动每次连接都写 flash
+  ESP_ERROR_CHECK(esp_wifi_set_storage(WIFI_STORAGE_RAM));
+}
+
+void WifiStation::Connect(const Config& config) {
+  std::lock_guard lock(mutex_);
+  if (0 != (xEventGroupGetBits(event_group_) & kStationStarted)) {
+    CLOGW("wifi sta already started");
+    return;
+  }
+
+  config_ = config;
+  stats_ = {};
+  connect_start_time_ = esp_timer_get_time();
+  ESP_ERROR_CHECK(esp_wifi_set_mode(WIFI_MODE_STA));
+  ApplyConfig(config_.fast_reconnect);
+  ApplyIp(true);
+  // 在 WIFI_EVENT_STA_START 中发起连接
+  ESP_ERROR_CHECK(esp_wifi_start());
+}
+
+bool WifiStation::WaitForIp(const uint32_t timeout_ms) {
+  return (xEventGroupWaitBits(event_group_, kGotIp, pdFALSE, pdTRUE, pdMS_TO_TICKS(timeout_ms)) & kGotIp) != 0;
+}
+
+bool WifiStation::IsConnected() const {
+  return (xEventGroupGetBits(event_group_) & kWifiConnected) != 0;
+}
+
+bool WifiStation::IsGotIp() const {
+  return (xEventGroupGetBits(event_group_) & kGotIp) != 0;
+}
+
+esp_netif_ip_info_t WifiStation::ip_info() const {
+  std::lock_guard lock(mutex_);
+  return ip_info_;
+}
+
+WifiStation::Stats WifiStation::stats() const {
+  std::lock_guard lock(mutex_);
+  return stats_;
+}
+
+void WifiStation::OnChatStateChanged(const ChatState state) {
+  const bool power_save = state == ChatState::kIdle || state == ChatState::kIniting || state == ChatState::kStandby;
+  std::lock_guard lock(mutex_);
+  if (power_save == power_save_) {
+    return;
+  }
+  power_save_ = power_save;
+  const auto ret = esp_wifi_set_ps(power_save ? WIFI_PS_MIN_MODEM : WIFI_PS_NONE);
+  if (ret != ESP_OK) {
+    CLOGW("esp_wifi_set_ps failed: %s", esp_err_to_name(ret));
+  }
+}
+
+void WifiStation::WifiEventHandler(void* arg, esp_event_base_t event_base, int32_t event_id, void* event_data) {
+  reinterpret_cast<WifiStation*>(arg)->WifiEventHandler(event_base, event_id, event_data);
+}
+
+void WifiStation::IpEventHandler(void* arg, esp_event_base_t event_base, int32_t event_id, void* event_data) {
+  reinterpret_cast<WifiStation*>(arg)->IpEventHandler(event_base, event_id, event_data);
+}
+
+void WifiStation::WifiEventHandler(esp_event_base_t event_base, int32_t event_id, void* event_data) {
+  switch (event_id) {
+    case WIFI_EVENT_STA_START: {
+      CLOGI("WIFI_EVENT_STA_START");
+      xEventGroupSetBits(event_group_, kStationStarted);
+      std::lock_guard lock(mutex_);
+      ++stats_.attempts;
+      ESP_ERROR_CHECK(esp_wifi_connect());
+      break;
+    }
+    case WIFI_EVENT_STA_DISCONNECTED: {
+      CLOGI("WIFI_EVENT_STA_DISCONNECTED, reason: %u", reinterpret_cast<wifi_event_sta_disconnected_t*>(event_data)->reason);
+      const bool got_ip = (xEventGroupGetBits(event_group_) & kGotIp) != 0;
+      xEventGroupClearBits(event_group_, kGotIp | kWifiConnected);
+      std::lock_guard lock(mutex_);
+      ip_info_ = {};
+      if (!got_ip && using_cache_) {
+        // 缓存的 AP 可能已更换信道或下线, 清除后回到完整扫描
+        CLOGW("cached ap failed, fallback to full scan");
+        ClearCache();
+        ApplyConfig(false);
+        ApplyIp(false);
+      }
+      if (!got_ip) {
+        ++stats_.attempts;
+      }
+      ESP_ERROR_CHECK(esp_wifi_connect());
+      break;
+    }
+    case WIFI_EVENT_STA_CONNECTED: {
+      CLOGI("WIFI_EVENT_STA_CONNECTED");
+      xEventGroupSetBits(event_group_, kWifiConnected);
+      std::lock_guard lock(mutex_);
+      if (!stats_.cached_ip) {
+        break;
+      }
+      // DHCP 已停止, 连上后直接设置地址; esp_netif 会随之发出 IP_EVENT_STA_GOT_IP
+      ESP_ERROR_CHECK(esp_netif_set_ip_info(netif_, &cached_ip_info_));
+      break;
+    }
+    default: {
+      break;
+    }
+  }
+}
+
+void WifiStation::IpEventHandler(esp_event_base_t event_base, int32_t event_id, void* event_data) {
+  switch (event_id) {
+    case IP_EVENT_STA_GOT_IP: {
+      CLOGI("IP_EVENT_STA_GOT_IP");
+      if (0 != (xEventGroupGetBits(event_group_) & kGotIp)) {
+        break;
+      }
+      {
+        std::lock_guard lock(mutex_);
+        ip_info_ = reinterpret_cast<ip_event_got_ip_t*>(event_data)->ip_info;
+        if (stats_.connect_ms == 0) {
+          const auto now = esp_timer_get_time();
+          stats_.fast_connect = using_cache_;
+          stats_.connect_ms = (now - connect_start_time_) / 1000;
+          stats_.got_ip_time = now / 1000;
+          CLOGI("got ip in %" PRIu32 " ms, attempts: %" PRIu32 ", fast connect: %d, cached ip: %d",
+                stats_.connect_ms,
+                stats_.attempts,
+                stats_.fast_connect,
+                stats_.cached_ip);
+        }
+        SaveCache();
+      }
+      xEventGroupSetBits(event_group_, kGotIp);
+      break;
+    }
+    default: {
+      break;
+    }
+  }
+}
+
+void WifiStation::ApplyConfig(const bool use_cache) {
+  CachedAp cache;
+  using_cache_ = use_cache && LoadCache(cache);
+
+  wifi_config_t wifi_config;
+  memset(&wifi_config, 0, sizeof(wifi_config));
+  wifi_config.sta.scan_method = WIFI_FAST_SCAN;
+  wifi_config.sta.sort_method = WIFI_CONNECT_AP_BY_SIGNAL;
+  wifi_config.sta.threshold.rssi = -127;
+  wifi_config.sta.pmf_cfg.capable = true;
+
+  strncpy(reinterpret_cast<char*>(wifi_config.sta.ssid), config_.ssid.c_str(), sizeof(wifi_config.sta.ssid) - 1);
+  if (!config_.password.empty()) {
+    wifi_config.sta.threshold.authmode = WIFI_AUTH_WPA2_PSK;
+    strncpy(reinterpret_cast<char*>(wifi_config.sta.password), config_.password.c_str(), sizeof(wifi_config.sta.password) - 1);
+  }
+
+  if (using_cache_) {
+    // 只扫描缓存的信道并直接连接缓存的 BSSID
+    wifi_config.sta.bssid_set = true;
+    memcpy(wifi_config.sta.bssid, cache.bssid, sizeof(wifi_config.sta.bssid));
+    wifi_config.sta.channel = cache.channel;
+    CLOGI("fast connect to %02x:%02x:%02x:%02x:%02x:%02x on channel %u",
+          cache.bssid[0],
+          cache.bssid[1],
+          cache.bssid[2],
+          cache.bssid[3],
+          cache.bssid[4],
+          cache.bssid[5],
+          cache.channel);
+  }
+
+  ESP_ERROR_CHECK(esp_wifi_set_config(WIFI_IF_STA, &wifi_config));
+}
+
+void WifiStation::ApplyIp(const bool use_cache) {
+  esp_netif_ip_info_t ip_info = {};
+  esp_ip4_addr_t dns = {};
+  CachedAp cache;
+  if (config_.ip_mode == IpMode::kStatic) {
+    ip_info = config_.static_ip;
+    dns.addr = config_.dns.addr != 0 ? config_.dns.addr : ip_info.gw.addr;
+  } else if (config_.ip_mode == IpMode::kCachedLease && use_cache && LoadCache(cache) && cache.ip_info.ip.addr != 0) {
+    ip_info = cache.ip_info;
+    dns = cache.dns.addr != 0 ? cache.dns : cache.ip_info.gw;
+  }
+
+  stats_.cached_ip = ip_info.ip.addr != 0;
+  if (!stats_.cached_ip) {
+    const auto ret = esp_netif_dhcpc_start(netif_);
+    if (ret != ESP_OK && ret != ESP_ERR_ESP_NETIF_DHCP_ALREADY_STARTED) {
+      CLOGE("esp_netif_dhcpc_start failed: %s", esp_err_to_name(ret));
+    }
+    return;
+  }
+
+  const auto ret = esp_netif_dhcpc_stop(netif_);
+  if (ret != ESP_OK && ret != ESP_ERR_ESP_NETIF_DHCP_ALREADY_STOPPED) {
+    CLOGE("esp_netif_dhcpc_stop failed: %s", esp_err_to_name(ret));
+  }
+  // 地址在 WIFI_EVENT_STA_CONNECTED 时设置, 提前设置会在关联之前就发出 IP_EVENT_STA_GOT_IP
+  cached_ip_info_ = ip_info;
+  esp_netif_dns_info_t dns_info = {};
+  dns_info.ip.type = ESP_IPADDR_TYPE_V4;
+  dns_info.ip.u_addr.ip4 = dns;
+  ESP_ERROR_CHECK(esp_netif_set_dns_info(netif_, ESP_NETIF_DNS_MAIN, &dns_info));
+}
+
+bool WifiStation::LoadCache(CachedAp& cache) const {
+  nvs_handle_t handle = 0;
+  if (ESP_OK != nvs_open(kNvsNamespace, NVS_READONLY, &handle)) {
+    return false;
+  }
+  size_t size = sizeof(cache);
+  const auto ret = nvs_get_blob(handle, kNvsKey, &cache, &size);
+  nvs_close(handle);
+  if (ret != ESP_OK || size != sizeof(cache)) {
+    return false;
+  }
+  cache.ssid[sizeof(cache.ssid) - 1] = '\0';
+  return config_.ssid == cache.ssid;
+}
+
+void WifiStation::SaveCache() {
+  wifi_ap_record_t ap_info;
+  if (ESP_OK != esp_wifi_sta_get_ap_info(&ap_info)) {
+    return;
+  }
+
+  CachedAp cache;
+  memset(&cache, 0, sizeof(cache));
+  strncpy(cache.ssid, config_.ssid.c_str(), sizeof(cache.ssid) - 1);
+  memcpy(cache.bssid, ap_info.bssid, sizeof(cache.bssid));
+  cache.channel = ap_info.primary;
+  if (config_.ip_mode != IpMode::kStatic) {
+    cache.ip_info = ip_info_;
+    esp_netif_dns_info_t dns_info = {};
+    if (ESP_OK == esp_netif_get_dns_info(netif_, ESP_NETIF_DNS_MAIN, &dns_info) && dns_info.ip.type == ESP_IPADDR_TYPE_V4) {
+      cache.dns = dns_info.ip.u_addr.ip4;
+    }
+  }
+
+  // 内容不变时不写 flash
+  CachedAp old_cache;
+  if (LoadCache(old_cache) && memcmp(&old_cache, &cache, sizeof(cache)) == 0) {
+    return;
+  }
+
+  nvs_handle_t handle = 0;
+  if (ESP_OK != nvs_open(kNvsNamespace, NVS_READWRITE, &handle)) {
+    CLOGW("nvs_open failed");
+    return;
+  }
+  if (ESP_OK != nvs_set_blob(handle, kNvsKey, &cache, sizeof(cache)) || ESP_OK != nvs_commit(handle)) {
+    CLOGW("save wifi cache failed");
+  }
+  nvs_close(handle);
+}
+
+void WifiStation::ClearCache() {
+  nvs_handle_t handle = 0;
+  if (ESP_OK != nvs_open(kNvsNamespace, NVS_READWRITE, &handle)) {
+    return;
+  }
+  nvs_erase_key(handle, kNvsKey);
+  nvs_commit(handle);
+  nvs_close(handle);
+}
+
+}  // namespace ai_vox
@@ -0,0 +1,91 @@
+#pragma once
+
+#ifndef _AI_VOX_WIFI_STATION_H_
+#define _AI_VOX_WIFI_STATION_H_
+
+#include <esp_netif.h>
+#include <esp_wifi.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/event_groups.h>
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+
+#include "ai_vox_observer.h"
+
+namespace ai_vox {
+
+// 直接使用 esp_wifi 的 STA 连接, 不能与 Arduino 的 WiFi.begin 同时使用
+// 上次连接成功的 BSSID, 信道和 IP 保存在 NVS 中, 下次启动时跳过全信道扫描直接连接, 连接失败时清除缓存并重新扫描
+class WifiStation {
+ public:
+  enum class IpMode : uint8_t {
+    kDhcp,
+    kStatic,       // 使用 Config::static_ip, 省去 DHCP
+    kCachedLease,  // 使用上次 DHCP 得到的地址, 没有缓存时退回 DHCP; 只适合路由器为本机保留了地址的网络
+  };
+
+  struct Config {
+    std::string ssid;
+    std::string password;
+    bool fast_reconnect = true;  // 使用缓存的 BSSID 和信道
+    IpMode ip_mode = IpMode::kDhcp;
+    esp_netif_ip_info_t static_ip = {};
+    esp_ip4_addr_t dns = {};  // kStatic 时使用, 0 表示使用网关
+  };
+
+  struct Stats {
+    bool fast_connect;     // 本次连接使用了缓存的 BSSID 和信道
+    bool cached_ip;        // 本次连接没有经过 DHCP
+    uint32_t attempts;     // 取得 IP 前的连接次数
+    uint32_t connect_ms;   // Connect 到取得 IP 的耗时, 未连接时为 0
+    uint32_t got_ip_time;  // 取得 IP 时自上电起的毫秒数
+  };
+
+  static WifiStation& GetInstance();
+
+  // 不阻塞, 连接在后台进行, 断开后自动重连; Engine 会等到取得 IP 后再请求配置, 所以可以紧接着调用 Engine::Start
+  void Connect(const Config& config);
+  bool WaitForIp(const uint32_t timeout_ms);
+  bool IsConnected() const;
+  bool IsGotIp() const;
+  esp_netif_ip_info_t ip_info() const;
+  Stats stats() const;
+
+  // 对话期间关闭省电以降低收发延迟, 待命时恢复 WIFI_PS_MIN_MODEM, 在 Observer 的 StateChangedEvent 中调用
+  void OnChatStateChanged(const ChatState state);
+
+ private:
+  WifiStation();
+  WifiStation(const WifiStation&) = delete;
+  WifiStation& operator=(const WifiStation&) = delete;
+
+  struct CachedAp;
+
+  static void WifiEventHandler(void* arg, esp_event_base_t event_base, int32_t event_id, void* event_data);
+  static void IpEventHandler(void* arg, esp_event_base_t event_base, int32_t event_id, void* event_data);
+
+  void WifiEventHandler(esp_event_base_t event_base, int32_t event_id, void* event_data);
+  void IpEventHandler(esp_event_base_t event_base, int32_t event_id, void* event_data);
+  void ApplyConfig(const bool use_cache);
+  void ApplyIp(const bool use_cache);
+  bool LoadCache(CachedAp& cache) const;
+  void SaveCache();
+  void ClearCache();
+
+  mutable std::mutex mutex_;
+  EventGroupHandle_t event_group_ = nullptr;
+  esp_netif_t* netif_ = nullptr;
+  Config config_;
+  esp_netif_ip_info_t ip_info_ = {};
+  esp_netif_ip_info_t cached_ip_info_ = {};  // 跳过 DHCP 时在关联后设置的地址
+  bool using_cache_ = false;
+  bool power_save_ = true;
+  int64_t connect_start_time_ = 0;
+  Stats stats_ = {};
+};
+
+}  // namespace ai_vox
+
+#endif
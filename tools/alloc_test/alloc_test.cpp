@@ -0,0 +1,356 @@
+// 每轮对话的内存分配测试 (AI_VOX_STATIC_ALLOCATION=1)
+// 按引擎的顺序走完一轮对话: 收发 JSON 控制消息, 每轮创建和销毁上行 TaskQueue, 上下行音频帧以 FlexArray 经闭包入队
+// 预热几轮后统计系统堆 (malloc / operator new) 的调用次数和静态区新切出的块数, 稳态下两者都应为 0
+// 最后占满静态区, 检查 TaskQueue 闭包退回系统堆而不是终止
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include <freertos/task.h>
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cerrno>
+#include <cinttypes>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "ai_vox_heap.h"
+#include "flex_array/flex_array.h"
+#include "json/json_reader.h"
+#include "json/json_writer.h"
+#include "task_queue/task_queue.h"
+
+namespace {
+std::atomic<bool> g_counting = false;
+std::atomic<uint64_t> g_allocations = 0;
+
+void CountAllocation() {
+  if (g_counting.load(std::memory_order_relaxed)) {
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+  }
+}
+}  // namespace
+
+// 替换 glibc 的分配函数, libstdc++ 的 operator new 也经过这里
+extern "C" {
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t count, size_t size);
+void* __libc_realloc(void* ptr, size_t size);
+void* __libc_memalign(size_t alignment, size_t size);
+void __libc_free(void* ptr);
+
+void* malloc(size_t size) {
+  CountAllocation();
+  return __libc_malloc(size);
+}
+
+void* calloc(size_t count, size_t size) {
+  CountAllocation();
+  return __libc_calloc(count, size);
+}
+
+void* realloc(void* ptr, size_t size) {
+  CountAllocation();
+  return __libc_realloc(ptr, size);
+}
+
+void* aligned_alloc(size_t alignment, size_t size) {
+  CountAllocation();
+  return __libc_memalign(alignment, size);
+}
+
+int posix_memalign(void** ptr, size_t alignment, size_t size) {
+  CountAllocation();
+  *ptr = __libc_memalign(alignment, size);
+  return *ptr != nullptr ? 0 : ENOMEM;
+}
+
+void free(void* ptr) {
+  __libc_free(ptr);
+}
+}
+
+namespace {
+using ai_vox::HeapTag;
+
+constexpr uint32_t kWarmUpConversations = 3;
+constexpr uint32_t kConversations = 50;
+constexpr uint32_t kUplinkFrames = 40;    // 60 ms 一帧, 约 2.4 s 的语音
+constexpr uint32_t kDownlinkFrames = 80;  // 约 4.8 s 的回复
+constexpr size_t kMaxMessageSize = 256;   // 与 ai_vox_engine_impl.cpp 一致
+
+const char kSessionId[] = "5f0a3c1e-9b7d-4e2a-8c61-2d4f7a9b0e13";
+const char kSttText[] = "今天天气怎么样";  // 今天天气怎么样
+const char kSentenceText[] = "今天晴, 气温 \"25\" 度\n\U0001F600";
+
+const char* const kServerMessages[] = {
+    R"({"type":"hello","transport":"websocket","session_id":"5f0a3c1e-9b7d-4e2a-8c61-2d4f7a9b0e13",)"
+    R"("audio_params":{"format":"opus","sample_rate":24000,"channels":1,"frame_duration":60}})",
+    R"({"type":"stt","text":"今天天气怎么样","session_id":"5f0a3c1e-9b7d-4e2a-8c61-2d4f7a9b0e13"})",
+    R"({"type":"llm","text":"😀","emotion":"happy","session_id":"5f0a3c1e-9b7d-4e2a-8c61-2d4f7a9b0e13"})",
+    R"({"type":"tts","state":"start","sample_rate":24000,"session_id":"5f0a3c1e-9b7d-4e2a-8c61-2d4f7a9b0e13"})",
+    R"({"type":"tts","state":"sentence_start","text":"今天晴, 气温 \"25\" 度\n😀",)"
+    R"("session_id":"5f0a3c1e-9b7d-4e2a-8c61-2d4f7a9b0e13"})",
+};
+const char kTtsStop[] = R"({"type":"tts","state":"stop","session_id":"5f0a3c1e-9b7d-4e2a-8c61-2d4f7a9b0e13"})";
+
+struct Conversation {
+  char session_id[64] = {};
+  int32_t sample_rate = 0;
+  int32_t frame_duration = 0;
+  uint32_t texts = 0;
+  uint32_t uplink_frames = 0;
+  uint32_t downlink_frames = 0;
+  bool speaking = false;
+  uint32_t errors = 0;
+};
+
+Conversation g_conversation;
+size_t g_sent_bytes = 0;
+
+void Check(const bool condition, const char* what) {
+  if (!condition) {
+    g_conversation.errors++;
+    printf("check failed: %s\n", what);
+  }
+}
+
+// 与 EngineImpl::OnJsonData 相同的字段和缓冲区
+void OnJsonData(FlexArray<uint8_t>&& data) {
+  const JsonReader root(reinterpret_cast<const char*>(data.data()), data.size());
+  char type[16];
+  if (!root.GetString("type", type, sizeof(type))) {
+    Check(false, "type");
+    return;
+  }
+
+  if (strcmp(type, "hello") == 0) {
+    Check(root.GetString("session_id", g_conversation.session_id, sizeof(g_conversation.session_id)), "session_id");
+    const auto audio_params = root.GetObject("audio_params");
+    Check(audio_params.GetInt("sample_rate", g_conversation.sample_rate), "sample_rate");
+    Check(audio_params.GetInt("frame_duration", g_conversation.frame_duration), "frame_duration");
+  } else if (strcmp(type, "stt") == 0 || strcmp(type, "tts") == 0) {
+    char state[16] = {};
+    root.GetString("state", state, sizeof(state));
+    if (strcmp(state, "start") == 0) {
+      g_conversation.speaking = true;
+    } else if (strcmp(state, "stop") == 0) {
+      g_conversation.speaking = false;
+    } else {
+      FlexArray<char> text(data.size() + 1, HeapTag::kIot);
+      Check(root.GetString("text", text.data(), text.size()), "text");
+      Check(strcmp(text.data(), strcmp(type, "stt") == 0 ? kSttText : kSentenceText) == 0, "decoded text");
+      g_conversation.texts++;
+    }
+  } else if (strcmp(type, "llm") == 0) {
+    char emotion[32];
+    Check(root.GetString("emotion", emotion, sizeof(emotion)) && strcmp(emotion, "happy") == 0, "emotion");
+  }
+}
+
+void Send(JsonWriter& writer) {
+  const auto text = writer.Finish();
+  Check(text != nullptr, "message fits");
+  g_sent_bytes += writer.size();
+}
+
+// 闭包析构时通知; Loop 释放上一个闭包后才取下一个, 所以通知时队列中之前的闭包都已归还
+class Notifier {
+ public:
+  explicit Notifier(SemaphoreHandle_t semaphore) : semaphore_(semaphore) {
+  }
+
+  Notifier(Notifier&& other) : semaphore_(other.semaphore_) {
+    other.semaphore_ = nullptr;
+  }
+
+  ~Notifier() {
+    if (semaphore_ != nullptr) {
+      xSemaphoreGive(semaphore_);
+    }
+  }
+
+ private:
+  SemaphoreHandle_t semaphore_;
+};
+
+// 设备上每 60 ms 才有一帧, 队列不会积压; 这里每入队一次就等队列清空, 让每轮的分配顺序确定
+void Drain(TaskQueue& task_queue) {
+  StaticSemaphore_t buffer;
+  const auto semaphore = xSemaphoreCreateBinaryStatic(&buffer);
+  task_queue.Enqueue([notifier = Notifier(semaphore)]() {});
+  xSemaphoreTake(semaphore, portMAX_DELAY);
+  vSemaphoreDelete(semaphore);
+}
+
+// websocket 事件回调: 复制到 FlexArray 后交给主任务
+void Receive(TaskQueue& task_queue, const char* message) {
+  FlexArray<uint8_t> frame(strlen(message), HeapTag::kIot);
+  memcpy(frame.data(), message, frame.size());
+  task_queue.Enqueue([frame = std::move(frame)]() mutable { OnJsonData(std::move(frame)); });
+  Drain(task_queue);
+}
+
+void RunConversation(TaskQueue& task_queue, const uint32_t index) {
+  char message[kMaxMessageSize];
+  {
+    JsonWriter writer(message, sizeof(message));
+    writer.Add("type", "hello").Add("version", 1).Add("transport", "websocket");
+    writer.BeginObject("audio_params").Add("format", "opus").Add("sample_rate", 16000).Add("channels", 1).Add("frame_duration", 60).EndObject();
+    Send(writer);
+  }
+  Receive(task_queue, kServerMessages[0]);
+
+  // StartListening
+  auto transmit_queue = std::make_unique<TaskQueue>("AiVoxTransmit", 1024 * 3, 5, 1, HeapTag::kWebsocket);
+  {
+    JsonWriter writer(message, sizeof(message));
+    writer.Add("session_id", g_conversation.session_id).Add("type", "listen").Add("state", "start").Add("mode", "auto");
+    Send(writer);
+  }
+  for (uint32_t i = 0; i < kUplinkFrames; i++) {
+    FlexArray<uint8_t> data(40 + i * 7 % 80, HeapTag::kAudioInput);
+    memset(data.data(), i, data.size());
+    transmit_queue->Enqueue([data = std::move(data)]() mutable {
+      g_sent_bytes += data.size();
+      g_conversation.uplink_frames++;
+    });
+    Drain(*transmit_queue);
+  }
+  {
+    JsonWriter writer(message, sizeof(message));
+    writer.Add("session_id", g_conversation.session_id).Add("type", "listen").Add("state", "stop");
+    Send(writer);
+  }
+  // StopListening
+  transmit_queue.reset();
+
+  for (uint32_t i = 1; i < std::size(kServerMessages); i++) {
+    Receive(task_queue, kServerMessages[i]);
+  }
+  for (uint32_t i = 0; i < kDownlinkFrames; i++) {
+    FlexArray<uint8_t> frame(60 + i * 13 % 200, HeapTag::kAudioOutput);
+    task_queue.Enqueue([frame = std::move(frame)]() mutable {
+      Check(frame.data() != nullptr, "audio frame");
+      g_conversation.downlink_frames++;
+    });
+    Drain(task_queue);
+  }
+
+  // 每隔一轮打断一次
+  if (index % 2 == 0) {
+    JsonWriter writer(message, sizeof(message));
+    writer.Add("session_id", g_conversation.session_id).Add("type", "abort").Add("reason", "wake_word_detected");
+    Send(writer);
+  }
+  Receive(task_queue, kTtsStop);
+
+  Check(strcmp(g_conversation.session_id, kSessionId) == 0, "session id");
+  Check(g_conversation.sample_rate == 24000 && g_conversation.frame_duration == 60, "audio params");
+  Check(!g_conversation.speaking, "tts stop");
+}
+
+int32_t CurrentBytes() {
+  int32_t bytes = 0;
+  for (const auto& stats : ai_vox::heap::Stats()) {
+    bytes += stats.current;
+  }
+  return bytes;
+}
+
+// Drain 返回时它自己的闭包可能还没归还, 稍等再比较; 泄漏时一直不相等
+bool SettlesAt(const int32_t bytes) {
+  for (uint32_t i = 0; i < 100 && CurrentBytes() != bytes; i++) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  return CurrentBytes() == bytes;
+}
+
+// 同理 Drain 和 ~TaskQueue 的小闭包可能短暂并存, 预先切出几个最小块, 不让它们的先后影响切块计数
+void ReserveSmallBlocks() {
+  void* blocks[4];
+  for (auto& block : blocks) {
+    block = ai_vox::heap::Malloc(HeapTag::kEngine, 16);
+  }
+  for (const auto block : blocks) {
+    ai_vox::heap::Free(block);
+  }
+}
+
+// 占满静态区和所有空闲链表后入队, 闭包应退回系统堆
+bool TestArenaExhausted(TaskQueue& task_queue) {
+  std::vector<void*> blocks;
+  blocks.reserve(AI_VOX_STATIC_HEAP_SIZE / 32);
+  for (size_t size = 8192; size > 0; size--) {
+    void* block = nullptr;
+    while ((block = ai_vox::heap::Malloc(HeapTag::kEngine, size)) != nullptr) {
+      blocks.push_back(block);
+    }
+  }
+
+  const auto failures = ai_vox::heap::StaticStats().failures;
+  bool invoked = false;
+  task_queue.Enqueue([&invoked, padding = std::array<uint8_t, 64>{}]() { invoked = padding.size() > 0; });
+  Drain(task_queue);
+
+  for (const auto block : blocks) {
+    ai_vox::heap::Free(block);
+  }
+  return invoked && ai_vox::heap::StaticStats().failures > failures;
+}
+}  // namespace
+
+int main() {
+  TaskQueue task_queue("AiVox", 1024 * 4, 2, 1, HeapTag::kEngine);
+  ReserveSmallBlocks();
+  const auto bytes = CurrentBytes();
+
+  for (uint32_t i = 0; i < kWarmUpConversations; i++) {
+    RunConversation(task_queue, i);
+  }
+
+  const auto carves = ai_vox::heap::StaticStats().carves;
+  g_conversation = {};
+  g_allocations = 0;
+  g_counting = true;
+  for (uint32_t i = 0; i < kConversations; i++) {
+    RunConversation(task_queue, kWarmUpConversations + i);
+  }
+  g_counting = false;
+
+  const auto stats = ai_vox::heap::StaticStats();
+  const uint64_t allocations = g_allocations;
+  printf("conversations: %u, uplink frames: %u, downlink frames: %u, texts: %u, sent: %zu bytes\n",
+         kConversations,
+         g_conversation.uplink_frames,
+         g_conversation.downlink_frames,
+         g_conversation.texts,
+         g_sent_bytes);
+  printf("system heap allocations: %" PRIu64 ", new arena blocks: %" PRIu32 ", arena carved: %zu / %zu bytes\n",
+         allocations,
+         stats.carves - carves,
+         stats.carved,
+         stats.size);
+
+  bool passed = g_conversation.errors == 0;
+  passed &= g_conversation.uplink_frames == kConversations * kUplinkFrames;
+  passed &= g_conversation.downlink_frames == kConversations * kDownlinkFrames;
+  passed &= g_conversation.texts == kConversations * 2;
+  if (allocations != 0 || stats.carves != carves || !SettlesAt(bytes)) {
+    printf("steady state is not allocation free, tracked bytes: %" PRIi32 " -> %" PRIi32 "\n", bytes, CurrentBytes());
+    passed = false;
+  }
+
+  const bool fell_back = TestArenaExhausted(task_queue);
+  printf("arena exhausted: %s\n", fell_back ? "fell back to the system heap" : "FAILED");
+  passed &= fell_back;
+
+  printf("%s\n", passed ? "PASS" : "FAIL");
+  return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#ifndef _ESP_HEAP_CAPS_H_
+#define _ESP_HEAP_CAPS_H_
+
+// 主机构建用的 esp_heap_caps 替身, 没有 PSRAM, 全部转给系统堆
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+
+#define MALLOC_CAP_8BIT (1 << 2)
+#define MALLOC_CAP_SPIRAM (1 << 10)
+#define MALLOC_CAP_INTERNAL (1 << 11)
+#define MALLOC_CAP_DEFAULT (1 << 12)
+
+inline void* heap_caps_malloc(size_t size, uint32_t) {
+  return malloc(size);
+}
+
+inline void* heap_caps_realloc(void* ptr, size_t size, uint32_t) {
+  return realloc(ptr, size);
+}
+
+inline void heap_caps_free(void* ptr) {
+  free(ptr);
+}
+
+inline size_t heap_caps_get_total_size(uint32_t caps) {
+  return caps & MALLOC_CAP_SPIRAM ? 0 : 512 << 10;
+}
+
+inline size_t heap_caps_get_largest_free_block(uint32_t) {
+  return 0;
+}
+
+#endif
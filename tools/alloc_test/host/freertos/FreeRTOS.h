@@ -0,0 +1,40 @@
+#pragma once
+
+#ifndef _FREERTOS_H_
+#define _FREERTOS_H_
+
+// 主机构建用的 FreeRTOS 替身, 只包含 ai_vox_heap.cpp 和 TaskQueue 用到的部分, 实现在 freertos_host.cpp
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+typedef int32_t BaseType_t;
+typedef uint32_t UBaseType_t;
+typedef uint32_t TickType_t;
+typedef uint8_t StackType_t;
+typedef void (*TaskFunction_t)(void*);
+
+#define pdFALSE (0)
+#define pdTRUE (1)
+#define portMAX_DELAY (static_cast<TickType_t>(0xFFFFFFFF))
+#define portNUM_PROCESSORS (2)
+#define tskNO_AFFINITY (0x7FFFFFFF)
+#define pdMS_TO_TICKS(ms) (static_cast<TickType_t>(ms))  // 1 tick = 1 ms
+
+struct portMUX_TYPE {
+  std::atomic<bool> locked;
+};
+
+#define portMUX_INITIALIZER_UNLOCKED {false}
+
+inline void taskENTER_CRITICAL(portMUX_TYPE* mux) {
+  while (mux->locked.exchange(true, std::memory_order_acquire)) {
+  }
+}
+
+inline void taskEXIT_CRITICAL(portMUX_TYPE* mux) {
+  mux->locked.store(false, std::memory_order_release);
+}
+
+#endif
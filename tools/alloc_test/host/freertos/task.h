@@ -0,0 +1,29 @@
+#pragma once
+
+#ifndef _FREERTOS_TASK_H_
+#define _FREERTOS_TASK_H_
+
+#include "FreeRTOS.h"
+
+// 任务由预先创建的线程池承载, 栈和 TCB 缓冲区不使用; 与设备一致, 创建和删除任务不分配内存
+struct HostTask;
+typedef HostTask* TaskHandle_t;
+
+struct StaticTask_t {
+  uint8_t reserved[368];
+};
+
+TaskHandle_t xTaskCreateStaticPinnedToCore(TaskFunction_t function,
+                                           const char* name,
+                                           uint32_t stack_depth,
+                                           void* parameter,
+                                           UBaseType_t priority,
+                                           StackType_t* stack_buffer,
+                                           StaticTask_t* task_buffer,
+                                           BaseType_t core_id);
+
+// 在任务中以 portMAX_DELAY 调用时一直阻塞到 vTaskDelete, 不再返回
+void vTaskDelay(TickType_t ticks);
+void vTaskDelete(TaskHandle_t task);
+
+#endif
@@ -0,0 +1,151 @@
+// FreeRTOS 替身的实现: 任务跑在复用的线程上, vTaskDelete 时用 longjmp 回到线程入口, 与设备一样不执行任务栈上的析构
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include <freertos/task.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <csetjmp>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <vector>
+
+struct HostTask {
+  std::mutex mutex;
+  std::condition_variable condition;
+  TaskFunction_t function = nullptr;  // nullptr 表示线程空闲
+  void* parameter = nullptr;
+  bool deleted = false;
+  jmp_buf exit;
+};
+
+struct HostSemaphore {
+  std::mutex mutex;
+  std::condition_variable condition;
+  bool given = false;
+  bool dynamic = false;
+};
+
+static_assert(sizeof(HostSemaphore) <= sizeof(StaticSemaphore_t), "StaticSemaphore_t is too small");
+
+namespace {
+thread_local HostTask* t_current_task = nullptr;
+
+std::mutex g_pool_mutex;
+std::vector<HostTask*> g_pool;  // 线程和 HostTask 在进程退出前一直保留
+
+void Run(HostTask* task) {
+  t_current_task = task;
+  std::unique_lock<std::mutex> lock(task->mutex);
+  while (true) {
+    task->condition.wait(lock, [task] { return task->function != nullptr; });
+    lock.unlock();
+    if (setjmp(task->exit) == 0) {
+      task->function(task->parameter);
+    }
+    lock.lock();
+    task->function = nullptr;
+    task->deleted = false;
+    task->condition.notify_all();
+  }
+}
+}  // namespace
+
+TaskHandle_t xTaskCreateStaticPinnedToCore(TaskFunction_t function,
+                                           const char*,
+                                           uint32_t,
+                                           void* parameter,
+                                           UBaseType_t,
+                                           StackType_t*,
+                                           StaticTask_t*,
+                                           BaseType_t) {
+  std::lock_guard<std::mutex> pool_lock(g_pool_mutex);
+  HostTask* task = nullptr;
+  for (auto candidate : g_pool) {
+    std::lock_guard<std::mutex> lock(candidate->mutex);
+    if (candidate->function == nullptr) {
+      task = candidate;
+      break;
+    }
+  }
+
+  // 只在同时存在的任务数创新高时扩充线程池
+  if (task == nullptr) {
+    task = new HostTask;
+    g_pool.push_back(task);
+    std::thread(Run, task).detach();
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(task->mutex);
+    task->function = function;
+    task->parameter = parameter;
+  }
+  task->condition.notify_all();
+  return task;
+}
+
+void vTaskDelay(TickType_t ticks) {
+  const auto task = t_current_task;
+  if (ticks != portMAX_DELAY || task == nullptr) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(ticks));
+    return;
+  }
+
+  {
+    std::unique_lock<std::mutex> lock(task->mutex);
+    task->condition.wait(lock, [task] { return task->deleted; });
+  }
+  longjmp(task->exit, 1);
+}
+
+// 等到任务所在的线程回到空闲, 之后再创建的任务能复用它
+void vTaskDelete(TaskHandle_t task) {
+  std::unique_lock<std::mutex> lock(task->mutex);
+  task->deleted = true;
+  task->condition.notify_all();
+  task->condition.wait(lock, [task] { return task->function == nullptr; });
+}
+
+SemaphoreHandle_t xSemaphoreCreateBinary() {
+  const auto semaphore = new HostSemaphore;
+  semaphore->dynamic = true;
+  return semaphore;
+}
+
+SemaphoreHandle_t xSemaphoreCreateBinaryStatic(StaticSemaphore_t* buffer) {
+  return new (buffer) HostSemaphore;
+}
+
+// 持锁通知: 信号量常在等待方的栈上, 等待方返回后就会销毁它
+BaseType_t xSemaphoreGive(SemaphoreHandle_t semaphore) {
+  std::lock_guard<std::mutex> lock(semaphore->mutex);
+  if (semaphore->given) {
+    return pdFALSE;
+  }
+  semaphore->given = true;
+  semaphore->condition.notify_one();
+  return pdTRUE;
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t semaphore, TickType_t ticks) {
+  std::unique_lock<std::mutex> lock(semaphore->mutex);
+  const auto given = [semaphore] { return semaphore->given; };
+  if (ticks == portMAX_DELAY) {
+    semaphore->condition.wait(lock, given);
+  } else if (!semaphore->condition.wait_for(lock, std::chrono::milliseconds(ticks), given)) {
+    return pdFALSE;
+  }
+  semaphore->given = false;
+  return pdTRUE;
+}
+
+void vSemaphoreDelete(SemaphoreHandle_t semaphore) {
+  if (semaphore->dynamic) {
+    delete semaphore;
+  } else {
+    semaphore->~HostSemaphore();
+  }
+}
@@ -0,0 +1,410 @@
+#!/usr/bin/env python3
+"""Local stand-in xiaozhi server for end-to-end conversation benchmarks.
+
+Serves the OTA config endpoint and the websocket protocol (hello, listen, stt,
+tts start/sentence/stop, iot) on a single port using only the standard library,
+and streams canned Opus TTS back to the device. Pair it with the
+examples/esp32s3/conversation_bench firmware:
+
+    python3 tools/bench/bench_server.py --port 8000 --conversations 10 \\
+        --tts tts.opus --serial /dev/ttyUSB0 --output result.json
+
+--tts takes an Ogg Opus file encoded with 60 ms frames, e.g.
+`opusenc --framesize 60 speech.wav tts.opus`. Without it, silent (DTX) frames
+are sent. --serial (requires pyserial) captures the BENCH_RESULT line the
+firmware prints and merges the device-side latencies into the output JSON.
+
+With firmware built with -DAI_VOX_STATIC_ALLOCATION=1, --check-steady-state
+exits non-zero if any conversation after the first carved a new block out of
+the static heap, i.e. the engine did not run on recycled memory alone.
+"""
+
+import argparse
+import asyncio
+import base64
+import hashlib
+import json
+import statistics
+import struct
+import sys
+import time
+import uuid
+
+WEBSOCKET_GUID = "258EAFA5-E914-47DA-95CA-C5AB0DC85B11"
+FRAME_DURATION_MS = 60
+SILENT_OPUS_FRAME = bytes([0x58])  # SILK WB 60 ms, 空帧, 解码器输出静音
+OPCODE_TEXT = 0x1
+OPCODE_BINARY = 0x2
+OPCODE_CLOSE = 0x8
+OPCODE_PING = 0x9
+OPCODE_PONG = 0xA
+
+
+def now_ms():
+    return time.monotonic() * 1000.0
+
+
+def load_ogg_opus(path):
+    """Return the Opus packets of an Ogg Opus file, skipping OpusHead/OpusTags."""
+    with open(path, "rb") as f:
+        data = f.read()
+    packets = []
+    packet = b""
+    offset = 0
+    while offset + 27 <= len(data):
+        if data[offset:offset + 4] != b"OggS":
+            raise ValueError("invalid ogg page at offset %d" % offset)
+        segment_count = data[offset + 26]
+        lacing = data[offset + 27:offset + 27 + segment_count]
+        offset += 27 + segment_count
+        for length in lacing:
+            packet += data[offset:offset + length]
+            offset += length
+            if length < 255:
+                packets.append(packet)
+                packet = b""
+    packets = [p for p in packets if not p.startswith(b"OpusHead") and not p.startswith(b"OpusTags")]
+    for p in packets:
+        if opus_packet_duration_ms(p) != FRAME_DURATION_MS:
+            sys.exit("%s: packets must be %d ms, encode with --framesize %d" % (path, FRAME_DURATION_MS, FRAME_DURATION_MS))
+    return packets
+
+
+def opus_packet_duration_ms(packet):
+    config = packet[0] >> 3
+    if config < 12:
+        frame_ms = [10, 20, 40, 60][config % 4]
+    elif config < 16:
+        frame_ms = [10, 20][config % 2]
+    else:
+        frame_ms = [2.5, 5, 10, 20][config % 4]
+    code = packet[0] & 0x3
+    frames = 1 if code == 0 else 2 if code in (1, 2) else packet[1] & 0x3F
+    return frame_ms * frames
+
+
+def percentile(values, percent):
+    if not values:
+        return None
+    ordered = sorted(values)
+    return ordered[min(len(ordered) - 1, int(round(percent / 100.0 * (len(ordered) - 1))))]
+
+
+def summarize(values):
+    if not values:
+        return {"count": 0}
+    return {
+        "count": len(values),
+        "min_ms": round(min(values), 2),
+        "avg_ms": round(statistics.mean(values), 2),
+        "p50_ms": round(percentile(values, 50), 2),
+        "p90_ms": round(percentile(values, 90), 2),
+        "max_ms": round(max(values), 2),
+    }
+
+
+class WebSocket:
+    def __init__(self, reader, writer):
+        self.reader = reader
+        self.writer = writer
+        self.lock = asyncio.Lock()
+
+    async def receive(self):
+        head = await self.reader.readexactly(2)
+        opcode = head[0] & 0x0F
+        length = head[1] & 0x7F
+        if length == 126:
+            length = struct.unpack(">H", await self.reader.readexactly(2))[0]
+        elif length == 127:
+            length = struct.unpack(">Q", await self.reader.readexactly(8))[0]
+        mask = await self.reader.readexactly(4) if head[1] & 0x80 else b"\0\0\0\0"
+        payload = bytearray(await self.reader.readexactly(length))
+        for i in range(length):
+            payload[i] ^= mask[i & 3]
+        return opcode, bytes(payload)
+
+    async def send(self, opcode, payload):
+        if len(payload) < 126:
+            head = struct.pack(">BB", 0x80 | opcode, len(payload))
+        elif len(payload) < 65536:
+            head = struct.pack(">BBH", 0x80 | opcode, 126, len(payload))
+        else:
+            head = struct.pack(">BBQ", 0x80 | opcode, 127, len(payload))
+        async with self.lock:
+            self.writer.write(head + payload)
+            await self.writer.drain()
+
+    async def send_json(self, obj):
+        await self.send(OPCODE_TEXT, json.dumps(obj, ensure_ascii=False).encode())
+
+
+class Session:
+    def __init__(self, server, ws):
+        self.server = server
+        self.ws = ws
+        self.session_id = str(uuid.uuid4())
+        self.connected_time = now_ms()
+        self.listening = False
+        self.listen_start_time = None
+        self.first_frame_time = None
+        self.last_frame_time = None
+        self.frames = 0
+        self.responding = None
+        self.abort_event = asyncio.Event()
+
+    async def run(self):
+        watchdog = asyncio.ensure_future(self.endpoint_watchdog())
+        try:
+            while True:
+                opcode, payload = await self.ws.receive()
+                if opcode == OPCODE_CLOSE:
+                    await self.ws.send(OPCODE_CLOSE, payload[:2])
+                    break
+                elif opcode == OPCODE_PING:
+                    await self.ws.send(OPCODE_PONG, payload)
+                elif opcode == OPCODE_TEXT:
+                    await self.on_json(json.loads(payload))
+                elif opcode == OPCODE_BINARY:
+                    self.on_audio(payload)
+        except (asyncio.IncompleteReadError, asyncio.CancelledError, ConnectionError):
+            pass
+        finally:
+            watchdog.cancel()
+            if self.responding:
+                self.responding.cancel()
+
+    async def on_json(self, message):
+        kind = message.get("type")
+        if kind == "hello":
+            self.server.record("connect_to_hello_ms", now_ms() - self.connected_time)
+            await self.ws.send_json({
+                "type": "hello",
+                "transport": "websocket",
+                "session_id": self.session_id,
+                "audio_params": {"format": "opus", "sample_rate": 24000, "channels": 1, "frame_duration": FRAME_DURATION_MS},
+            })
+        elif kind == "listen":
+            state = message.get("state")
+            if state == "start":
+                self.listening = True
+                self.listen_start_time = now_ms()
+                self.first_frame_time = None
+                self.last_frame_time = None
+                self.frames = 0
+            elif state == "stop" and self.listening:
+                self.respond()
+        elif kind == "abort":
+            self.server.abort_time = now_ms()
+            self.abort_event.set()
+        elif kind == "iot":
+            self.server.iot_messages += 1
+
+    def on_audio(self, payload):
+        if not self.listening:
+            return
+        if self.first_frame_time is None:
+            self.first_frame_time = now_ms()
+            self.server.record("listen_to_first_frame_ms", self.first_frame_time - self.listen_start_time)
+        self.last_frame_time = now_ms()
+        self.frames += 1
+        self.server.uplink_bytes += len(payload)
+        if self.frames * FRAME_DURATION_MS >= self.server.args.utterance_ms:
+            self.respond()
+
+    async def endpoint_watchdog(self):
+        # 设备未开启 VAD 时不会发送 listen stop, 以上行音频停顿作为语音结束
+        while True:
+            await asyncio.sleep(0.05)
+            if self.listening and self.last_frame_time is not None and now_ms() - self.last_frame_time > self.server.args.silence_ms:
+                self.respond()
+
+    def respond(self):
+        self.listening = False
+        self.abort_event.clear()
+        self.responding = asyncio.ensure_future(self.speak())
+
+    async def speak(self):
+        args = self.server.args
+        if self.last_frame_time is not None:
+            self.server.record("last_frame_to_stt_ms", now_ms() - self.last_frame_time)
+        await self.ws.send_json({"session_id": self.session_id, "type": "stt", "text": args.stt_text})
+        await self.ws.send_json({"session_id": self.session_id, "type": "llm", "emotion": "happy", "text": "😀"})
+        if args.iot:
+            await self.ws.send_json({
+                "session_id": self.session_id,
+                "type": "iot",
+                "commands": [{"name": "Speaker", "method": "SetVolume", "parameters": {"volume": 60}}],
+            })
+        await asyncio.sleep(args.tts_delay_ms / 1000.0)
+        await self.ws.send_json({"session_id": self.session_id, "type": "tts", "state": "start"})
+        await self.ws.send_json({"session_id": self.session_id, "type": "tts", "state": "sentence_start", "text": args.tts_text})
+
+        start = now_ms()
+        aborted = False
+        for i, packet in enumerate(self.server.tts_packets):
+            if self.abort_event.is_set():
+                aborted = True
+                break
+            await self.ws.send(OPCODE_BINARY, packet)
+            self.server.downlink_bytes += len(packet)
+            # 前几帧立即发送作为预缓冲, 之后按实时速率发送
+            delay = start + (i + 1 - args.prebuffer_frames) * FRAME_DURATION_MS - now_ms()
+            if delay > 0:
+                try:
+                    await asyncio.wait_for(self.abort_event.wait(), delay / 1000.0)
+                except asyncio.TimeoutError:
+                    pass
+
+        await self.ws.send_json({"session_id": self.session_id, "type": "tts", "state": "sentence_end", "text": args.tts_text})
+        await self.ws.send_json({"session_id": self.session_id, "type": "tts", "state": "stop"})
+        if aborted:
+            self.server.record("abort_to_tts_stop_ms", now_ms() - self.server.abort_time)
+        self.server.conversation_done(aborted)
+
+
+class BenchServer:
+    def __init__(self, args):
+        self.args = args
+        self.tts_packets = load_ogg_opus(args.tts) if args.tts else [SILENT_OPUS_FRAME] * (args.tts_ms // FRAME_DURATION_MS)
+        self.metrics = {}
+        self.conversations = 0
+        self.aborted = 0
+        self.iot_messages = 0
+        self.uplink_bytes = 0
+        self.downlink_bytes = 0
+        self.abort_time = 0
+        self.device_result = None
+        self.done = asyncio.Event()
+
+    def record(self, name, value):
+        self.metrics.setdefault(name, []).append(value)
+
+    def conversation_done(self, aborted):
+        self.conversations += 1
+        self.aborted += int(aborted)
+        print("conversation %d done%s" % (self.conversations, " (aborted)" if aborted else ""), file=sys.stderr)
+        if self.args.conversations and self.conversations >= self.args.conversations and not self.args.serial:
+            self.done.set()
+
+    async def handle(self, reader, writer):
+        try:
+            request = await reader.readuntil(b"\r\n\r\n")
+        except (asyncio.IncompleteReadError, asyncio.LimitOverrunError):
+            writer.close()
+            return
+        lines = request.decode(errors="replace").split("\r\n")
+        method, path = lines[0].split(" ")[:2]
+        headers = {}
+        for line in lines[1:]:
+            if ":" in line:
+                key, value = line.split(":", 1)
+                headers[key.strip().lower()] = value.strip()
+
+        if headers.get("upgrade", "").lower() == "websocket":
+            accept = base64.b64encode(hashlib.sha1((headers["sec-websocket-key"] + WEBSOCKET_GUID).encode()).digest()).decode()
+            writer.write(("HTTP/1.1 101 Switching Protocols\r\nUpgrade: websocket\r\nConnection: Upgrade\r\n"
+                          "Sec-WebSocket-Accept: %s\r\n\r\n" % accept).encode())
+            await writer.drain()
+            await Session(self, WebSocket(reader, writer)).run()
+        else:
+            length = int(headers.get("content-length", "0"))
+            if length:
+                await reader.readexactly(length)
+            if method == "POST" and path.startswith("/xiaozhi/ota"):
+                body = json.dumps({"firmware": {"version": "0.0.0", "url": ""}}).encode()
+                writer.write(b"HTTP/1.1 200 OK\r\nContent-Type: application/json\r\nContent-Length: %d\r\nConnection: close\r\n\r\n" % len(body) + body)
+            else:
+                writer.write(b"HTTP/1.1 404 Not Found\r\nContent-Length: 0\r\nConnection: close\r\n\r\n")
+            await writer.drain()
+        writer.close()
+
+    async def read_serial(self):
+        import serial  # pyserial, 仅在使用 --serial 时需要
+
+        port = serial.Serial(self.args.serial, self.args.baudrate, timeout=0.1)
+        loop = asyncio.get_running_loop()
+        while not self.done.is_set():
+            line = await loop.run_in_executor(None, port.readline)
+            if not line:
+                continue
+            text = line.decode(errors="replace").rstrip()
+            if self.args.verbose:
+                print(text, file=sys.stderr)
+            if text.startswith("BENCH_RESULT "):
+                self.device_result = json.loads(text[len("BENCH_RESULT "):])
+                self.done.set()
+
+    def result(self):
+        result = {
+            "conversations": self.conversations,
+            "aborted": self.aborted,
+            "iot_messages": self.iot_messages,
+            "uplink_bytes": self.uplink_bytes,
+            "downlink_bytes": self.downlink_bytes,
+            "server": {name: summarize(values) for name, values in sorted(self.metrics.items())},
+        }
+        if self.device_result is not None:
+            result["device"] = self.device_result
+        return result
+
+
+def check_steady_state(device_result):
+    if device_result is None:
+        sys.exit("--check-steady-state needs the device result, pass --serial")
+    if device_result.get("static_heap", {}).get("size", 0) == 0:
+        sys.exit("firmware was not built with AI_VOX_STATIC_ALLOCATION=1")
+    conversations = device_result["conversations"]
+    if len(conversations) < 2:
+        sys.exit("need at least 2 conversations to check the steady state")
+    carves = [conversation["static_heap_carves"] for conversation in conversations[1:]]
+    if any(carves) or device_result["static_heap"]["failures"]:
+        sys.exit("static heap not in steady state: carves per conversation %s, failures %d" % (carves, device_result["static_heap"]["failures"]))
+    print("steady state: no static heap blocks carved after the first conversation", file=sys.stderr)
+
+
+async def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--host", default="0.0.0.0")
+    parser.add_argument("--port", type=int, default=8000)
+    parser.add_argument("--conversations", type=int, default=0, help="stop after N conversations (0: run forever)")
+    parser.add_argument("--timeout", type=float, default=600, help="give up after this many seconds")
+    parser.add_argument("--tts", help="Ogg Opus file with 60 ms frames to stream as TTS")
+    parser.add_argument("--tts-ms", type=int, default=3000, help="length of the silent TTS when --tts is not given")
+    parser.add_argument("--tts-delay-ms", type=int, default=0, help="simulated LLM/TTS latency before tts start")
+    parser.add_argument("--prebuffer-frames", type=int, default=3)
+    parser.add_argument("--utterance-ms", type=int, default=10000, help="force end of utterance after this much uplink audio")
+    parser.add_argument("--silence-ms", type=int, default=800, help="end of utterance after this uplink gap")
+    parser.add_argument("--stt-text", default="你好")
+    parser.add_argument("--tts-text", default="你好, 有什么可以帮你?")
+    parser.add_argument("--iot", action="store_true", help="send a Speaker.SetVolume iot command each turn")
+    parser.add_argument("--serial", help="device serial port to capture BENCH_RESULT from (requires pyserial)")
+    parser.add_argument("--baudrate", type=int, default=115200)
+    parser.add_argument("--check-steady-state", action="store_true", help="fail unless conversations after the first carve no static heap blocks")
+    parser.add_argument("--output", default="-", help="result JSON file, '-' for stdout")
+    parser.add_argument("--verbose", action="store_true")
+    args = parser.parse_args()
+
+    bench = BenchServer(args)
+    server = await asyncio.start_server(bench.handle, args.host, args.port)
+    print("listening on %s:%d" % (args.host, args.port), file=sys.stderr)
+    tasks = [asyncio.ensure_future(bench.done.wait())]
+    if args.serial:
+        tasks.append(asyncio.ensure_future(bench.read_serial()))
+    done, _ = await asyncio.wait(tasks, timeout=args.timeout, return_when=asyncio.FIRST_COMPLETED)
+    server.close()
+
+    result = bench.result()
+    with (sys.stdout if args.output == "-" else open(args.output, "w")) as f:
+        json.dump(result, f, indent=2, ensure_ascii=False)
+        f.write("\n")
+    if not bench.done.is_set():
+        sys.exit("timed out after %.0f s" % args.timeout)
+    if args.check_steady_state:
+        check_steady_state(bench.device_result)
+
+
+if __name__ == "__main__":
+    try:
+        asyncio.run(main())
+    except KeyboardInterrupt:
+        pass
@@ -0,0 +1,253 @@
+// 把 WAV 或 Ogg Opus 文件打包成提示音分区镜像, 格式见 src/core/earcon/earcon_partition.h
+// WAV 须为单声道 16 bit, 采样率为 8/12/16/24/48 kHz 之一; Ogg Opus 的数据包原样写入
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "opus.h"
+
+namespace {
+constexpr char kMagic[4] = {'A', 'V', 'E', 'C'};
+constexpr uint16_t kVersion = 1;
+constexpr size_t kHeaderSize = 8;
+constexpr size_t kEntrySize = 32;
+constexpr size_t kNameSize = 24;
+constexpr size_t kMaxPacketSize = 1500;
+
+struct Options {
+  std::string output;
+  int bitrate = 32000;
+  int frame_duration = 20;
+  size_t size = 0;  // 非 0 时用 0xFF 填充到分区大小
+};
+
+struct Clip {
+  std::string name;
+  std::vector<uint8_t> data;  // [uint16_t 长度][Opus 数据包]...
+};
+
+bool EndsWith(const std::string& value, const std::string& suffix) {
+  return value.size() >= suffix.size() && value.compare(value.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+void AppendU16(std::vector<uint8_t>& data, const uint32_t value) {
+  data.push_back(value & 0xFF);
+  data.push_back(value >> 8 & 0xFF);
+}
+
+void AppendU32(std::vector<uint8_t>& data, const uint32_t value) {
+  AppendU16(data, value & 0xFFFF);
+  AppendU16(data, value >> 16);
+}
+
+void AppendPacket(std::vector<uint8_t>& data, const uint8_t* packet, const size_t size) {
+  AppendU16(data, size);
+  data.insert(data.end(), packet, packet + size);
+}
+
+bool LoadWav(const std::string& path, std::vector<int16_t>& pcm, uint32_t& sample_rate) {
+  std::ifstream file(path, std::ios::binary);
+  char riff[12];
+  if (!file.read(riff, sizeof(riff)) || memcmp(riff, "RIFF", 4) != 0 || memcmp(riff + 8, "WAVE", 4) != 0) {
+    fprintf(stderr, "%s: not a wav file\n", path.c_str());
+    return false;
+  }
+
+  char id[4];
+  uint32_t size = 0;
+  while (file.read(id, sizeof(id)) && file.read(reinterpret_cast<char*>(&size), sizeof(size))) {
+    if (memcmp(id, "fmt ", 4) == 0) {
+      std::vector<uint8_t> fmt(size);
+      file.read(reinterpret_cast<char*>(fmt.data()), size);
+      const uint16_t channels = fmt[2] | fmt[3] << 8;
+      sample_rate = fmt[4] | fmt[5] << 8 | fmt[6] << 16 | fmt[7] << 24;
+      const uint16_t bits = fmt[14] | fmt[15] << 8;
+      const bool opus_rate = sample_rate == 8000 || sample_rate == 12000 || sample_rate == 16000 || sample_rate == 24000 || sample_rate == 48000;
+      if (channels != 1 || bits != 16 || !opus_rate) {
+        fprintf(stderr, "%s: need mono 16 bit at 8/12/16/24/48 kHz, got %u ch %u Hz %u bit\n", path.c_str(), channels, sample_rate, bits);
+        return false;
+      }
+    } else if (memcmp(id, "data", 4) == 0) {
+      pcm.resize(size / sizeof(int16_t));
+      file.read(reinterpret_cast<char*>(pcm.data()), pcm.size() * sizeof(int16_t));
+      return sample_rate != 0;
+    } else {
+      file.seekg(size + (size & 1), std::ios::cur);
+    }
+  }
+  fprintf(stderr, "%s: no data chunk\n", path.c_str());
+  return false;
+}
+
+bool EncodeWav(const std::string& path, const Options& options, std::vector<uint8_t>& data) {
+  std::vector<int16_t> pcm;
+  uint32_t sample_rate = 0;
+  if (!LoadWav(path, pcm, sample_rate)) {
+    return false;
+  }
+
+  int error = 0;
+  auto encoder = opus_encoder_create(sample_rate, 1, OPUS_APPLICATION_AUDIO, &error);
+  if (encoder == nullptr) {
+    fprintf(stderr, "opus_encoder_create failed: %d\n", error);
+    return false;
+  }
+  opus_encoder_ctl(encoder, OPUS_SET_BITRATE(options.bitrate));
+  opus_encoder_ctl(encoder, OPUS_SET_COMPLEXITY(10));
+
+  // 最后一帧补零
+  const size_t frame_size = sample_rate / 1000 * options.frame_duration;
+  pcm.resize((pcm.size() + frame_size - 1) / frame_size * frame_size);
+  uint8_t packet[kMaxPacketSize];
+  for (size_t offset = 0; offset < pcm.size(); offset += frame_size) {
+    const auto ret = opus_encode(encoder, pcm.data() + offset, frame_size, packet, sizeof(packet));
+    if (ret < 0) {
+      fprintf(stderr, "%s: opus_encode failed: %d\n", path.c_str(), ret);
+      opus_encoder_destroy(encoder);
+      return false;
+    }
+    AppendPacket(data, packet, ret);
+  }
+  opus_encoder_destroy(encoder);
+  return true;
+}
+
+// 逐页解析 Ogg, 跳过前两个包 (OpusHead, OpusTags)
+bool LoadOggOpus(const std::string& path, std::vector<uint8_t>& data) {
+  std::ifstream file(path, std::ios::binary);
+  std::vector<uint8_t> bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+  std::vector<uint8_t> packet;
+  size_t packet_index = 0;
+  size_t offset = 0;
+  while (offset + 27 <= bytes.size()) {
+    if (memcmp(&bytes[offset], "OggS", 4) != 0) {
+      fprintf(stderr, "%s: bad ogg page at %zu\n", path.c_str(), offset);
+      return false;
+    }
+
+    const size_t segments = bytes[offset + 26];
+    const uint8_t* lacing = &bytes[offset + 27];
+    size_t body = offset + 27 + segments;
+    for (size_t i = 0; i < segments; i++) {
+      if (body + lacing[i] > bytes.size()) {
+        fprintf(stderr, "%s: truncated ogg page\n", path.c_str());
+        return false;
+      }
+      packet.insert(packet.end(), &bytes[body], &bytes[body] + lacing[i]);
+      body += lacing[i];
+      if (lacing[i] < 255) {
+        if (packet_index++ >= 2) {
+          AppendPacket(data, packet.data(), packet.size());
+        }
+        packet.clear();
+      }
+    }
+    offset = body;
+  }
+
+  if (packet_index < 2) {
+    fprintf(stderr, "%s: not an ogg opus file\n", path.c_str());
+    return false;
+  }
+  return true;
+}
+
+void Usage(const char* program) {
+  fprintf(stderr,
+          "usage: %s -o FILE [options] NAME=FILE...\n"
+          "  -o, --output FILE    partition image to write\n"
+          "  --bitrate N          opus bitrate for wav input (default: 32000)\n"
+          "  --frame-ms N         opus frame duration for wav input (default: 20)\n"
+          "  --size N             pad the image with 0xFF to the partition size, e.g. 0x40000\n"
+          "NAME is what Engine::PlayEarcon() looks up, at most %zu characters; \"wake\" plays on wake word / button\n"
+          "FILE is a mono 16 bit wav at 8/12/16/24/48 kHz, or an ogg opus file (.opus / .ogg) used as is\n",
+          program,
+          kNameSize - 1);
+}
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  Options options;
+  std::vector<Clip> clips;
+  for (int i = 1; i < argc; i++) {
+    const std::string arg = argv[i];
+    if (arg.size() > 0 && arg[0] != '-') {
+      const auto separator = arg.find('=');
+      if (separator == std::string::npos || separator == 0 || separator >= kNameSize) {
+        Usage(argv[0]);
+        return 2;
+      }
+
+      Clip clip{arg.substr(0, separator), {}};
+      const auto path = arg.substr(separator + 1);
+      const bool ok = EndsWith(path, ".opus") || EndsWith(path, ".ogg") ? LoadOggOpus(path, clip.data) : EncodeWav(path, options, clip.data);
+      if (!ok) {
+        return 1;
+      }
+      clips.push_back(std::move(clip));
+      continue;
+    }
+
+    if (i + 1 >= argc) {
+      Usage(argv[0]);
+      return 2;
+    }
+    const char* value = argv[++i];
+    if (arg == "-o" || arg == "--output") {
+      options.output = value;
+    } else if (arg == "--bitrate") {
+      options.bitrate = atoi(value);
+    } else if (arg == "--frame-ms") {
+      options.frame_duration = atoi(value);
+    } else if (arg == "--size") {
+      options.size = strtoul(value, nullptr, 0);
+    } else {
+      Usage(argv[0]);
+      return 2;
+    }
+  }
+
+  if (options.output.empty() || clips.empty()) {
+    Usage(argv[0]);
+    return 2;
+  }
+
+  std::vector<uint8_t> image(kMagic, kMagic + sizeof(kMagic));
+  AppendU16(image, kVersion);
+  AppendU16(image, clips.size());
+  uint32_t offset = kHeaderSize + kEntrySize * clips.size();
+  for (const auto& clip : clips) {
+    std::vector<uint8_t> name(kNameSize, 0);
+    memcpy(name.data(), clip.name.data(), clip.name.size());
+    image.insert(image.end(), name.begin(), name.end());
+    AppendU32(image, offset);
+    AppendU32(image, clip.data.size());
+    offset += clip.data.size();
+  }
+  for (const auto& clip : clips) {
+    image.insert(image.end(), clip.data.begin(), clip.data.end());
+    fprintf(stderr, "%-23s %8zu bytes\n", clip.name.c_str(), clip.data.size());
+  }
+
+  if (options.size > 0) {
+    if (image.size() > options.size) {
+      fprintf(stderr, "image is %zu bytes, larger than the partition (%zu bytes)\n", image.size(), options.size);
+      return 1;
+    }
+    image.resize(options.size, 0xFF);
+  }
+
+  std::ofstream file(options.output, std::ios::binary);
+  file.write(reinterpret_cast<const char*>(image.data()), image.size());
+  if (!file) {
+    fprintf(stderr, "%s: write failed\n", options.output.c_str());
+    return 1;
+  }
+  fprintf(stderr, "%s: %zu bytes\n", options.output.c_str(), image.size());
+  return 0;
+}
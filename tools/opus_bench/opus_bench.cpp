@@ -0,0 +1,517 @@
+// libopus 编解码基准测试, 使用与设备相同的定点配置 (FIXED_POINT, DISABLE_FLOAT_API)
+// 编码 16 kHz VOIP, 解码 24 kHz, 与 AudioInputEngine / AudioOutputEngine 一致
+
+#include <pthread.h>
+#include <time.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <sstream>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "opus.h"
+
+namespace {
+constexpr int kEncodeSampleRate = 16000;
+constexpr int kDecodeSampleRate = 24000;
+constexpr size_t kMaxPacketSize = 1500;
+constexpr size_t kStackSize = 1 << 20;
+constexpr uint8_t kStackPattern = 0xA5;
+
+// 取自 libopus/src/opus_private.h, 与 AudioInputEngine 的低功耗模式一致
+constexpr int kOpusSetForceModeRequest = 11002;
+constexpr int kOpusModeSilkOnly = 1000;
+
+struct Options {
+  std::string input;
+  double seconds = 10;
+  std::vector<int> complexities = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10};
+  std::vector<int> bitrates = {OPUS_AUTO, 8000, 16000, 24000};
+  std::vector<int> frame_durations = {20, 40, 60};
+  std::vector<int> dtx = {0, 1};
+  std::vector<int> fec = {0, 1};
+  std::string output;
+  std::string compare;
+  double tolerance = 0.25;
+  int repeat = 3;
+  int low_power_bandwidth = 0;  // 非 0 时按 EncoderConfig::Mode::kLowPower 配置编码器
+};
+
+struct Config {
+  int complexity;
+  int bitrate;
+  int frame_duration;
+  int dtx;
+  int fec;
+
+  bool operator<(const Config& other) const {
+    return std::tie(complexity, bitrate, frame_duration, dtx, fec) <
+           std::tie(other.complexity, other.bitrate, other.frame_duration, other.dtx, other.fec);
+  }
+};
+
+struct Result {
+  Config config;
+  double encode_us = 0;       // 每帧平均编码耗时
+  double decode_us = 0;       // 每帧平均解码耗时
+  double rtf = 0;             // (编码 + 解码耗时) / 音频时长
+  double bytes_per_frame = 0;
+  size_t encode_stack = 0;    // 编码峰值栈, 字节
+  size_t decode_stack = 0;    // 解码峰值栈, 字节
+  int encoder_state = 0;      // opus_encoder_get_size, 即编码器全部堆内存
+  int decoder_state = 0;      // opus_decoder_get_size
+  uint32_t checksum = 0;      // 码流和解码输出的 FNV-1a, 用于确认优化前后逐位一致
+  bool has_checksum = true;   // 没有 checksum 列的基线不比较校验和
+};
+
+std::vector<int> ParseList(const char* text) {
+  std::vector<int> values;
+  std::stringstream stream(text);
+  std::string item;
+  while (std::getline(stream, item, ',')) {
+    values.push_back(item == "auto" ? OPUS_AUTO : std::stoi(item));
+  }
+  return values;
+}
+
+uint32_t Fnv1a(uint32_t hash, const void* data, const size_t size) {
+  const auto* bytes = reinterpret_cast<const uint8_t*>(data);
+  for (size_t i = 0; i < size; i++) {
+    hash = (hash ^ bytes[i]) * 16777619u;
+  }
+  return hash;
+}
+
+// 线程 CPU 时间, 不受其他进程抢占的影响
+double ThreadCpuSeconds() {
+  timespec now;
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now);
+  return now.tv_sec + now.tv_nsec * 1e-9;
+}
+
+std::string BitrateName(const int bitrate) {
+  return bitrate == OPUS_AUTO ? "auto" : std::to_string(bitrate);
+}
+
+// 16 kHz 单声道 16 bit PCM WAV
+bool LoadWav(const std::string& path, std::vector<int16_t>& pcm) {
+  std::ifstream file(path, std::ios::binary);
+  char riff[12];
+  if (!file.read(riff, sizeof(riff)) || memcmp(riff, "RIFF", 4) != 0 || memcmp(riff + 8, "WAVE", 4) != 0) {
+    fprintf(stderr, "%s: not a wav file\n", path.c_str());
+    return false;
+  }
+
+  char id[4];
+  uint32_t size = 0;
+  while (file.read(id, sizeof(id)) && file.read(reinterpret_cast<char*>(&size), sizeof(size))) {
+    if (memcmp(id, "fmt ", 4) == 0) {
+      std::vector<uint8_t> fmt(size);
+      file.read(reinterpret_cast<char*>(fmt.data()), size);
+      const uint16_t channels = fmt[2] | fmt[3] << 8;
+      const uint32_t sample_rate = fmt[4] | fmt[5] << 8 | fmt[6] << 16 | fmt[7] << 24;
+      const uint16_t bits = fmt[14] | fmt[15] << 8;
+      if (channels != 1 || sample_rate != kEncodeSampleRate || bits != 16) {
+        fprintf(stderr, "%s: need 16 kHz mono 16 bit, got %u ch %u Hz %u bit\n", path.c_str(), channels, sample_rate, bits);
+        return false;
+      }
+    } else if (memcmp(id, "data", 4) == 0) {
+      pcm.resize(size / sizeof(int16_t));
+      file.read(reinterpret_cast<char*>(pcm.data()), pcm.size() * sizeof(int16_t));
+      return true;
+    } else {
+      file.seekg(size + (size & 1), std::ios::cur);
+    }
+  }
+  return false;
+}
+
+// 没有语料时合成类语音信号: 基频滑动的脉冲串经过两个共振峰, 中间夹杂静音段以覆盖 DTX
+std::vector<int16_t> SynthesizeSpeech(const double seconds) {
+  std::vector<int16_t> pcm(static_cast<size_t>(seconds * kEncodeSampleRate));
+  uint32_t seed = 1;
+  auto noise = [&seed]() {
+    seed = seed * 1664525 + 1013904223;
+    return static_cast<int32_t>(seed >> 16) - 32768;
+  };
+
+  double phase = 0;
+  double y1[2] = {0, 0}, y2[2] = {0, 0};
+  for (size_t i = 0; i < pcm.size(); i++) {
+    const double t = static_cast<double>(i) / kEncodeSampleRate;
+    const double segment = fmod(t, 1.7);
+    if (segment >= 1.2) {
+      pcm[i] = static_cast<int16_t>(noise() / 512);
+      continue;
+    }
+
+    const double f0 = 120 + 60 * sin(2 * M_PI * 0.7 * t);
+    phase += f0 / kEncodeSampleRate;
+    double x = 0;
+    if (phase >= 1) {
+      phase -= 1;
+      x = 8000;
+    }
+    x += noise() / 64.0;
+
+    const double formants[2] = {500 + 200 * sin(2 * M_PI * 1.3 * t), 1500 + 400 * sin(2 * M_PI * 0.9 * t)};
+    double out = 0;
+    for (int k = 0; k < 2; k++) {
+      const double r = 0.97;
+      const double a1 = 2 * r * cos(2 * M_PI * formants[k] / kEncodeSampleRate);
+      const double y = x + a1 * y1[k] - r * r * y2[k];
+      y2[k] = y1[k];
+      y1[k] = y;
+      out += y;
+    }
+    pcm[i] = static_cast<int16_t>(std::clamp(out * 0.05 * sin(M_PI * segment / 1.2), -32768.0, 32767.0));
+  }
+  return pcm;
+}
+
+// 在预先填充固定字节的独立线程栈上运行, 结束后扫描未被改写的区域得到峰值栈
+size_t RunWithStackProbe(const std::function<void()>& job) {
+  void* stack = nullptr;
+  if (posix_memalign(&stack, 4096, kStackSize) != 0) {
+    abort();
+  }
+  memset(stack, kStackPattern, kStackSize);
+
+  pthread_attr_t attr;
+  pthread_attr_init(&attr);
+  pthread_attr_setstack(&attr, stack, kStackSize);
+  pthread_t thread;
+  auto context = job;
+  pthread_create(
+      &thread,
+      &attr,
+      [](void* arg) -> void* {
+        (*reinterpret_cast<std::function<void()>*>(arg))();
+        return nullptr;
+      },
+      &context);
+  pthread_join(thread, nullptr);
+  pthread_attr_destroy(&attr);
+
+  const auto* bytes = reinterpret_cast<const uint8_t*>(stack);
+  size_t untouched = 0;
+  while (untouched < kStackSize && bytes[untouched] == kStackPattern) {
+    untouched++;
+  }
+  free(stack);
+  return kStackSize - untouched;
+}
+
+Result Run(const Config& config, const std::vector<int16_t>& pcm, const Options& options, const size_t thread_overhead) {
+  const int repeat = options.repeat;
+  Result result;
+  result.config = config;
+  result.encoder_state = opus_encoder_get_size(1);
+  result.decoder_state = opus_decoder_get_size(1);
+
+  const int encode_frame_size = kEncodeSampleRate / 1000 * config.frame_duration;
+  const int decode_frame_size = kDecodeSampleRate / 1000 * config.frame_duration;
+  const size_t frames = pcm.size() / encode_frame_size;
+  std::vector<std::vector<uint8_t>> packets(frames);
+  // 多次运行取最快的一次, 减少主机调度带来的抖动
+  double encode_seconds = HUGE_VAL;
+  double decode_seconds = HUGE_VAL;
+  uint32_t checksum = 2166136261u;
+
+  result.encode_stack = RunWithStackProbe([&]() {
+    int error = 0;
+    auto* encoder = opus_encoder_create(kEncodeSampleRate, 1, OPUS_APPLICATION_VOIP, &error);
+    opus_encoder_ctl(encoder, OPUS_SET_COMPLEXITY(config.complexity));
+    opus_encoder_ctl(encoder, OPUS_SET_BITRATE(config.bitrate));
+    opus_encoder_ctl(encoder, OPUS_SET_DTX(config.dtx));
+    opus_encoder_ctl(encoder, OPUS_SET_INBAND_FEC(config.fec));
+    opus_encoder_ctl(encoder, OPUS_SET_PACKET_LOSS_PERC(config.fec ? 10 : 0));
+    if (options.low_power_bandwidth != 0) {
+      opus_encoder_ctl(encoder, OPUS_SET_SIGNAL(OPUS_SIGNAL_VOICE));
+      opus_encoder_ctl(encoder, OPUS_SET_BANDWIDTH(options.low_power_bandwidth));
+      opus_encoder_ctl(encoder, kOpusSetForceModeRequest, kOpusModeSilkOnly);
+    }
+    uint8_t packet[kMaxPacketSize];
+    for (int r = 0; r < repeat; r++) {
+      opus_encoder_ctl(encoder, OPUS_RESET_STATE);
+      const auto start = ThreadCpuSeconds();
+      for (size_t i = 0; i < frames; i++) {
+        const auto length = opus_encode(encoder, pcm.data() + i * encode_frame_size, encode_frame_size, packet, sizeof(packet));
+        if (r == 0 && length > 0) {
+          packets[i].assign(packet, packet + length);
+        }
+      }
+      encode_seconds = std::min(encode_seconds, ThreadCpuSeconds() - start);
+    }
+    opus_encoder_destroy(encoder);
+  });
+
+  result.decode_stack = RunWithStackProbe([&]() {
+    int error = 0;
+    auto* decoder = opus_decoder_create(kDecodeSampleRate, 1, &error);
+    std::vector<int16_t> out(decode_frame_size);
+    for (int r = 0; r < repeat; r++) {
+      opus_decoder_ctl(decoder, OPUS_RESET_STATE);
+      const auto start = ThreadCpuSeconds();
+      for (const auto& packet : packets) {
+        // 编码失败的帧按丢包处理
+        const auto samples = opus_decode(decoder, packet.empty() ? nullptr : packet.data(), packet.size(), out.data(), decode_frame_size, 0);
+        if (r == 0) {
+          checksum = Fnv1a(checksum, packet.data(), packet.size());
+          checksum = Fnv1a(checksum, out.data(), std::max(samples, 0) * sizeof(int16_t));
+        }
+      }
+      decode_seconds = std::min(decode_seconds, ThreadCpuSeconds() - start);
+    }
+    opus_decoder_destroy(decoder);
+  });
+
+  size_t total_bytes = 0;
+  for (const auto& packet : packets) {
+    total_bytes += packet.size();
+  }
+
+  result.encode_stack -= std::min(result.encode_stack, thread_overhead);
+  result.decode_stack -= std::min(result.decode_stack, thread_overhead);
+  result.encode_us = encode_seconds * 1e6 / frames;
+  result.decode_us = decode_seconds * 1e6 / frames;
+  result.rtf = (encode_seconds + decode_seconds) / (static_cast<double>(frames * encode_frame_size) / kEncodeSampleRate);
+  result.bytes_per_frame = static_cast<double>(total_bytes) / frames;
+  result.checksum = checksum;
+  return result;
+}
+
+constexpr char kCsvHeader[] =
+    "complexity,bitrate,frame_ms,dtx,fec,encode_us,decode_us,rtf,bytes_per_frame,encode_stack,decode_stack,encoder_state,decoder_state,checksum";
+
+std::string ToCsv(const Result& result) {
+  char line[256];
+  snprintf(line,
+           sizeof(line),
+           "%d,%s,%d,%d,%d,%.2f,%.2f,%.5f,%.2f,%zu,%zu,%d,%d,%08x",
+           result.config.complexity,
+           BitrateName(result.config.bitrate).c_str(),
+           result.config.frame_duration,
+           result.config.dtx,
+           result.config.fec,
+           result.encode_us,
+           result.decode_us,
+           result.rtf,
+           result.bytes_per_frame,
+           result.encode_stack,
+           result.decode_stack,
+           result.encoder_state,
+           result.decoder_state,
+           result.checksum);
+  return line;
+}
+
+bool LoadBaseline(const std::string& path, std::map<Config, Result>& baseline) {
+  std::ifstream file(path);
+  if (!file) {
+    fprintf(stderr, "failed to open %s\n", path.c_str());
+    return false;
+  }
+
+  std::string line;
+  while (std::getline(file, line)) {
+    if (line.empty() || line[0] == '#' || line.rfind("complexity", 0) == 0) {
+      continue;
+    }
+    Result result;
+    char bitrate[16] = {0};
+    const auto fields = sscanf(line.c_str(),
+                               "%d,%15[^,],%d,%d,%d,%lf,%lf,%lf,%lf,%zu,%zu,%d,%d,%x",
+                               &result.config.complexity,
+                               bitrate,
+                               &result.config.frame_duration,
+                               &result.config.dtx,
+                               &result.config.fec,
+                               &result.encode_us,
+                               &result.decode_us,
+                               &result.rtf,
+                               &result.bytes_per_frame,
+                               &result.encode_stack,
+                               &result.decode_stack,
+                               &result.encoder_state,
+                               &result.decoder_state,
+                               &result.checksum);
+    if (fields < 13) {
+      continue;
+    }
+    result.has_checksum = fields == 14;
+    result.config.bitrate = strcmp(bitrate, "auto") == 0 ? OPUS_AUTO : atoi(bitrate);
+    baseline[result.config] = result;
+  }
+  return true;
+}
+
+// 码流校验和, 栈和状态大小与主机性能无关, 必须与基线一致 (栈允许少量余量); 耗时允许 tolerance 的波动
+int Compare(const std::vector<Result>& results, const std::map<Config, Result>& baseline, const double tolerance) {
+  int regressions = 0;
+  for (const auto& result : results) {
+    const auto it = baseline.find(result.config);
+    if (it == baseline.end()) {
+      continue;
+    }
+    const auto& base = it->second;
+    char name[64];
+    snprintf(name,
+             sizeof(name),
+             "c%d %s %dms dtx%d fec%d",
+             result.config.complexity,
+             BitrateName(result.config.bitrate).c_str(),
+             result.config.frame_duration,
+             result.config.dtx,
+             result.config.fec);
+    auto check = [&](const char* metric, const double value, const double limit, const double reference) {
+      if (value > limit) {
+        printf("REGRESSION [%s] %s: %.2f > %.2f (baseline %.2f)\n", name, metric, value, limit, reference);
+        regressions++;
+      }
+    };
+    check("encode_us", result.encode_us, base.encode_us * (1 + tolerance), base.encode_us);
+    check("decode_us", result.decode_us, base.decode_us * (1 + tolerance), base.decode_us);
+    check("encode_stack", result.encode_stack, base.encode_stack * 1.05 + 64, base.encode_stack);
+    check("decode_stack", result.decode_stack, base.decode_stack * 1.05 + 64, base.decode_stack);
+    check("encoder_state", result.encoder_state, base.encoder_state, base.encoder_state);
+    check("decoder_state", result.decoder_state, base.decoder_state, base.decoder_state);
+    if (base.has_checksum && result.checksum != base.checksum) {
+      printf("REGRESSION [%s] checksum: %08x (baseline %08x), output is not bit-exact\n", name, result.checksum, base.checksum);
+      regressions++;
+    }
+  }
+  return regressions;
+}
+
+void Usage(const char* program) {
+  fprintf(stderr,
+          "usage: %s [options]\n"
+          "  --quick              small sweep around the device defaults\n"
+          "  --low-power BW       force SILK-only voice at nb, mb or wb, like EncoderConfig::Mode::kLowPower\n"
+          "  --input FILE         16 kHz mono 16 bit wav corpus (default: synthesized speech)\n"
+          "  --seconds N          length of the synthesized corpus (default: 10)\n"
+          "  --complexity LIST    e.g. 0,5,10 (default: 0..10)\n"
+          "  --bitrate LIST       e.g. auto,8000,16000 (default: auto,8000,16000,24000)\n"
+          "  --frame-ms LIST      e.g. 20,60 (default: 20,40,60)\n"
+          "  --dtx LIST           e.g. 1 (default: 0,1)\n"
+          "  --fec LIST           e.g. 0 (default: 0,1)\n"
+          "  --repeat N           run each config N times and keep the fastest (default: 3)\n"
+          "  --output FILE        write results as csv, e.g. to refresh the baseline\n"
+          "  --compare FILE       compare with a baseline csv, exit 1 on regression\n"
+          "  --tolerance X        allowed relative slowdown for --compare (default: 0.25)\n",
+          program);
+}
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  Options options;
+  for (int i = 1; i < argc; i++) {
+    const std::string arg = argv[i];
+    if (arg == "--quick") {
+      // 设备默认配置附近的少量组合, 用于日常回归检查
+      options.complexities = {0, 5};
+      options.bitrates = {OPUS_AUTO, 8000};
+      options.frame_durations = {60};
+      options.fec = {0};
+      continue;
+    }
+    if (i + 1 >= argc) {
+      Usage(argv[0]);
+      return 2;
+    }
+    const char* value = argv[++i];
+    if (arg == "--input") {
+      options.input = value;
+    } else if (arg == "--seconds") {
+      options.seconds = atof(value);
+    } else if (arg == "--complexity") {
+      options.complexities = ParseList(value);
+    } else if (arg == "--bitrate") {
+      options.bitrates = ParseList(value);
+    } else if (arg == "--frame-ms") {
+      options.frame_durations = ParseList(value);
+    } else if (arg == "--dtx") {
+      options.dtx = ParseList(value);
+    } else if (arg == "--fec") {
+      options.fec = ParseList(value);
+    } else if (arg == "--repeat") {
+      options.repeat = std::max(1, atoi(value));
+    } else if (arg == "--low-power") {
+      const std::map<std::string, int> bandwidths = {
+          {"nb", OPUS_BANDWIDTH_NARROWBAND}, {"mb", OPUS_BANDWIDTH_MEDIUMBAND}, {"wb", OPUS_BANDWIDTH_WIDEBAND}};
+      const auto it = bandwidths.find(value);
+      if (it == bandwidths.end()) {
+        Usage(argv[0]);
+        return 2;
+      }
+      options.low_power_bandwidth = it->second;
+    } else if (arg == "--output") {
+      options.output = value;
+    } else if (arg == "--compare") {
+      options.compare = value;
+    } else if (arg == "--tolerance") {
+      options.tolerance = atof(value);
+    } else {
+      Usage(argv[0]);
+      return 2;
+    }
+  }
+
+  std::vector<int16_t> pcm;
+  if (options.input.empty()) {
+    pcm = SynthesizeSpeech(options.seconds);
+  } else if (!LoadWav(options.input, pcm)) {
+    return 1;
+  }
+
+  const auto thread_overhead = RunWithStackProbe([]() {});
+  fprintf(stderr, "%s, corpus %.1f s\n", opus_get_version_string(), static_cast<double>(pcm.size()) / kEncodeSampleRate);
+
+  std::vector<Result> results;
+  printf("%s\n", kCsvHeader);
+  for (const auto complexity : options.complexities) {
+    for (const auto bitrate : options.bitrates) {
+      for (const auto frame_duration : options.frame_durations) {
+        for (const auto dtx : options.dtx) {
+          for (const auto fec : options.fec) {
+            results.push_back(Run({complexity, bitrate, frame_duration, dtx, fec}, pcm, options, thread_overhead));
+            printf("%s\n", ToCsv(results.back()).c_str());
+            fflush(stdout);
+          }
+        }
+      }
+    }
+  }
+
+  if (!options.output.empty()) {
+    std::ofstream file(options.output);
+    file << "# " << opus_get_version_string() << ", FIXED_POINT, DISABLE_FLOAT_API, encode 16 kHz VOIP"
+         << (options.low_power_bandwidth != 0 ? " low power (SILK-only)" : "") << ", decode 24 kHz\n";
+    file << "# timings are host specific, stack/state sizes, bytes_per_frame and checksum are portable\n";
+    file << kCsvHeader << "\n";
+    for (const auto& result : results) {
+      file << ToCsv(result) << "\n";
+    }
+  }
+
+  if (!options.compare.empty()) {
+    std::map<Config, Result> baseline;
+    if (!LoadBaseline(options.compare, baseline)) {
+      return 1;
+    }
+    const auto regressions = Compare(results, baseline, options.tolerance);
+    printf("%d regression(s) against %s\n", regressions, options.compare.c_str());
+    return regressions > 0 ? 1 : 0;
+  }
+  return 0;
+}
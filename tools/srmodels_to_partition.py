@@ -0,0 +1,113 @@
+#!/usr/bin/env python3
+"""Build an image for the `model` partition from the embedded WakeNet models and esp-sr model directories.
+
+src/core/wake_net/srmodels.bin is the esp-sr model blob written out as a C
+array. WakeNet maps the `model` data partition with esp_srmodel_init() and only
+falls back to the embedded copy when the partition is missing, so once the
+partition is flashed the firmware can be built with
+-DAI_VOX_WAKE_NET_EMBEDDED_MODEL=0 and the model leaves the app image and OTA:
+
+    python3 tools/srmodels_to_partition.py -o srmodels.partition.bin
+    esptool.py write_flash 0x500000 srmodels.partition.bin
+
+Offline commands (Engine::ConfigOfflineCommands) need a MultiNet model, which
+is never embedded. Add one or more model directories from an esp-sr checkout;
+they are packed next to the embedded models in the layout of esp-sr's
+pack_model.py, and a directory with the name of an embedded model replaces it:
+
+    python3 tools/srmodels_to_partition.py -o srmodels.partition.bin --size 0x600000 \\
+        --model esp-sr/model/multinet_model/mn5q8_cn
+
+The offset and size are the `model` line of the example partitions.csv files.
+"""
+
+import argparse
+import os
+import re
+import struct
+import sys
+
+DEFAULT_INPUT = os.path.join(os.path.dirname(__file__), "..", "src", "core", "wake_net", "srmodels.bin")
+NAME_SIZE = 32
+
+
+def parse_blob(data):
+    """Split a packed blob into [(model name, [(file name, bytes)])]."""
+    models = []
+    count = struct.unpack_from("<I", data, 0)[0]
+    offset = 4
+    for _ in range(count):
+        name = data[offset : offset + NAME_SIZE].split(b"\0")[0].decode()
+        file_count = struct.unpack_from("<I", data, offset + NAME_SIZE)[0]
+        offset += NAME_SIZE + 4
+        files = []
+        for _ in range(file_count):
+            file_name = data[offset : offset + NAME_SIZE].split(b"\0")[0].decode()
+            start, length = struct.unpack_from("<II", data, offset + NAME_SIZE)
+            offset += NAME_SIZE + 8
+            files.append((file_name, data[start : start + length]))
+        models.append((name, files))
+    return models
+
+
+def load_model_dir(path):
+    """Read an esp-sr model directory, e.g. model/multinet_model/mn5q8_cn."""
+    path = os.path.normpath(path)
+    if not os.path.isfile(os.path.join(path, "_MODEL_INFO_")):
+        sys.exit(f"{path}: not an esp-sr model directory, _MODEL_INFO_ is missing")
+    files = []
+    for file_name in sorted(os.listdir(path)):
+        file_path = os.path.join(path, file_name)
+        if not os.path.isfile(file_path):
+            continue
+        if len(file_name.encode()) >= NAME_SIZE:
+            sys.exit(f"{file_path}: name longer than {NAME_SIZE - 1} bytes")
+        with open(file_path, "rb") as file:
+            files.append((file_name, file.read()))
+    return os.path.basename(path), files
+
+
+def pack_blob(models):
+    """Same layout as esp-sr pack_model.py: count, model infos with file offsets, then the file data back to back."""
+    file_count = sum(len(files) for _, files in models)
+    start = 4 + len(models) * (NAME_SIZE + 4) + file_count * (NAME_SIZE + 8)
+    header = struct.pack("<I", len(models))
+    body = bytearray()
+    for name, files in models:
+        header += name.encode().ljust(NAME_SIZE, b"\0") + struct.pack("<I", len(files))
+        for file_name, content in files:
+            header += file_name.encode().ljust(NAME_SIZE, b"\0") + struct.pack("<II", start + len(body), len(content))
+            body += content
+    return header + bytes(body)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("input", nargs="?", default=DEFAULT_INPUT, help="C array of the model blob")
+    parser.add_argument("-o", "--output", required=True, help="partition image to write")
+    parser.add_argument("--size", type=lambda value: int(value, 0), default=0, help="check the image fits, e.g. 0x600000")
+    parser.add_argument("--model", action="append", default=[], help="esp-sr model directory to add, may be repeated")
+    args = parser.parse_args()
+
+    with open(args.input, "r") as file:
+        data = bytes(int(value, 16) for value in re.findall(r"0x([0-9a-fA-F]{2})", file.read()))
+
+    if args.model:
+        models = parse_blob(data)
+        for path in args.model:
+            name, files = load_model_dir(path)
+            models = [model for model in models if model[0] != name] + [(name, files)]
+        data = pack_blob(models)
+        for name, files in models:
+            print(f"  {name}: {sum(len(content) for _, content in files)} bytes")
+
+    if args.size and len(data) > args.size:
+        sys.exit(f"image is {len(data)} bytes, larger than the partition ({args.size} bytes)")
+
+    with open(args.output, "wb") as file:
+        file.write(data)
+    print(f"{args.output}: {len(data)} bytes")
+
+
+if __name__ == "__main__":
+    main()
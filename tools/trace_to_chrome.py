@@ -0,0 +1,91 @@
+#!/usr/bin/env python3
+"""Convert an ai_vox trace dump captured from the serial console to Chrome/Perfetto JSON.
+
+Build the firmware with -D AI_VOX_TRACE=1, call ai_vox::Engine::DumpTrace() and save the
+serial log, then:
+
+    python3 tools/trace_to_chrome.py serial.log -o trace.json
+
+Open trace.json in chrome://tracing or https://ui.perfetto.dev.
+"""
+
+import argparse
+import json
+import struct
+import sys
+
+RECORD_FORMAT = "<qIHBBII"
+PHASES = {0: "B", 1: "E", 2: "i"}
+
+
+def parse(lines):
+    events = {}
+    tasks = {}
+    records = []
+    in_dump = False
+    for line in lines:
+        index = line.find("[trace] ")
+        if index < 0:
+            continue
+        fields = line[index + len("[trace] "):].strip().split(" ", 2)
+        kind = fields[0]
+        if kind == "begin":
+            if struct.calcsize(RECORD_FORMAT) != int(fields[1]):
+                sys.exit("record size mismatch: firmware %s, script %d" % (fields[1], struct.calcsize(RECORD_FORMAT)))
+            events, tasks, records, in_dump = {}, {}, [], True
+        elif not in_dump:
+            continue
+        elif kind == "event":
+            events[int(fields[1])] = fields[2]
+        elif kind == "task":
+            tasks[int(fields[1], 16)] = fields[2] if len(fields) > 2 else fields[1]
+        elif kind == "record":
+            records.append(struct.unpack(RECORD_FORMAT, bytes.fromhex(fields[1])))
+        elif kind == "end":
+            in_dump = False
+    return events, tasks, records
+
+
+def convert(events, tasks, records):
+    trace_events = []
+    seen_tasks = set()
+    for timestamp_us, task, event, phase, core, arg0, arg1 in sorted(records, key=lambda record: record[0]):
+        seen_tasks.add(task)
+        trace_event = {
+            "name": events.get(event, "event %d" % event),
+            "ph": PHASES.get(phase, "i"),
+            "ts": timestamp_us,
+            "pid": 0,
+            "tid": task,
+        }
+        if phase != 1:
+            trace_event["args"] = {"core": core, "arg0": arg0, "arg1": arg1}
+        if phase == 2:
+            trace_event["s"] = "t"
+        trace_events.append(trace_event)
+
+    trace_events.append({"name": "process_name", "ph": "M", "pid": 0, "args": {"name": "ai_vox"}})
+    for task in seen_tasks:
+        name = tasks.get(task, "task %08x" % task)
+        trace_events.append({"name": "thread_name", "ph": "M", "pid": 0, "tid": task, "args": {"name": name}})
+    return {"traceEvents": trace_events, "displayTimeUnit": "ms"}
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("input", help="serial log containing a [trace] dump, '-' for stdin")
+    parser.add_argument("-o", "--output", default="-", help="output JSON file, '-' for stdout")
+    args = parser.parse_args()
+
+    with (sys.stdin if args.input == "-" else open(args.input, errors="replace")) as f:
+        events, tasks, records = parse(f)
+    if not records:
+        sys.exit("no trace records found")
+
+    result = convert(events, tasks, records)
+    with (sys.stdout if args.output == "-" else open(args.output, "w")) as f:
+        json.dump(result, f)
+
+
+if __name__ == "__main__":
+    main()
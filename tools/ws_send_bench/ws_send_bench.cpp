@@ -0,0 +1,320 @@
+// websocket 上行发送路径基准测试
+// 对比 esp_websocket_client_send_with_opcode (经 transport_ws, 帧头和负载分两次写出, 负载原地掩码后再还原)
+// 与 esp_websocket_client_send_frame (esp_websocket_frame_build 一次构造整帧, 一次写出)
+// 经 socketpair 发送, 接收线程解析并去掩码校验每一帧; 线上字节按 TLS 1.2 AES-GCM 每条记录 29 字节, TCP/IP 每段 40 字节估算
+
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "esp_websocket_frame.h"
+
+namespace {
+constexpr uint8_t kOpcodeBinary = 0x02;
+constexpr uint8_t kOpcodeFin = 0x80;
+constexpr size_t kTlsRecordOverhead = 29;  // 5 字节记录头 + 8 字节显式 nonce + 16 字节 tag
+constexpr size_t kTcpIpOverhead = 40;      // 不含选项的 IPv4 + TCP 头
+constexpr size_t kMss = 1460;
+
+struct Options {
+  std::vector<size_t> sizes = {120, 240, 1024, 4096};
+  uint32_t frames = 20000;
+  size_t buffer_size = 1024;  // WEBSOCKET_BUFFER_SIZE_BYTE, 引擎使用默认值
+  bool dynamic_buffer = false;
+};
+
+struct Counters {
+  uint64_t writes = 0;
+  uint64_t ws_bytes = 0;
+  uint64_t wire_bytes = 0;
+};
+
+struct Result {
+  Counters counters;
+  double ns_per_frame = 0;
+  uint32_t received = 0;
+  uint32_t mismatches = 0;
+};
+
+uint64_t NowNs() {
+  timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return static_cast<uint64_t>(ts.tv_sec) * 1000000000ull + ts.tv_nsec;
+}
+
+uint32_t NextRandom(uint32_t& state) {
+  state ^= state << 13;
+  state ^= state >> 17;
+  state ^= state << 5;
+  return state;
+}
+
+// 对应 esp_transport_write, 每次调用在 TLS 下是一条记录, 开启 TCP_NODELAY 时至少一个 TCP 段
+bool Write(const int fd, const uint8_t* data, const size_t len, Counters& counters) {
+  counters.writes++;
+  counters.ws_bytes += len;
+  counters.wire_bytes += len + kTlsRecordOverhead + ((len + kTlsRecordOverhead + kMss - 1) / kMss) * kTcpIpOverhead;
+  size_t written = 0;
+  while (written < len) {
+    const auto ret = write(fd, data + written, len - written);
+    if (ret < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return false;
+    }
+    written += ret;
+  }
+  return true;
+}
+
+size_t WriteHeader(uint8_t* header, const uint8_t opcode, const size_t len, const uint8_t mask_key[4]) {
+  size_t header_len = 0;
+  header[header_len++] = opcode;
+  if (len <= 125) {
+    header[header_len++] = static_cast<uint8_t>(len | 0x80);
+  } else if (len <= 0xFFFF) {
+    header[header_len++] = 126 | 0x80;
+    header[header_len++] = static_cast<uint8_t>(len >> 8);
+    header[header_len++] = static_cast<uint8_t>(len);
+  } else {
+    header[header_len++] = 127 | 0x80;
+    for (int shift = 56; shift >= 0; shift -= 8) {
+      header[header_len++] = static_cast<uint8_t>(static_cast<uint64_t>(len) >> shift);
+    }
+  }
+  memcpy(header + header_len, mask_key, 4);
+  return header_len + 4;
+}
+
+// esp_websocket_client_send_with_exact_opcode + transport_ws 的 _ws_write
+bool SendLegacy(const int fd, const Options& options, std::vector<uint8_t>& tx_buffer, const uint8_t* data, const size_t len,
+                uint32_t& random, Counters& counters) {
+  if (options.dynamic_buffer) {
+    tx_buffer.assign(options.buffer_size, 0);
+  }
+  uint8_t opcode = kOpcodeBinary;
+  size_t widx = 0;
+  while (widx < len || opcode) {
+    size_t need_write = len - widx;
+    if (need_write > options.buffer_size) {
+      need_write = options.buffer_size;
+      opcode &= ~kOpcodeFin;
+    } else {
+      opcode |= kOpcodeFin;
+    }
+    memcpy(tx_buffer.data(), data + widx, need_write);
+
+    uint8_t header[ESP_WEBSOCKET_FRAME_MAX_HEADER_LEN];
+    const auto mask = NextRandom(random);
+    uint8_t mask_key[4];
+    memcpy(mask_key, &mask, sizeof(mask_key));
+    const auto header_len = WriteHeader(header, opcode, need_write, mask_key);
+    if (!Write(fd, header, header_len, counters)) {
+      return false;
+    }
+    for (size_t i = 0; i < need_write; i++) {
+      tx_buffer[i] ^= mask_key[i % 4];
+    }
+    const bool ok = need_write == 0 || Write(fd, tx_buffer.data(), need_write, counters);
+    for (size_t i = 0; i < need_write; i++) {
+      tx_buffer[i] ^= mask_key[i % 4];
+    }
+    if (!ok) {
+      return false;
+    }
+    opcode = 0;
+    widx += need_write;
+  }
+  if (options.dynamic_buffer) {
+    std::vector<uint8_t>().swap(tx_buffer);
+  }
+  return true;
+}
+
+// esp_websocket_client_send_single_write, frame_buffer 在首次发送时分配并一直保留
+// 超过 buffer_size 的负载退回分片发送
+bool SendSingleWrite(const int fd, const Options& options, std::vector<uint8_t>& frame_buffer, std::vector<uint8_t>& tx_buffer,
+                     const uint8_t* data, const size_t len, uint32_t& random, Counters& counters) {
+  if (len > options.buffer_size) {
+    return SendLegacy(fd, options, tx_buffer, data, len, random, counters);
+  }
+  if (frame_buffer.size() < options.buffer_size + ESP_WEBSOCKET_FRAME_MAX_HEADER_LEN) {
+    frame_buffer.resize(options.buffer_size + ESP_WEBSOCKET_FRAME_MAX_HEADER_LEN);
+  }
+  const auto mask = NextRandom(random);
+  uint8_t mask_key[4];
+  memcpy(mask_key, &mask, sizeof(mask_key));
+  const auto frame_len =
+      esp_websocket_frame_build(frame_buffer.data(), frame_buffer.size(), kOpcodeBinary | kOpcodeFin, data, len, mask_key);
+  return frame_len != 0 && Write(fd, frame_buffer.data(), frame_len, counters);
+}
+
+bool ReadExact(const int fd, uint8_t* data, size_t len) {
+  while (len > 0) {
+    const auto ret = read(fd, data, len);
+    if (ret <= 0) {
+      if (ret < 0 && errno == EINTR) {
+        continue;
+      }
+      return false;
+    }
+    data += ret;
+    len -= ret;
+  }
+  return true;
+}
+
+// 服务端视角: 解析帧头, 去掩码, 按 FIN 拼接消息并与发送的负载比较
+void Receive(const int fd, const std::vector<uint8_t>& expected, uint32_t& received, uint32_t& mismatches) {
+  std::vector<uint8_t> message;
+  std::vector<uint8_t> payload;
+  uint8_t header[2];
+  while (ReadExact(fd, header, sizeof(header))) {
+    uint64_t len = header[1] & 0x7F;
+    if (len == 126 || len == 127) {
+      uint8_t extended[8];
+      const size_t count = len == 126 ? 2 : 8;
+      if (!ReadExact(fd, extended, count)) {
+        break;
+      }
+      len = 0;
+      for (size_t i = 0; i < count; i++) {
+        len = (len << 8) | extended[i];
+      }
+    }
+    uint8_t mask_key[4] = {};
+    if ((header[1] & 0x80) == 0 || !ReadExact(fd, mask_key, sizeof(mask_key))) {
+      mismatches++;
+      break;
+    }
+    payload.resize(len);
+    if (!ReadExact(fd, payload.data(), len)) {
+      break;
+    }
+    for (size_t i = 0; i < len; i++) {
+      payload[i] ^= mask_key[i % 4];
+    }
+    message.insert(message.end(), payload.begin(), payload.end());
+    if (header[0] & kOpcodeFin) {
+      if (message != expected) {
+        mismatches++;
+      }
+      received++;
+      message.clear();
+    }
+  }
+}
+
+bool Run(const Options& options, const size_t size, const bool single_write, Result& result) {
+  int fds[2];
+  if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) != 0) {
+    perror("socketpair");
+    return false;
+  }
+  const int sndbuf = 1 << 20;
+  setsockopt(fds[0], SOL_SOCKET, SO_SNDBUF, &sndbuf, sizeof(sndbuf));
+
+  std::vector<uint8_t> payload(size);
+  uint32_t random = 0x12345678u + static_cast<uint32_t>(size);
+  for (auto& byte : payload) {
+    byte = static_cast<uint8_t>(NextRandom(random));
+  }
+
+  std::thread receiver(Receive, fds[1], std::cref(payload), std::ref(result.received), std::ref(result.mismatches));
+  std::vector<uint8_t> tx_buffer;
+  std::vector<uint8_t> frame_buffer;
+  if (!options.dynamic_buffer) {
+    tx_buffer.resize(options.buffer_size);
+  }
+  bool ok = true;
+  const auto start = NowNs();
+  for (uint32_t i = 0; i < options.frames && ok; i++) {
+    ok = single_write ? SendSingleWrite(fds[0], options, frame_buffer, tx_buffer, payload.data(), size, random, result.counters)
+                      : SendLegacy(fds[0], options, tx_buffer, payload.data(), size, random, result.counters);
+  }
+  result.ns_per_frame = static_cast<double>(NowNs() - start) / options.frames;
+  shutdown(fds[0], SHUT_WR);
+  receiver.join();
+  close(fds[0]);
+  close(fds[1]);
+  return ok && result.received == options.frames && result.mismatches == 0;
+}
+
+std::vector<size_t> ParseList(const std::string& text) {
+  std::vector<size_t> values;
+  std::stringstream stream(text);
+  std::string item;
+  while (std::getline(stream, item, ',')) {
+    values.push_back(strtoul(item.c_str(), nullptr, 10));
+  }
+  return values;
+}
+
+void Usage(const char* program) {
+  fprintf(stderr,
+          "usage: %s [options]\n"
+          "  --sizes LIST         payload sizes in bytes (default: 120,240,1024,4096)\n"
+          "  --frames N           frames per size and path (default: 20000)\n"
+          "  --buffer-size N      websocket client buffer_size (default: 1024)\n"
+          "  --dynamic-buffer     allocate the tx buffer per send, like CONFIG_ESP_WS_CLIENT_ENABLE_DYNAMIC_BUFFER\n",
+          program);
+}
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  Options options;
+  for (int i = 1; i < argc; i++) {
+    const std::string arg = argv[i];
+    if (arg == "--dynamic-buffer") {
+      options.dynamic_buffer = true;
+      continue;
+    }
+    if (i + 1 >= argc) {
+      Usage(argv[0]);
+      return 2;
+    }
+    const char* value = argv[++i];
+    if (arg == "--sizes") {
+      options.sizes = ParseList(value);
+    } else if (arg == "--frames") {
+      options.frames = std::max(1, atoi(value));
+    } else if (arg == "--buffer-size") {
+      options.buffer_size = std::max(1, atoi(value));
+    } else {
+      Usage(argv[0]);
+      return 2;
+    }
+  }
+
+  printf("buffer_size: %zu, dynamic buffer: %d, frames: %u\n", options.buffer_size, options.dynamic_buffer, options.frames);
+  printf("%8s %-8s %12s %12s %14s %12s\n", "payload", "path", "writes/frm", "ws B/frm", "est wire B/frm", "ns/frm");
+  int failures = 0;
+  for (const auto size : options.sizes) {
+    for (const bool single_write : {false, true}) {
+      Result result;
+      if (!Run(options, size, single_write, result)) {
+        fprintf(stderr, "payload %zu %s: received %u/%u, mismatches %u\n", size, single_write ? "single" : "legacy", result.received,
+                options.frames, result.mismatches);
+        failures++;
+        continue;
+      }
+      const double frames = options.frames;
+      printf("%8zu %-8s %12.2f %12.1f %14.1f %12.0f\n", size, single_write ? "single" : "legacy", result.counters.writes / frames,
+             result.counters.ws_bytes / frames, result.counters.wire_bytes / frames, result.ns_per_frame);
+    }
+  }
+  return failures == 0 ? 0 : 1;
+}